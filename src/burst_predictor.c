@@ -0,0 +1,136 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Averages are kept as whole time units, rounded at every step, so a
+ * trace is always predicted the same way on any platform.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#include "burst_predictor.h"
+
+// Forward decs
+static int class_slot(struct BurstPredictor *const restrict predictor,
+                      const int priority,
+                      const long long guess);
+static long long blend(const int weight,
+                       const long long estimate,
+                       const int burst_time);
+
+void init_burst_predictor(struct BurstPredictor *const restrict predictor,
+                          const struct ProcessEntry *const restrict
+                          process_table,
+                          const int total_processes,
+                          const struct SchedulerParameters *const restrict
+                          parameters) {
+  assert(parameters->prediction_weight > 0);
+
+  // At most half full, even if every process is a class of its own.
+  int capacity = 16;
+
+  while (capacity < total_processes * 2) {
+    capacity *= 2;
+  }
+
+  predictor->weight = parameters->prediction_weight;
+  predictor->class_mask = capacity - 1;
+  predictor->class_priorities = malloc(sizeof(int) * capacity);
+  predictor->class_estimates = malloc(sizeof(long long) * capacity);
+  predictor->process_class = malloc(sizeof(int) * total_processes);
+  predictor->process_estimates = malloc(sizeof(long long) *
+                                        total_processes);
+  assert(predictor->class_priorities != NULL);
+  assert(predictor->class_estimates != NULL);
+  assert(predictor->process_class != NULL);
+  assert(predictor->process_estimates != NULL);
+
+  // An estimate of -1 marks an empty slot.
+  for (int i = 0; i < capacity; i++) {
+    predictor->class_estimates[i] = -1;
+  }
+
+  for (int i = 0; i < total_processes; i++) {
+    predictor->process_class[i] =
+        class_slot(predictor, process_table[i].priority,
+                   parameters->prediction_guess);
+    predictor->process_estimates[i] = -1;
+  }
+}
+
+void destroy_burst_predictor(struct BurstPredictor *const restrict
+                             predictor) {
+  free(predictor->process_estimates);
+  free(predictor->process_class);
+  free(predictor->class_estimates);
+  free(predictor->class_priorities);
+}
+
+long long predict_burst(const struct BurstPredictor *const restrict
+                        predictor,
+                        const int process) {
+  long long result = predictor->process_estimates[process];
+
+  if (result < 0) {
+    result = predictor->class_estimates[predictor->process_class[process]];
+  }
+
+  return result;
+}
+
+void record_burst(struct BurstPredictor *const restrict predictor,
+                  const int process,
+                  const int burst_time) {
+  const int slot = predictor->process_class[process];
+
+  predictor->process_estimates[process] =
+      blend(predictor->weight, predict_burst(predictor, process),
+            burst_time);
+  predictor->class_estimates[slot] =
+      blend(predictor->weight, predictor->class_estimates[slot],
+            burst_time);
+}
+
+/*
+ * class_slot
+ *
+ * Finds the slot for the priority's class, starting a new class with
+ * the guess if it hasn't been seen before.
+ */
+static int class_slot(struct BurstPredictor *const restrict predictor,
+                      const int priority,
+                      const long long guess) {
+  int slot = (int) (((uint32_t) priority * UINT32_C(2654435761)) &
+                    (uint32_t) predictor->class_mask);
+  bool found = false;
+
+  while (!found) {
+    if (predictor->class_estimates[slot] < 0) {
+      predictor->class_priorities[slot] = priority;
+      predictor->class_estimates[slot] = guess;
+      found = true;
+    } else if (predictor->class_priorities[slot] == priority) {
+      found = true;
+    } else {
+      slot = (slot + 1) & predictor->class_mask;
+    }
+  }
+
+  return slot;
+}
+
+/*
+ * blend
+ *
+ * The next exponential average, rounded to the nearest time unit.
+ */
+static long long blend(const int weight,
+                       const long long estimate,
+                       const int burst_time) {
+  return ((long long) weight * burst_time +
+          (long long) (100 - weight) * estimate + 50) / 100;
+}
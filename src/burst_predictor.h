@@ -0,0 +1,87 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Guesses how long a process's next CPU burst will be from the bursts
+ *   seen so far, the way a real scheduler has to, rather than knowing
+ *   it from the trace.
+ */
+
+#ifndef BURST_PREDICTOR_H_
+#define BURST_PREDICTOR_H_
+
+#include "process_entry.h"
+#include "scheduler_parameters.h"
+
+/*
+ * BurstPredictor
+ *
+ * Exponential averages of burst lengths, each new burst counting for
+ * weight percent of the average, and the average so far for the rest.
+ *
+ * Processes with the same priority are taken to be the same class of
+ * job, and a process's first burst is guessed from the average of its
+ * class, which starts at guess. After that, a process doing I/O has an
+ * average of its own, starting from its class's.
+ *
+ * class_priorities - Open addressed table of the priorities seen,
+ *                    class_mask + 1 slots, with the average of each in
+ *                    the same slot of class_estimates.
+ * process_class - Slot of each process's class.
+ * process_estimates - Each process's own average, or -1 if it hasn't
+ *                     finished a burst yet.
+ */
+struct BurstPredictor {
+  int weight;
+
+  int *class_priorities;
+  long long *class_estimates;
+  int class_mask;
+
+  int *process_class;
+  long long *process_estimates;
+};
+
+/*
+ * Init burst predictor
+ *
+ * Sets up predictions for each process in the table, with the weight
+ * and first guess from the parameters, which must be predicting.
+ */
+void init_burst_predictor(struct BurstPredictor *const restrict predictor,
+                          const struct ProcessEntry *const restrict
+                          process_table,
+                          const int total_processes,
+                          const struct SchedulerParameters *const restrict
+                          parameters);
+
+/*
+ * Destroy burst predictor
+ *
+ * Frees everything the predictor allocated.
+ */
+void destroy_burst_predictor(struct BurstPredictor *const restrict
+                             predictor);
+
+/*
+ * Predict burst
+ *
+ * The guess at how long the process's next CPU burst will be.
+ */
+long long predict_burst(const struct BurstPredictor *const restrict
+                        predictor,
+                        const int process);
+
+/*
+ * Record burst
+ *
+ * The process has finished a CPU burst that took burst_time, which
+ * goes into its own average and its class's.
+ */
+void record_burst(struct BurstPredictor *const restrict predictor,
+                  const int process,
+                  const int burst_time);
+
+#endif
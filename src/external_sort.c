@@ -0,0 +1,308 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Half the budget holds the run being read in, the other half is room
+ * for merge sorting it, which keeps processes that arrive together in
+ * file order. Runs are written to tmpfile files as raw SortRecords,
+ * they're only ever read back by this program, so there's no need to
+ * format them.
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "external_sort.h"
+
+/*
+ * Fewest records a run can hold, however small the budget.
+ */
+#define SORT_MIN_RECORDS 1024
+
+// Forward decs
+static bool spill_run(struct ExternalSort *const restrict sort,
+                      struct SortRecord *const restrict records,
+                      struct SortRecord *const restrict scratch,
+                      const size_t count);
+static void sort_records(struct SortRecord *const restrict records,
+                         struct SortRecord *const restrict scratch,
+                         const size_t count);
+static void merge_records(const struct SortRecord *const restrict from,
+                          struct SortRecord *const restrict to,
+                          const size_t start,
+                          const size_t middle,
+                          const size_t end);
+static void start_merge(struct ExternalSort *const restrict sort);
+static void read_block(struct SortRun *const restrict run);
+
+enum FileError sort_trace(const char *const restrict filename,
+                          const size_t memory_budget,
+                          struct ExternalSort *const restrict sort,
+                          int *const restrict quantum,
+                          const long quiet_lines) {
+  struct TraceReader reader;
+  enum FileError file_error = open_trace_reader(filename, &reader, quantum);
+
+  if (file_error == FILE_ERR_NONE) {
+    reader.quiet_lines = quiet_lines;
+
+    size_t capacity = memory_budget / (2 * sizeof(struct SortRecord));
+
+    if (capacity < SORT_MIN_RECORDS) {
+      capacity = SORT_MIN_RECORDS;
+    }
+
+    struct SortRecord *records = malloc(sizeof(struct SortRecord) *
+                                        capacity);
+    struct SortRecord *const scratch = malloc(sizeof(struct SortRecord) *
+                                              capacity);
+    assert(records != NULL);
+    assert(scratch != NULL);
+
+    sort->runs = NULL;
+    sort->run_count = 0;
+    sort->next_record = 0;
+
+    size_t count = 0;
+    struct ProcessEntry process;
+
+    while (file_error == FILE_ERR_NONE &&
+           read_trace_process(&reader, &process)) {
+      records[count].arrival_time = process.arrival_time;
+      records[count].burst_time = process.burst_time;
+      records[count].priority = process.priority;
+      records[count].tickets = process.tickets;
+      ++count;
+
+      if (count == capacity) {
+        if (!spill_run(sort, records, scratch, count)) {
+          file_error = FILE_ERR_SPILL;
+        }
+        count = 0;
+      }
+    }
+
+    if (file_error == FILE_ERR_NONE && sort->run_count == 0) {
+      // It all fit, no need for any files.
+      sort_records(records, scratch, count);
+      sort->records = records;
+      sort->record_count = count;
+    } else {
+      if (file_error == FILE_ERR_NONE && count > 0 &&
+          !spill_run(sort, records, scratch, count)) {
+        file_error = FILE_ERR_SPILL;
+      }
+
+      free(records);
+      sort->records = NULL;
+      sort->record_count = 0;
+
+      if (file_error == FILE_ERR_NONE) {
+        start_merge(sort);
+      } else {
+        // None of the runs are any use without the rest.
+        for (int i = 0; i < sort->run_count; i++) {
+          fclose(sort->runs[i].file);
+        }
+
+        free(sort->runs);
+        sort->runs = NULL;
+        sort->run_count = 0;
+      }
+    }
+
+    free(scratch);
+    close_trace_reader(&reader);
+  }
+
+  return file_error;
+}
+
+bool next_sorted_process(struct ExternalSort *const restrict sort,
+                         struct ProcessEntry *const restrict process) {
+  struct SortRecord record;
+  bool found = false;
+
+  if (sort->run_count == 0) {
+    if (sort->next_record < sort->record_count) {
+      record = sort->records[sort->next_record++];
+      found = true;
+    }
+  } else if (!heap_is_empty(&sort->heads)) {
+    const int run_number = heap_pop(&sort->heads);
+    struct SortRun *const run = &sort->runs[run_number];
+
+    record = run->block[run->next++];
+    found = true;
+
+    if (run->next == run->count) {
+      read_block(run);
+    }
+
+    if (run->next < run->count) {
+      heap_push(&sort->heads, run_number,
+                run->block[run->next].arrival_time);
+    }
+  }
+
+  if (found) {
+    // Everything in the runs was checked when it was read.
+    enum ProcessEntryError error =
+        init_process_entry(process, record.arrival_time, record.burst_time,
+                           record.priority, record.tickets);
+    assert(error == PROCESS_ENTRY_ERR_NONE);
+    (void) error;
+  }
+
+  return found;
+}
+
+void destroy_external_sort(struct ExternalSort *const restrict sort) {
+  for (int i = 0; i < sort->run_count; i++) {
+    fclose(sort->runs[i].file);
+    free(sort->runs[i].block);
+  }
+
+  if (sort->run_count > 0) {
+    destroy_indexed_heap(&sort->heads);
+  }
+
+  free(sort->runs);
+  free(sort->records);
+
+  sort->runs = NULL;
+  sort->run_count = 0;
+  sort->records = NULL;
+  sort->record_count = 0;
+  sort->next_record = 0;
+}
+
+/*
+ * spill_run
+ *
+ * Sorts the records and writes them out as a new run. Returns false,
+ * with errno set, if the run couldn't be written.
+ */
+static bool spill_run(struct ExternalSort *const restrict sort,
+                      struct SortRecord *const restrict records,
+                      struct SortRecord *const restrict scratch,
+                      const size_t count) {
+  sort_records(records, scratch, count);
+
+  FILE *const file = tmpfile();
+  bool result = (file != NULL);
+
+  if (result) {
+    result = (fwrite(records, sizeof(struct SortRecord), count, file) ==
+              count && fflush(file) == 0);
+
+    if (result) {
+      rewind(file);
+
+      sort->runs = realloc(sort->runs, sizeof(struct SortRun) *
+                           (sort->run_count + 1));
+      assert(sort->runs != NULL);
+
+      sort->runs[sort->run_count].file = file;
+      sort->runs[sort->run_count].block = NULL;
+      sort->runs[sort->run_count].next = 0;
+      sort->runs[sort->run_count].count = 0;
+      ++sort->run_count;
+    } else {
+      fclose(file);
+    }
+  }
+
+  return result;
+}
+
+/*
+ * sort_records
+ *
+ * Bottom up merge sort on arrival time, using scratch as the other
+ * half of each merge. Stable, so ties keep the order they were read.
+ */
+static void sort_records(struct SortRecord *const restrict records,
+                         struct SortRecord *const restrict scratch,
+                         const size_t count) {
+  struct SortRecord *from = records;
+  struct SortRecord *to = scratch;
+
+  for (size_t width = 1; width < count; width *= 2) {
+    for (size_t start = 0; start < count; start += 2 * width) {
+      const size_t middle = (start + width < count) ? start + width : count;
+      const size_t end = (middle + width < count) ? middle + width : count;
+
+      merge_records(from, to, start, middle, end);
+    }
+
+    struct SortRecord *const swap = from;
+    from = to;
+    to = swap;
+  }
+
+  if (from != records) {
+    memcpy(records, from, sizeof(struct SortRecord) * count);
+  }
+}
+
+/*
+ * merge_records
+ *
+ * Merges the sorted ranges start to middle and middle to end of from
+ * into the same place in to, taking from the first on ties.
+ */
+static void merge_records(const struct SortRecord *const restrict from,
+                          struct SortRecord *const restrict to,
+                          const size_t start,
+                          const size_t middle,
+                          const size_t end) {
+  size_t left = start;
+  size_t right = middle;
+
+  for (size_t i = start; i < end; i++) {
+    if (left < middle &&
+        (right >= end ||
+         from[left].arrival_time <= from[right].arrival_time)) {
+      to[i] = from[left++];
+    } else {
+      to[i] = from[right++];
+    }
+  }
+}
+
+/*
+ * start_merge
+ *
+ * Reads the first block of every run, and puts them all in the heap.
+ */
+static void start_merge(struct ExternalSort *const restrict sort) {
+  init_indexed_heap(&sort->heads, sort->run_count);
+
+  for (int i = 0; i < sort->run_count; i++) {
+    struct SortRun *const run = &sort->runs[i];
+
+    run->block = malloc(sizeof(struct SortRecord) * SORT_BLOCK_RECORDS);
+    assert(run->block != NULL);
+
+    read_block(run);
+
+    if (run->count > 0) {
+      heap_push(&sort->heads, i, run->block[0].arrival_time);
+    }
+  }
+}
+
+/*
+ * read_block
+ *
+ * Reads the run's next block. If there's nothing left, or it can't be
+ * read, the block is empty.
+ */
+static void read_block(struct SortRun *const restrict run) {
+  run->count = fread(run->block, sizeof(struct SortRecord),
+                     SORT_BLOCK_RECORDS, run->file);
+  run->next = 0;
+}
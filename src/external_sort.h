@@ -0,0 +1,117 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Sorts a trace by arrival time in a fixed amount of memory, however
+ *   big it is, by sorting it a run at a time into temporary files and
+ *   merging those.
+ */
+
+#ifndef EXTERNAL_SORT_H_
+#define EXTERNAL_SORT_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "file_reader.h"
+#include "indexed_heap.h"
+#include "process_entry.h"
+
+/*
+ * Records read from each run's file at a time while merging.
+ */
+#define SORT_BLOCK_RECORDS 4096
+
+/*
+ * SortRecord
+ *
+ * A process as it's kept in the run files, just what the trace gives
+ * for it.
+ */
+struct SortRecord {
+  int arrival_time;
+  int burst_time;
+  int priority;
+  int tickets;
+};
+
+/*
+ * SortRun
+ *
+ * One sorted run in its temporary file, and the block of it being
+ * merged, from next up to count.
+ */
+struct SortRun {
+  FILE *file;
+  struct SortRecord *block;
+  int next;
+  int count;
+};
+
+/*
+ * ExternalSort
+ *
+ * A trace being read back in sorted order. If the whole trace fit in
+ * memory there are no runs, and the sorted records are read straight
+ * from records. Otherwise records has been freed, and the runs are
+ * merged with a heap on the arrival time of the next record in each.
+ * Ties go to the earlier run, so processes that arrive together stay
+ * in the order they're in the file.
+ */
+struct ExternalSort {
+  struct SortRecord *records;
+  size_t record_count;
+  size_t next_record;
+
+  struct SortRun *runs;
+  int run_count;
+  struct IndexedHeap heads;
+};
+
+/*
+ * Sort trace
+ *
+ * Reads the trace in the file, and sorts it by arrival time using no
+ * more than about memory_budget bytes, spilling sorted runs to
+ * temporary files when it doesn't all fit. The quantum is read from
+ * the file, bad lines are skipped with a warning, and so are
+ * processes that do I/O, the same as read_trace_process, except in the
+ * first quiet_lines lines after the quantum, which have already been
+ * warned about.
+ *
+ * Returns FILE_ERR_SPILL, with errno set, if a temporary file
+ * couldn't be written. The sort only needs destroying if this returns
+ * FILE_ERR_NONE.
+ *
+ * filename - String of the file to sort.
+ * memory_budget - Bytes to sort with.
+ * sort - Set up to read the processes back in order.
+ * quantum - Pointer to an integer, set to the quantum in the file.
+ * quiet_lines - Lines to skip bad ones in without a warning.
+ */
+enum FileError sort_trace(const char *const restrict filename,
+                          const size_t memory_budget,
+                          struct ExternalSort *const restrict sort,
+                          int *const restrict quantum,
+                          const long quiet_lines);
+
+/*
+ * Next sorted process
+ *
+ * Reads the next process in arrival time order. Returns false once
+ * they've all been read.
+ */
+bool next_sorted_process(struct ExternalSort *const restrict sort,
+                         struct ProcessEntry *const restrict process);
+
+/*
+ * Destroy external sort
+ *
+ * Closes, and so deletes, the temporary files, and frees everything.
+ */
+void destroy_external_sort(struct ExternalSort *const restrict sort);
+
+#endif
@@ -0,0 +1,51 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include "fenwick_tree.h"
+
+void fenwick_add(long long *const restrict tree, const int size,
+                 const int index, const long long value) {
+  for (int i = index + 1; i <= size; i += i & -i) {
+    tree[i] += value;
+  }
+}
+
+long long fenwick_sum(const long long *const restrict tree, const int index) {
+  long long result = 0;
+
+  for (int i = index + 1; i > 0; i -= i & -i) {
+    result += tree[i];
+  }
+
+  return result;
+}
+
+/*
+ * fenwick_find
+ *
+ * Walks down from the largest power of two, skipping over any block
+ * whose total doesn't take us past the target.
+ */
+int fenwick_find(const long long *const restrict tree, const int size,
+                 long long target) {
+  int position = 0;
+  int step = 1;
+
+  while (step * 2 <= size) {
+    step *= 2;
+  }
+
+  for (; step > 0; step /= 2) {
+    if (position + step <= size && tree[position + step] <= target) {
+      position += step;
+      target -= tree[position];
+    }
+  }
+
+  // position is the last one based index with a sum no more than
+  // target, so the next one is the zero based answer.
+  return position;
+}
@@ -0,0 +1,46 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Fenwick tree, for keeping running totals over a process table
+ *   that can be updated and summed in O(log n).
+ */
+
+#ifndef FENWICK_TREE_H_
+#define FENWICK_TREE_H_
+
+/*
+ * The tree is just an array of size + 1 long longs, zeroed to start
+ * with, for a table of size entries. It's one based internally, but
+ * the functions all take zero based indexes.
+ */
+
+/*
+ * Fenwick add
+ *
+ * Adds value to the entry at index.
+ */
+void fenwick_add(long long *const restrict tree, const int size,
+                 const int index, const long long value);
+
+/*
+ * Fenwick sum
+ *
+ * Sum of all entries from the start of the tree up to and including
+ * index.
+ */
+long long fenwick_sum(const long long *const restrict tree, const int index);
+
+/*
+ * Fenwick find
+ *
+ * Returns the first index where the sum up to and including it is
+ * more than target. Entries must not be negative, and target must be
+ * less than the total of the whole tree.
+ */
+int fenwick_find(const long long *const restrict tree, const int size,
+                 long long target);
+
+#endif
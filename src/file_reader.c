@@ -4,60 +4,130 @@
  * Author: Mike Aldred
  */
 
+// For getline.
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <ctype.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include "file_reader.h"
 
+// Forward decs
+static enum FileError read_whole_trace(FILE *const restrict file,
+                                       struct LinkedList *const restrict
+                                       process_list,
+                                       int *const restrict quantum);
+static enum FileError read_quantum(FILE *const restrict file,
+                                   char **const restrict line,
+                                   size_t *const restrict line_size,
+                                   int *const restrict quantum);
+static void add_process_line(struct LinkedList *const restrict process_list,
+                             const char *const restrict line,
+                             const bool quiet);
+static int read_io_phases(const char *const restrict text,
+                          int **const restrict io_phases);
+static void report_list_error(const enum LinkedListError error,
+                              const int arrival_time,
+                              const int burst_time,
+                              const int tickets);
+
 enum FileError read_file(const char *const restrict filename,
                          struct LinkedList *const restrict process_list,
                          int *const restrict quantum) {
 
-  FILE *const restrict file_to_read = fopen(filename, "r");
+  struct TraceFile file_to_read;
 
   enum FileError file_error = FILE_ERR_NONE;
 
-  // Keep track of the line number, for error reporting. Starting on
-  // two, because it's easy to know the quantum is wrong.
-  int line_number = 1;
-
-  if (file_to_read == NULL) {
+  if (!open_trace_file(filename, &file_to_read)) {
     // Error
     file_error = FILE_ERR_OPEN;
   } else {
     // File opened.
-    // First line is the quantum.
-    if (fscanf(file_to_read, " %4d ", quantum) == EOF) {
-      // There was an error.
-      file_error = FILE_ERR_OPEN;
+    file_error = read_whole_trace(file_to_read.file, process_list, quantum);
+    close_trace_file(&file_to_read);
+  }
+
+  return file_error;
+}
+
+enum FileError read_buffer(const char *const restrict data,
+                           const size_t size,
+                           struct LinkedList *const restrict process_list,
+                           int *const restrict quantum) {
+  struct TraceFile buffer_to_read;
+
+  enum FileError file_error = FILE_ERR_OPEN;
+
+  if (open_trace_buffer(data, size, &buffer_to_read)) {
+    file_error = read_whole_trace(buffer_to_read.file, process_list,
+                                  quantum);
+    close_trace_file(&buffer_to_read);
+  }
+
+  return file_error;
+}
+
+enum FileError read_file_from(const char *const restrict filename,
+                              struct LinkedList *const restrict process_list,
+                              int *const restrict quantum,
+                              long *const restrict offset) {
+
+  FILE *const restrict file_to_read = fopen(filename, "r");
+
+  enum FileError file_error = FILE_ERR_NONE;
+
+  if (file_to_read == NULL) {
+    file_error = FILE_ERR_OPEN;
+  } else {
+    // Anything shorter than what we've already read can't be the same
+    // file with more appended to it.
+    if (fseek(file_to_read, 0, SEEK_END) != 0 ||
+        ftell(file_to_read) < *offset) {
+      file_error = FILE_ERR_TRUNCATED;
     } else {
-      // Read the first line in.
-      if (*quantum < 1) {
-        file_error = FILE_ERR_QUANTUM;
-      } else {
-        // Should be good, read and add to list until done, or error.
-        init_list(process_list);
-
-        int arrival_time, burst_time;
-
-        while(fscanf(file_to_read, "%4d %4d ",
-                     &arrival_time, &burst_time) != EOF) {
-          // Any errors we get here aren't terminal, we'll just skip
-          // that entry but let the user know.
-          switch (add_to_list(process_list, arrival_time, burst_time)) {
-            case LIST_ERR_NONE:
-              ++line_number;
-              break;
-            case LIST_ERR_ARRIVAL:
-              fprintf(stderr, "Error with arrival time: %d\n", arrival_time);
-              break;
-            case LIST_ERR_BURST:
-              fprintf(stderr, "Error with burst time: %d\n", burst_time);
-              break;
-            default:
-              fprintf(stderr, "Unknow error adding process to list.\n");
+      fseek(file_to_read, *offset, SEEK_SET);
+
+      char *line = NULL;
+      size_t line_size = 0;
+      ssize_t line_length;
+
+      // Track where we are, and only move the caller's offset once a
+      // whole line has been dealt with.
+      long position = *offset;
+      bool need_quantum = (*offset == 0);
+
+      while (file_error == FILE_ERR_NONE &&
+             (line_length = getline(&line, &line_size, file_to_read)) > 0 &&
+             line[line_length - 1] == '\n') {
+
+        if (need_quantum) {
+          if (sscanf(line, " %4d", quantum) != 1) {
+            file_error = FILE_ERR_OPEN;
+          } else if (*quantum < 1) {
+            file_error = FILE_ERR_QUANTUM;
           }
+          need_quantum = false;
+        } else {
+          add_process_line(process_list, line, false);
         }
+
+        position += line_length;
+      }
+
+      // Never got a complete quantum line, nothing to work with yet.
+      if (need_quantum && file_error == FILE_ERR_NONE) {
+        file_error = FILE_ERR_OPEN;
       }
+
+      if (file_error == FILE_ERR_NONE) {
+        *offset = position;
+      }
+
+      free(line);
     }
 
     fclose(file_to_read);
@@ -65,3 +135,241 @@ enum FileError read_file(const char *const restrict filename,
 
   return file_error;
 }
+
+enum FileError open_trace_reader(const char *const restrict filename,
+                                 struct TraceReader *const restrict reader,
+                                 int *const restrict quantum) {
+  enum FileError file_error = FILE_ERR_NONE;
+
+  reader->line = NULL;
+  reader->line_size = 0;
+  reader->lines_read = 0;
+  reader->quiet_lines = 0;
+  init_list(&reader->process_list);
+
+  if (!open_trace_file(filename, &reader->file)) {
+    reader->file.file = NULL;
+    file_error = FILE_ERR_OPEN;
+  } else {
+    file_error = read_quantum(reader->file.file, &reader->line,
+                              &reader->line_size, quantum);
+
+    if (file_error != FILE_ERR_NONE) {
+      close_trace_reader(reader);
+    }
+  }
+
+  return file_error;
+}
+
+bool read_trace_process(struct TraceReader *const restrict reader,
+                        struct ProcessEntry *const restrict process) {
+  struct LinkedList *const list = &reader->process_list;
+  bool found = false;
+
+  while (!found &&
+         getline(&reader->line, &reader->line_size,
+                 reader->file.file) > 0) {
+    const bool quiet = (++reader->lines_read <= reader->quiet_lines);
+
+    add_process_line(list, reader->line, quiet);
+
+    if (list->head != NULL) {
+      struct LinkedListNode *const node = list->head;
+
+      if (node->process.phase_count > 0) {
+        if (!quiet) {
+          fprintf(stderr, "Error, can't stream I/O bursts of process "
+                  "arriving at: %d\n", node->process.arrival_time);
+        }
+      } else {
+        *process = node->process;
+        found = true;
+      }
+
+      remove_from_list(list, node);
+      list->phase_count = 0;
+    }
+  }
+
+  return found;
+}
+
+void close_trace_reader(struct TraceReader *const restrict reader) {
+  if (reader->file.file != NULL) {
+    close_trace_file(&reader->file);
+  }
+
+  free(reader->line);
+  reader->line = NULL;
+  reader->line_size = 0;
+
+  destroy_list(&reader->process_list);
+}
+
+/*
+ * read_whole_trace
+ *
+ * Reads the quantum, then every process, from the open file.
+ */
+static enum FileError read_whole_trace(FILE *const restrict file,
+                                       struct LinkedList *const restrict
+                                       process_list,
+                                       int *const restrict quantum) {
+  char *line = NULL;
+  size_t line_size = 0;
+
+  enum FileError file_error = read_quantum(file, &line, &line_size, quantum);
+
+  if (file_error == FILE_ERR_NONE) {
+    // Should be good, read and add to list until done.
+    init_list(process_list);
+
+    while (getline(&line, &line_size, file) > 0) {
+      add_process_line(process_list, line, false);
+    }
+  }
+
+  free(line);
+
+  return file_error;
+}
+
+/*
+ * read_quantum
+ *
+ * The first line of a trace is the quantum. We'll consider a quantum
+ * of 0 or lower invalid.
+ */
+static enum FileError read_quantum(FILE *const restrict file,
+                                   char **const restrict line,
+                                   size_t *const restrict line_size,
+                                   int *const restrict quantum) {
+  enum FileError file_error = FILE_ERR_NONE;
+
+  if (getline(line, line_size, file) < 1 ||
+      sscanf(*line, " %4d", quantum) != 1) {
+    file_error = FILE_ERR_OPEN;
+  } else if (*quantum < 1) {
+    file_error = FILE_ERR_QUANTUM;
+  }
+
+  return file_error;
+}
+
+/*
+ * add_process_line
+ *
+ * Reads a process from a line of the trace and adds it to the list.
+ * The priority and tickets columns are optional, processes without
+ * them get a priority of 0 and DEFAULT_TICKETS. After a ':' come the
+ * process's I/O and CPU bursts once the first CPU burst is done, for
+ * processes that do I/O. Blank lines or junk are skipped. Any errors
+ * we get adding it aren't terminal, the entry is skipped but the user
+ * is told, unless quiet is set as they've been told already.
+ */
+static void add_process_line(struct LinkedList *const restrict process_list,
+                             const char *const restrict line,
+                             const bool quiet) {
+  int arrival_time, burst_time;
+  int priority = 0;
+  int tickets = DEFAULT_TICKETS;
+
+  if (sscanf(line, "%4d %4d %4d %6d",
+             &arrival_time, &burst_time, &priority, &tickets) >= 2) {
+    int *io_phases = NULL;
+    int io_phase_count = 0;
+    enum LinkedListError error = LIST_ERR_NONE;
+
+    const char *const io_start = strchr(line, ':');
+
+    if (io_start != NULL) {
+      io_phase_count = read_io_phases(io_start + 1, &io_phases);
+
+      if (io_phase_count < 1) {
+        error = LIST_ERR_PHASES;
+      }
+    }
+
+    if (error == LIST_ERR_NONE) {
+      error = add_to_list(process_list, arrival_time, burst_time, priority,
+                          tickets, io_phases, io_phase_count);
+    }
+
+    if (error != LIST_ERR_NONE && !quiet) {
+      report_list_error(error, arrival_time, burst_time, tickets);
+    }
+
+    free(io_phases);
+  }
+}
+
+/*
+ * read_io_phases
+ *
+ * Reads the whitespace separated bursts from the text into a new
+ * array, which the caller frees. Returns how many there were, or -1 if
+ * there's anything else in the text.
+ */
+static int read_io_phases(const char *const restrict text,
+                          int **const restrict io_phases) {
+  int count = 0;
+  int capacity = 0;
+  const char *position = text;
+  char *end;
+
+  long value = strtol(position, &end, 10);
+
+  while (end != position) {
+    if (count == capacity) {
+      capacity = (capacity > 0) ? capacity * 2 : 8;
+      *io_phases = realloc(*io_phases, sizeof(int) * capacity);
+      assert(*io_phases != NULL);
+    }
+
+    // Out of range is as bad as a burst of 0, add_to_list rejects it.
+    (*io_phases)[count++] = (value > 0 && value <= 9999) ? (int) value : 0;
+
+    position = end;
+    value = strtol(position, &end, 10);
+  }
+
+  while (isspace((unsigned char) *position)) {
+    ++position;
+  }
+
+  if (*position != '\0') {
+    count = -1;
+  }
+
+  return count;
+}
+
+/*
+ * report_list_error
+ *
+ * Errors adding a process to the list aren't terminal, we'll just
+ * skip that entry but let the user know.
+ */
+static void report_list_error(const enum LinkedListError error,
+                              const int arrival_time,
+                              const int burst_time,
+                              const int tickets) {
+  switch (error) {
+    case LIST_ERR_ARRIVAL:
+      fprintf(stderr, "Error with arrival time: %d\n", arrival_time);
+      break;
+    case LIST_ERR_BURST:
+      fprintf(stderr, "Error with burst time: %d\n", burst_time);
+      break;
+    case LIST_ERR_TICKETS:
+      fprintf(stderr, "Error with tickets: %d\n", tickets);
+      break;
+    case LIST_ERR_PHASES:
+      fprintf(stderr, "Error with I/O bursts of process arriving at: %d\n",
+              arrival_time);
+      break;
+    default:
+      fprintf(stderr, "Unknow error adding process to list.\n");
+  }
+}
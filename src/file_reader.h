@@ -10,12 +10,19 @@
 #ifndef FILE_READER_H_
 #define FILE_READER_H_
 
+#include <stdbool.h>
+#include <stdio.h>
+
 #include "linked_list.h"
+#include "process_entry.h"
+#include "trace_file.h"
 
 enum FileError {
   FILE_ERR_NONE = 0,
   FILE_ERR_OPEN,
-  FILE_ERR_QUANTUM
+  FILE_ERR_QUANTUM,
+  FILE_ERR_TRUNCATED,
+  FILE_ERR_SPILL
 };
 
 /*
@@ -26,8 +33,13 @@ enum FileError {
  * will be returned. Also returns a FileErrorCode of FILE_ERR_NONE if
  * no problems.
  *
- * Does not check that the number of fields per line is valid. We'll
- * consider a quantum of 0 or lower invalid, and will return an error.
+ * The quantum is on the first line, then one process to a line, with
+ * its arrival time, burst time, and optionally its priority and
+ * tickets. Lines that don't have at least the two times are skipped.
+ * Compressed traces are decompressed as they're read, see
+ * trace_file.h, so are streamed ones.
+ * We'll consider a quantum of 0 or lower invalid, and will return an
+ * error.
  *
  * filename - String of the file to load.
  * list - Pointer to a LinkedList that has been initialised.
@@ -40,5 +52,100 @@ enum FileError read_file(const char *const restrict filename,
                          struct LinkedList *const restrict process_list,
                          int *const restrict quantum);
 
+/*
+ * Read Buffer
+ *
+ * Same as read_file, for a trace that's already been read into
+ * memory, size bytes of it at data.
+ */
+enum FileError read_buffer(const char *const restrict data,
+                           const size_t size,
+                           struct LinkedList *const restrict process_list,
+                           int *const restrict quantum);
+
+/*
+ * Read File From
+ *
+ * For traces that are still being written to. Picks up reading the
+ * file at the given byte offset, and only adds the records that have
+ * been appended since then to the list. The offset is updated to just
+ * past the last record read, so calling this again later only costs
+ * as much as whatever was added in between.
+ *
+ * Only complete lines are read, one record to a line, any partly
+ * written line at the end of the file is left until next time. If
+ * the offset is zero, the quantum is read from the first line, same
+ * as read_file, otherwise the quantum is left alone.
+ *
+ * Followed traces are never decompressed, the offset is into the
+ * file as it is.
+ *
+ * If the file is now smaller than the offset, it's been replaced
+ * rather than appended to, and FILE_ERR_TRUNCATED is returned, the
+ * caller will need to start again from zero.
+ *
+ * filename - String of the file to load.
+ * process_list - Pointer to a LinkedList that has been initialised.
+ * quantum - Pointer to an integer, set if reading from the start.
+ * offset - Byte offset to start reading from, updated on return.
+ */
+enum FileError read_file_from(const char *const restrict filename,
+                              struct LinkedList *const restrict process_list,
+                              int *const restrict quantum,
+                              long *const restrict offset);
+
+/*
+ * TraceReader
+ *
+ * For reading a trace a process at a time, so none of the rest of it
+ * needs to be in memory. The list only ever holds the process being
+ * read. lines_read counts the lines after the quantum read so far, no
+ * warnings are shown for the first quiet_lines of them, for a trace
+ * being read again whose warnings were shown the first time.
+ */
+struct TraceReader {
+  struct TraceFile file;
+  char *line;
+  size_t line_size;
+  struct LinkedList process_list;
+  long lines_read;
+  long quiet_lines;
+};
+
+/*
+ * Open trace reader
+ *
+ * Opens the file and reads the quantum from its first line, the same
+ * way as read_file, ready to read the processes one at a time, with
+ * warnings for every line. The reader only needs closing if this
+ * returns FILE_ERR_NONE.
+ *
+ * filename - String of the file to read.
+ * reader - Reader to set up.
+ * quantum - Pointer to an integer, set to the quantum in the file.
+ */
+enum FileError open_trace_reader(const char *const restrict filename,
+                                 struct TraceReader *const restrict reader,
+                                 int *const restrict quantum);
+
+/*
+ * Read trace process
+ *
+ * Reads the next process from the trace, in file order. Bad lines are
+ * skipped with a warning, as are processes that do I/O, there's
+ * nowhere to keep their bursts. Returns false at the end of the file.
+ *
+ * reader - Reader from open_trace_reader.
+ * process - Set to the process read.
+ */
+bool read_trace_process(struct TraceReader *const restrict reader,
+                        struct ProcessEntry *const restrict process);
+
+/*
+ * Close trace reader
+ *
+ * Closes the file and frees everything held by the reader.
+ */
+void close_trace_reader(struct TraceReader *const restrict reader);
 
 #endif
@@ -0,0 +1,683 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Each of these follows the scheduler it stands in for step by step,
+ * with a group in place of each process. Processes in a group are
+ * next to each other in the table, so whenever one of them would be
+ * picked the rest would be picked straight after it, unless something
+ * arrives in between. Whatever they do, they do one after another,
+ * with their turns all the same length, so they finish a turn length
+ * apart and their times are an arithmetic series.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "fenwick_tree.h"
+#include "grouped_scheduler.h"
+#include "indexed_heap.h"
+#include "rr_scheduler.h"
+#include "sjf_scheduler.h"
+
+// Forward decs
+static void grouped_sjf(const struct ProcessGroup *const restrict groups,
+                        const int total_groups,
+                        const struct SchedulerParameters *const restrict
+                        parameters,
+                        struct ProcessStatistics *const restrict stats);
+static void grouped_rr(const struct ProcessGroup *const restrict groups,
+                       const int total_groups,
+                       const struct SchedulerParameters *const restrict
+                       parameters,
+                       struct ProcessStatistics *const restrict stats);
+static int group_period_end(const struct ProcessGroup *const restrict groups,
+                            const int total_groups,
+                            const int period_start,
+                            const struct SchedulerParameters *const restrict
+                            parameters);
+static void grouped_rr_simulate(
+    const struct ProcessGroup *const restrict groups,
+    const int total_groups,
+    const struct SchedulerParameters *const restrict parameters,
+    struct ProcessStatistics *const restrict stats);
+static void grouped_rr_batch(
+    const struct ProcessGroup *const restrict groups,
+    const int total_groups,
+    const struct SchedulerParameters *const restrict parameters,
+    struct ProcessStatistics *const restrict stats);
+static int compare_group_rounds(const void *first, const void *second);
+static int compare_bursts(const void *first, const void *second);
+static int group_turns(const int burst_time, const int quantum);
+static int group_stable_passes(
+    const struct ProcessGroup *const restrict groups,
+    const int *const restrict remaining,
+    const int total_groups,
+    const int start,
+    const int end,
+    const long long cpu_time,
+    const int last_run,
+    const struct SchedulerParameters *const restrict parameters,
+    long long *const restrict in_queue,
+    long long *const restrict turn_length,
+    int *const restrict last_in_queue);
+
+/*
+ * GroupRounds
+ *
+ * For the batch scheduler, how many rounds of the queue each process
+ * in a group needs, along with which group it is.
+ */
+struct GroupRounds {
+  int rounds;
+  int index;
+};
+
+int group_processes(const struct ProcessEntry *const restrict process_table,
+                    const int total_processes,
+                    struct ProcessGroup **const restrict groups) {
+  int total_groups = 0;
+
+  *groups = malloc(sizeof(struct ProcessGroup) * total_processes);
+  assert(*groups != NULL || total_processes == 0);
+
+  for (int i = 0; i < total_processes; i++) {
+    if (total_groups > 0 &&
+        (*groups)[total_groups - 1].arrival_time ==
+        process_table[i].arrival_time &&
+        (*groups)[total_groups - 1].burst_time ==
+        process_table[i].burst_time) {
+      ++(*groups)[total_groups - 1].count;
+    } else {
+      (*groups)[total_groups].arrival_time = process_table[i].arrival_time;
+      (*groups)[total_groups].burst_time = process_table[i].burst_time;
+      (*groups)[total_groups].count = 1;
+      ++total_groups;
+    }
+  }
+
+  return total_groups;
+}
+
+int group_arrivals(const struct ProcessEntry *const restrict process_table,
+                   const int total_processes,
+                   struct ProcessGroup **const restrict groups) {
+  int total_groups = 0;
+
+  *groups = malloc(sizeof(struct ProcessGroup) * total_processes);
+  assert(*groups != NULL || total_processes == 0);
+
+  int *const bursts = malloc(sizeof(int) * total_processes);
+  assert(bursts != NULL || total_processes == 0);
+
+  int start = 0;
+
+  while (start < total_processes) {
+    const int arrival_time = process_table[start].arrival_time;
+    int end = start;
+
+    // The bursts of everything arriving now, sorted so the same ones
+    // are together.
+    while (end < total_processes &&
+           process_table[end].arrival_time == arrival_time) {
+      bursts[end] = process_table[end].burst_time;
+      ++end;
+    }
+
+    qsort(&bursts[start], end - start, sizeof(int), &compare_bursts);
+
+    for (int i = start; i < end; i++) {
+      if (i > start && bursts[i] == bursts[i - 1]) {
+        ++(*groups)[total_groups - 1].count;
+      } else {
+        (*groups)[total_groups].arrival_time = arrival_time;
+        (*groups)[total_groups].burst_time = bursts[i];
+        (*groups)[total_groups].count = 1;
+        ++total_groups;
+      }
+    }
+
+    start = end;
+  }
+
+  free(bursts);
+
+  return total_groups;
+}
+
+bool can_group(const Scheduler scheduler_to_use,
+               const struct SchedulerParameters *const restrict parameters) {
+  return (scheduler_to_use == &sjf_scheduler ||
+          scheduler_to_use == &rr_scheduler) &&
+      parameters->phases == NULL &&
+      parameters->timeline == NULL &&
+      parameters->prediction_weight == 0;
+}
+
+void grouped_scheduler(const struct ProcessGroup *const restrict groups,
+                       const int total_groups,
+                       const Scheduler scheduler_to_use,
+                       const struct SchedulerParameters *const restrict
+                       parameters,
+                       struct ProcessStatistics *const restrict stats) {
+  assert(can_group(scheduler_to_use, parameters));
+
+  if (total_groups > 0) {
+    if (scheduler_to_use == &sjf_scheduler) {
+      grouped_sjf(groups, total_groups, parameters, stats);
+    } else {
+      grouped_rr(groups, total_groups, parameters, stats);
+    }
+  }
+}
+
+/*
+ * grouped_sjf
+ *
+ * The ready groups are in a heap on their burst time, ties going to
+ * the first in the table, the same as sjf_scheduler picks. The group
+ * on top keeps the CPU until a turn starts after the next group has
+ * arrived, then whatever's on top is looked at again.
+ *
+ * Every process costs a dispatch and a switch, same as sjf_scheduler.
+ */
+static void grouped_sjf(const struct ProcessGroup *const restrict groups,
+                        const int total_groups,
+                        const struct SchedulerParameters *const restrict
+                        parameters,
+                        struct ProcessStatistics *const restrict stats) {
+  const long long turn_cost = (long long) parameters->dispatch_cost +
+      parameters->switch_cost;
+
+  int *const left = malloc(sizeof(int) * total_groups);
+  assert(left != NULL);
+
+  struct IndexedHeap ready;
+  init_indexed_heap(&ready, total_groups);
+
+  long long cpu_time = groups[0].arrival_time;
+  int next_group = 0;
+  int groups_remaining = total_groups;
+
+  while (groups_remaining > 0) {
+    while (next_group < total_groups &&
+           groups[next_group].arrival_time <= cpu_time) {
+      left[next_group] = groups[next_group].count;
+      heap_push(&ready, next_group, groups[next_group].burst_time);
+      ++next_group;
+    }
+
+    if (heap_is_empty(&ready)) {
+      cpu_time = groups[next_group].arrival_time;
+    } else {
+      const int running = heap_top(&ready);
+      const struct ProcessGroup *const group = &groups[running];
+      const long long turn_length = turn_cost + group->burst_time;
+
+      long long turns = left[running];
+
+      if (next_group < total_groups) {
+        const long long until_arrival =
+            (groups[next_group].arrival_time - cpu_time + turn_length - 1) /
+            turn_length;
+
+        if (until_arrival < turns) {
+          turns = until_arrival;
+        }
+      }
+
+      add_series_statistics(stats,
+                            cpu_time + turn_length - group->arrival_time,
+                            turn_length, (int) turns, group->burst_time,
+                            turns, turns);
+
+      cpu_time += turns * turn_length;
+      left[running] -= (int) turns;
+
+      if (left[running] == 0) {
+        heap_pop(&ready);
+        --groups_remaining;
+      }
+    }
+  }
+
+  destroy_indexed_heap(&ready);
+  free(left);
+}
+
+/*
+ * grouped_rr
+ *
+ * Splits the groups into busy periods the same way rr_scheduler does,
+ * and schedules each the same way it would.
+ */
+static void grouped_rr(const struct ProcessGroup *const restrict groups,
+                       const int total_groups,
+                       const struct SchedulerParameters *const restrict
+                       parameters,
+                       struct ProcessStatistics *const restrict stats) {
+  int period_start = 0;
+
+  while (period_start < total_groups) {
+    const int period_end = group_period_end(groups, total_groups,
+                                            period_start, parameters);
+
+    if (groups[period_start].arrival_time ==
+        groups[period_end - 1].arrival_time) {
+      grouped_rr_batch(&groups[period_start], period_end - period_start,
+                       parameters, stats);
+    } else {
+      grouped_rr_simulate(&groups[period_start], period_end - period_start,
+                          parameters, stats);
+    }
+
+    period_start = period_end;
+  }
+}
+
+/*
+ * group_period_end
+ *
+ * busy_period_end for groups, every process in a group adds its turns
+ * to how long the CPU is busy.
+ */
+static int group_period_end(const struct ProcessGroup *const restrict groups,
+                            const int total_groups,
+                            const int period_start,
+                            const struct SchedulerParameters *const restrict
+                            parameters) {
+  const long long turn_cost = (long long) parameters->dispatch_cost +
+      parameters->switch_cost;
+
+  long long busy_until = groups[period_start].arrival_time;
+  int period_end = period_start;
+
+  do {
+    const struct ProcessGroup *const group = &groups[period_end];
+
+    busy_until += (long long) group->count *
+        (group->burst_time + turn_cost *
+         group_turns(group->burst_time, parameters->quantum));
+    ++period_end;
+  } while (period_end < total_groups &&
+           groups[period_end].arrival_time <= busy_until);
+
+  return period_end;
+}
+
+/*
+ * grouped_rr_simulate
+ *
+ * rr_simulate for groups, passing through the queue from start to
+ * end, with the waiting groups added after the first turn of a pass.
+ *
+ * last_run is the group whose last process had the CPU last. The
+ * first process of a group needs a switch unless it's that process,
+ * the others always do, as the one before them had the CPU.
+ */
+static void grouped_rr_simulate(
+    const struct ProcessGroup *const restrict groups,
+    const int total_groups,
+    const struct SchedulerParameters *const restrict parameters,
+    struct ProcessStatistics *const restrict stats) {
+
+  const int quantum = parameters->quantum;
+  const long long switch_cost = parameters->switch_cost;
+
+  int *const remaining = malloc(sizeof(int) * total_groups);
+  assert(remaining != NULL);
+
+  for (int i = 0; i < total_groups; i++) {
+    remaining[i] = groups[i].burst_time;
+  }
+
+  int groups_remaining = total_groups;
+  long long cpu_time = groups[0].arrival_time;
+
+  int start = 0;
+  int end = 0;
+  int waiting = 0;
+  int last_run = -1;
+
+  while (groups_remaining > 0) {
+    int group_to_run = start;
+    bool no_group_run = true;
+
+    long long in_queue;
+    long long turn_length;
+    int last_in_queue;
+    const int passes = group_stable_passes(groups, remaining, total_groups,
+                                           start, end, cpu_time, last_run,
+                                           parameters, &in_queue,
+                                           &turn_length, &last_in_queue);
+
+    if (passes > 0) {
+      for (int index = start; index <= end; index++) {
+        if (remaining[index] != 0) {
+          remaining[index] -= passes * quantum;
+          stats->dispatches += (long long) passes * groups[index].count;
+
+          // On its own, a process just carries on without a switch.
+          if (in_queue > 1) {
+            stats->context_switches +=
+                (long long) passes * groups[index].count;
+          }
+        }
+      }
+
+      cpu_time += passes * turn_length * in_queue;
+      last_run = last_in_queue;
+    }
+
+    while (group_to_run <= end) {
+      if (remaining[group_to_run] != 0) {
+        const struct ProcessGroup *const group = &groups[group_to_run];
+
+        const int turn = (remaining[group_to_run] < quantum) ?
+            remaining[group_to_run] : quantum;
+        const bool first_switch = (group_to_run != last_run ||
+                                   group->count > 1);
+        const long long first_end = cpu_time + parameters->dispatch_cost +
+            (first_switch ? switch_cost : 0) + turn;
+        const long long step = parameters->dispatch_cost + switch_cost +
+            turn;
+
+        // Only the first turn of the pass lets the waiting groups in.
+        if (no_group_run) {
+          while (waiting + 1 < total_groups &&
+                 groups[waiting + 1].arrival_time <= first_end) {
+            ++waiting;
+          }
+
+          end = waiting;
+        }
+
+        no_group_run = false;
+
+        cpu_time = first_end + step * (group->count - 1);
+        remaining[group_to_run] -= turn;
+        last_run = group_to_run;
+
+        stats->dispatches += group->count;
+        stats->context_switches += group->count - 1 + (first_switch ? 1 : 0);
+
+        if (remaining[group_to_run] == 0) {
+          add_series_statistics(stats, first_end - group->arrival_time, step,
+                                group->count, group->burst_time, 0, 0);
+          --groups_remaining;
+        }
+      }
+      ++group_to_run;
+    }
+
+    // Everything in the queue is done, on to the next group, waiting
+    // for it if it hasn't arrived.
+    if (no_group_run) {
+      const int next_index = end + 1;
+
+      assert(next_index < total_groups);
+
+      if (groups[next_index].arrival_time > cpu_time) {
+        cpu_time = groups[next_index].arrival_time;
+        last_run = -1;
+      }
+
+      start = end = waiting = next_index;
+    }
+  }
+
+  free(remaining);
+}
+
+/*
+ * grouped_rr_batch
+ *
+ * rr_batch for groups, everything arrives together. The Fenwick tree
+ * has what all the processes of each group still in the queue run for
+ * in the current round, so the processes of a group finishing in a
+ * round finish from the start of the round plus the sum before the
+ * group, a turn apart.
+ *
+ * It's only the last process that can be left on its own, if that's
+ * a group with more than one in it they still switch every turn.
+ */
+static void grouped_rr_batch(
+    const struct ProcessGroup *const restrict groups,
+    const int total_groups,
+    const struct SchedulerParameters *const restrict parameters,
+    struct ProcessStatistics *const restrict stats) {
+
+  const int quantum = parameters->quantum;
+  const long long turn_cost = (long long) parameters->dispatch_cost +
+      parameters->switch_cost;
+
+  struct GroupRounds *const order = malloc(sizeof(struct GroupRounds) *
+                                           total_groups);
+  long long *const tree = calloc(total_groups + 1, sizeof(long long));
+
+  assert(order != NULL);
+  assert(tree != NULL);
+
+  long long in_queue = 0;
+
+  for (int i = 0; i < total_groups; i++) {
+    order[i].rounds = group_turns(groups[i].burst_time, quantum);
+    order[i].index = i;
+
+    fenwick_add(tree, total_groups, i,
+                groups[i].count * (quantum + turn_cost));
+    in_queue += groups[i].count;
+  }
+
+  qsort(order, total_groups, sizeof(struct GroupRounds),
+        compare_group_rounds);
+
+  long long round_start = groups[0].arrival_time;
+  int rounds_done = 0;
+
+  // Highest group to finish in the last round a batch finished in.
+  int last_finished = -1;
+
+  int batch_start = 0;
+
+  while (batch_start < total_groups && in_queue > 1) {
+    const int rounds = order[batch_start].rounds;
+
+    int batch_end = batch_start;
+    while (batch_end < total_groups && order[batch_end].rounds == rounds) {
+      ++batch_end;
+    }
+
+    // Full rounds where nobody finishes.
+    round_start += (rounds - 1 - rounds_done) * (quantum + turn_cost) *
+        in_queue;
+
+    // The last round for this batch only runs what's left of each.
+    long long round_length = (quantum + turn_cost) * in_queue;
+
+    for (int i = batch_start; i < batch_end; i++) {
+      const struct ProcessGroup *const group = &groups[order[i].index];
+      const int last_run = group->burst_time - (rounds - 1) * quantum;
+
+      fenwick_add(tree, total_groups, order[i].index,
+                  (long long) group->count * (last_run - quantum));
+      round_length += (long long) group->count * (last_run - quantum);
+    }
+
+    last_finished = -1;
+
+    for (int i = batch_start; i < batch_end; i++) {
+      const int index = order[i].index;
+      const struct ProcessGroup *const group = &groups[index];
+      const long long step = groups[index].burst_time -
+          (long long) (rounds - 1) * quantum + turn_cost;
+
+      add_series_statistics(stats,
+                            round_start + fenwick_sum(tree, index) -
+                            step * (group->count - 1) - group->arrival_time,
+                            step, group->count, group->burst_time,
+                            (long long) rounds * group->count,
+                            (long long) rounds * group->count);
+
+      if (index > last_finished) {
+        last_finished = index;
+      }
+    }
+
+    // Now they're out of the queue.
+    for (int i = batch_start; i < batch_end; i++) {
+      const struct ProcessGroup *const group = &groups[order[i].index];
+      const int last_run = group->burst_time - (rounds - 1) * quantum;
+
+      fenwick_add(tree, total_groups, order[i].index,
+                  -(long long) group->count * (last_run + turn_cost));
+      in_queue -= group->count;
+    }
+
+    round_start += round_length;
+    rounds_done = rounds;
+    batch_start = batch_end;
+  }
+
+  // One process left on its own, its turns come straight after each
+  // other.
+  if (batch_start < total_groups) {
+    const struct ProcessGroup *const group = &groups[order[batch_start].index];
+
+    assert(group->count == 1);
+
+    const int rounds = order[batch_start].rounds;
+    const int turns = rounds - rounds_done;
+    const bool switched = (order[batch_start].index < last_finished ||
+                           rounds_done == 0);
+
+    add_series_statistics(stats,
+                          round_start + group->burst_time -
+                          (long long) rounds_done * quantum +
+                          (long long) turns * parameters->dispatch_cost +
+                          (switched ? parameters->switch_cost : 0) -
+                          group->arrival_time,
+                          0, 1, group->burst_time, rounds,
+                          rounds_done + (switched ? 1 : 0));
+  }
+
+  free(tree);
+  free(order);
+}
+
+/*
+ * compare_group_rounds
+ *
+ * For qsort, fewest rounds first, table order when they're equal.
+ */
+static int compare_group_rounds(const void *first, const void *second) {
+  const struct GroupRounds *const first_entry = first;
+  const struct GroupRounds *const second_entry = second;
+
+  int result = first_entry->rounds - second_entry->rounds;
+
+  if (result == 0) {
+    result = first_entry->index - second_entry->index;
+  }
+
+  return result;
+}
+
+/*
+ * compare_bursts
+ *
+ * For qsort, shortest burst first.
+ */
+static int compare_bursts(const void *first, const void *second) {
+  const int first_burst = *(const int *) first;
+  const int second_burst = *(const int *) second;
+
+  return (first_burst > second_burst) - (first_burst < second_burst);
+}
+
+/*
+ * group_turns
+ *
+ * How many turns a process with this much burst time left needs
+ * before it's done.
+ */
+static int group_turns(const int burst_time, const int quantum) {
+  return (burst_time + quantum - 1) / quantum;
+}
+
+/*
+ * group_stable_passes
+ *
+ * stable_passes for groups, every process in a group is in the queue.
+ * The first process in the queue is the one that last ran if it's a
+ * group of one that was the last to run.
+ */
+static int group_stable_passes(
+    const struct ProcessGroup *const restrict groups,
+    const int *const restrict remaining,
+    const int total_groups,
+    const int start,
+    const int end,
+    const long long cpu_time,
+    const int last_run,
+    const struct SchedulerParameters *const restrict parameters,
+    long long *const restrict in_queue,
+    long long *const restrict turn_length,
+    int *const restrict last_in_queue) {
+
+  const int quantum = parameters->quantum;
+
+  int least_remaining = 0;
+  int first_in_queue = -1;
+  *in_queue = 0;
+  *last_in_queue = -1;
+
+  for (int index = start; index <= end; index++) {
+    if (remaining[index] != 0) {
+      if (*in_queue == 0 || remaining[index] < least_remaining) {
+        least_remaining = remaining[index];
+      }
+      if (first_in_queue < 0) {
+        first_in_queue = index;
+      }
+      *last_in_queue = index;
+      *in_queue += groups[index].count;
+    }
+  }
+
+  long long passes = 0;
+  *turn_length = (long long) quantum + parameters->dispatch_cost;
+
+  if (*in_queue > 1) {
+    *turn_length += parameters->switch_cost;
+  }
+
+  const bool first_switches = (first_in_queue != last_run ||
+                               (first_in_queue >= 0 &&
+                                groups[first_in_queue].count > 1));
+
+  if (*in_queue > 0 && (*in_queue > 1) == first_switches) {
+    passes = (least_remaining - 1) / quantum;
+
+    if (end + 1 < total_groups && passes > 0) {
+      // Pass p adds anything that's arrived by its first turn, at
+      // cpu_time + p * pass_length + turn_length.
+      const long long pass_length = *turn_length * *in_queue;
+      const long long until_arrival =
+          groups[end + 1].arrival_time - cpu_time - *turn_length;
+      long long before_arrival = 0;
+
+      if (until_arrival > 0) {
+        before_arrival = (until_arrival + pass_length - 1) / pass_length;
+      }
+
+      if (before_arrival < passes) {
+        passes = before_arrival;
+      }
+    }
+  }
+
+  return passes;
+}
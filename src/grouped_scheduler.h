@@ -0,0 +1,73 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Schedules a trace a group of identical processes at a time, so
+ *   traces made up of many copies of the same few processes take time
+ *   in the number of groups rather than the number of processes.
+ */
+
+#ifndef GROUPED_SCHEDULER_H_
+#define GROUPED_SCHEDULER_H_
+
+#include <stdbool.h>
+
+#include "process_entry.h"
+#include "scheduler.h"
+#include "scheduler_parameters.h"
+#include "statistics.h"
+
+/*
+ * Group processes
+ *
+ * Collapses each run of processes in the sorted table with the same
+ * arrival and burst times into a group. Returns how many groups there
+ * are, in a new array set in groups that the caller frees.
+ */
+int group_processes(const struct ProcessEntry *const restrict process_table,
+                    const int total_processes,
+                    struct ProcessGroup **const restrict groups);
+
+/*
+ * Group arrivals
+ *
+ * Collapses all of the processes in the sorted table that arrive at
+ * the same time with the same burst time into a group, wherever they
+ * are among the others arriving then. The groups are in order of
+ * arrival time, then burst time. Only for SJF, which gives identical
+ * processes that arrive together the same results whatever order
+ * they're in, round robin needs group_processes. Returns how many
+ * groups there are, in a new array set in groups that the caller
+ * frees.
+ */
+int group_arrivals(const struct ProcessEntry *const restrict process_table,
+                   const int total_processes,
+                   struct ProcessGroup **const restrict groups);
+
+/*
+ * Can group
+ *
+ * True if the scheduler can be run on groups with these parameters.
+ * Only SJF and round robin can, and only without I/O, a timeline, or
+ * predicted bursts, which all need each process on its own.
+ */
+bool can_group(const Scheduler scheduler_to_use,
+               const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * Grouped scheduler
+ *
+ * Schedules the groups, with exactly the same results for every
+ * process as scheduling the table they came from, and adds them to
+ * the statistics. The scheduler must be one can_group is true for.
+ */
+void grouped_scheduler(const struct ProcessGroup *const restrict groups,
+                       const int total_groups,
+                       const Scheduler scheduler_to_use,
+                       const struct SchedulerParameters *const restrict
+                       parameters,
+                       struct ProcessStatistics *const restrict stats);
+
+#endif
@@ -0,0 +1,93 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Benchmark for handing work to the simulator's scheduler threads.
+ * Runs empty batches through a worker pool the same size as the
+ * simulator's, so all that's timed is getting a batch to the threads
+ * and knowing they're done with it.
+ */
+
+// For clock_gettime.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "thread.h"
+#include "worker_pool.h"
+
+/*
+ * Batches to run when none are given on the command line.
+ */
+#define DEFAULT_BATCHES 100000
+
+// Forward decs
+static void empty_work(void *context, const int worker);
+static double elapsed_nanoseconds(const struct timespec *const restrict start,
+                                  const struct timespec *const restrict end);
+
+/*
+ * Main
+ *
+ * Takes how many batches to run as the only argument. A few warm the
+ * threads up first, then the rest are timed.
+ */
+int main(int argc, char *argv[]) {
+  long batches = DEFAULT_BATCHES;
+
+  if (argc > 1) {
+    batches = strtol(argv[1], NULL, 10);
+  }
+
+  if (batches < 1) {
+    fprintf(stderr, "Usage: %s [batches]\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  struct WorkerPool pool;
+  init_worker_pool(&pool, NUM_THREADS, &empty_work, NULL);
+
+  for (int i = 0; i < 100; i++) {
+    run_batch(&pool);
+  }
+
+  struct timespec start, end;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+
+  for (long i = 0; i < batches; i++) {
+    run_batch(&pool);
+  }
+
+  clock_gettime(CLOCK_MONOTONIC, &end);
+
+  destroy_worker_pool(&pool);
+
+  printf("%d threads, %ld batches, %.0f ns per batch\n", NUM_THREADS,
+         batches, elapsed_nanoseconds(&start, &end) / batches);
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ * empty_work
+ *
+ * Nothing to do, so only the handover is timed.
+ */
+static void empty_work(void *context, const int worker) {
+  (void) context;
+  (void) worker;
+}
+
+/*
+ * elapsed_nanoseconds
+ *
+ * How long it was from start to end.
+ */
+static double elapsed_nanoseconds(const struct timespec *const restrict start,
+                                  const struct timespec *const restrict end) {
+  return (end->tv_sec - start->tv_sec) * 1e9 +
+      (end->tv_nsec - start->tv_nsec);
+}
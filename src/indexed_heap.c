@@ -0,0 +1,234 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "indexed_heap.h"
+
+// Forward decs
+static bool comes_before(const struct IndexedHeap *const restrict heap,
+                         const int first,
+                         const int second);
+static void place_item(struct IndexedHeap *const restrict heap,
+                       const int position,
+                       const int item);
+static void sift_up(struct IndexedHeap *const restrict heap, int position);
+static void sift_down(struct IndexedHeap *const restrict heap, int position);
+
+void init_indexed_heap(struct IndexedHeap *const restrict heap,
+                       const int capacity) {
+  // Always allocate something, so an empty table is fine.
+  const int size = (capacity > 0) ? capacity : 1;
+
+  heap->items = malloc(sizeof(int) * size);
+  heap->positions = malloc(sizeof(int) * size);
+  heap->keys = malloc(sizeof(long long) * size);
+
+  assert(heap->items != NULL);
+  assert(heap->positions != NULL);
+  assert(heap->keys != NULL);
+
+  for (int i = 0; i < size; i++) {
+    heap->positions[i] = -1;
+  }
+
+  heap->size = 0;
+  heap->capacity = capacity;
+}
+
+void destroy_indexed_heap(struct IndexedHeap *const restrict heap) {
+  free(heap->items);
+  free(heap->positions);
+  free(heap->keys);
+
+  heap->items = NULL;
+  heap->positions = NULL;
+  heap->keys = NULL;
+  heap->size = 0;
+  heap->capacity = 0;
+}
+
+void grow_indexed_heap(struct IndexedHeap *const restrict heap,
+                       const int capacity) {
+  if (capacity > heap->capacity) {
+    heap->items = realloc(heap->items, sizeof(int) * capacity);
+    heap->positions = realloc(heap->positions, sizeof(int) * capacity);
+    heap->keys = realloc(heap->keys, sizeof(long long) * capacity);
+
+    assert(heap->items != NULL);
+    assert(heap->positions != NULL);
+    assert(heap->keys != NULL);
+
+    for (int i = heap->capacity; i < capacity; i++) {
+      heap->positions[i] = -1;
+    }
+
+    heap->capacity = capacity;
+  }
+}
+
+bool heap_is_empty(const struct IndexedHeap *const restrict heap) {
+  return heap->size == 0;
+}
+
+bool heap_contains(const struct IndexedHeap *const restrict heap,
+                   const int item) {
+  assert(item >= 0 && item < heap->capacity);
+
+  return heap->positions[item] >= 0;
+}
+
+int heap_top(const struct IndexedHeap *const restrict heap) {
+  assert(heap->size > 0);
+
+  return heap->items[0];
+}
+
+long long heap_top_key(const struct IndexedHeap *const restrict heap) {
+  assert(heap->size > 0);
+
+  return heap->keys[heap->items[0]];
+}
+
+long long heap_key(const struct IndexedHeap *const restrict heap,
+                   const int item) {
+  assert(heap_contains(heap, item));
+
+  return heap->keys[item];
+}
+
+void heap_push(struct IndexedHeap *const restrict heap,
+               const int item,
+               const long long key) {
+  assert(!heap_contains(heap, item));
+
+  heap->keys[item] = key;
+  place_item(heap, heap->size, item);
+  ++heap->size;
+
+  sift_up(heap, heap->size - 1);
+}
+
+int heap_pop(struct IndexedHeap *const restrict heap) {
+  const int top = heap_top(heap);
+
+  heap_remove(heap, top);
+
+  return top;
+}
+
+void heap_decrease_key(struct IndexedHeap *const restrict heap,
+                       const int item,
+                       const long long key) {
+  assert(heap_contains(heap, item));
+  assert(key <= heap->keys[item]);
+
+  heap->keys[item] = key;
+  sift_up(heap, heap->positions[item]);
+}
+
+/*
+ * heap_remove
+ *
+ * The last item fills the hole, it might need to go either way from
+ * there.
+ */
+void heap_remove(struct IndexedHeap *const restrict heap, const int item) {
+  assert(heap_contains(heap, item));
+
+  const int position = heap->positions[item];
+  const int last = heap->items[--heap->size];
+
+  heap->positions[item] = -1;
+
+  if (last != item) {
+    place_item(heap, position, last);
+    sift_up(heap, position);
+    sift_down(heap, heap->positions[last]);
+  }
+}
+
+/*
+ * comes_before
+ *
+ * True if the first item belongs above the second.
+ */
+static bool comes_before(const struct IndexedHeap *const restrict heap,
+                         const int first,
+                         const int second) {
+  return heap->keys[first] < heap->keys[second] ||
+      (heap->keys[first] == heap->keys[second] && first < second);
+}
+
+/*
+ * place_item
+ *
+ * Puts the item at the position, keeping track of where it is.
+ */
+static void place_item(struct IndexedHeap *const restrict heap,
+                       const int position,
+                       const int item) {
+  heap->items[position] = item;
+  heap->positions[item] = position;
+}
+
+/*
+ * sift_up
+ *
+ * Moves the item at the position up past any parents it comes before.
+ */
+static void sift_up(struct IndexedHeap *const restrict heap, int position) {
+  const int item = heap->items[position];
+  bool keep_going = true;
+
+  while (keep_going && position > 0) {
+    const int parent = (position - 1) / INDEXED_HEAP_ARITY;
+
+    if (comes_before(heap, item, heap->items[parent])) {
+      place_item(heap, position, heap->items[parent]);
+      position = parent;
+    } else {
+      keep_going = false;
+    }
+  }
+
+  place_item(heap, position, item);
+}
+
+/*
+ * sift_down
+ *
+ * Moves the item at the position down while any of its children
+ * come before it.
+ */
+static void sift_down(struct IndexedHeap *const restrict heap, int position) {
+  const int item = heap->items[position];
+  bool keep_going = true;
+
+  while (keep_going) {
+    const int first_child = position * INDEXED_HEAP_ARITY + 1;
+    int best = -1;
+
+    for (int child = first_child;
+         child < first_child + INDEXED_HEAP_ARITY && child < heap->size;
+         child++) {
+      if (comes_before(heap, heap->items[child],
+                       (best < 0) ? item : heap->items[best])) {
+        best = child;
+      }
+    }
+
+    if (best >= 0) {
+      place_item(heap, position, heap->items[best]);
+      position = best;
+    } else {
+      keep_going = false;
+    }
+  }
+
+  place_item(heap, position, item);
+}
@@ -0,0 +1,138 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Indexed d-ary min heap, for schedulers that need to keep picking
+ *   the best of a changing set of processes.
+ */
+
+#ifndef INDEXED_HEAP_H_
+#define INDEXED_HEAP_H_
+
+#include <stdbool.h>
+
+/*
+ * How many children each node has. Four keeps the heap shallow, and
+ * all the children of a node in the same cache line.
+ */
+#define INDEXED_HEAP_ARITY 4
+
+/*
+ * IndexedHeap
+ *
+ * Holds items numbered from 0 to capacity - 1, usually indexes into a
+ * process table, each with a key. The item with the smallest key is
+ * on top, with ties going to the lowest numbered item.
+ *
+ * Because the heap knows where every item is, an item's key can be
+ * changed, or the item taken out, without searching for it.
+ *
+ * items - The items in heap order, the first size are in use.
+ * positions - Where each item is in items, -1 if it's not in the heap.
+ * keys - The key of each item, only meaningful while it's in the heap.
+ */
+struct IndexedHeap {
+  int *items;
+  int *positions;
+  long long *keys;
+  int size;
+  int capacity;
+};
+
+/*
+ * Init indexed heap
+ *
+ * Sets up an empty heap that can hold items 0 to capacity - 1.
+ */
+void init_indexed_heap(struct IndexedHeap *const restrict heap,
+                       const int capacity);
+
+/*
+ * Destroy indexed heap
+ *
+ * Frees everything held by the heap.
+ */
+void destroy_indexed_heap(struct IndexedHeap *const restrict heap);
+
+/*
+ * Grow indexed heap
+ *
+ * Makes room for items up to capacity - 1, for when the number of
+ * items isn't known up front. Whatever is in the heap stays there.
+ */
+void grow_indexed_heap(struct IndexedHeap *const restrict heap,
+                       const int capacity);
+
+/*
+ * Heap is empty
+ *
+ * True if there's nothing in the heap.
+ */
+bool heap_is_empty(const struct IndexedHeap *const restrict heap);
+
+/*
+ * Heap contains
+ *
+ * True if the item is in the heap.
+ */
+bool heap_contains(const struct IndexedHeap *const restrict heap,
+                   const int item);
+
+/*
+ * Heap top
+ *
+ * The item with the smallest key, the heap mustn't be empty.
+ */
+int heap_top(const struct IndexedHeap *const restrict heap);
+
+/*
+ * Heap top key
+ *
+ * The key of the item on top, the heap mustn't be empty.
+ */
+long long heap_top_key(const struct IndexedHeap *const restrict heap);
+
+/*
+ * Heap key
+ *
+ * The key of an item in the heap.
+ */
+long long heap_key(const struct IndexedHeap *const restrict heap,
+                   const int item);
+
+/*
+ * Heap push
+ *
+ * Adds an item that isn't already in the heap.
+ */
+void heap_push(struct IndexedHeap *const restrict heap,
+               const int item,
+               const long long key);
+
+/*
+ * Heap pop
+ *
+ * Takes the item on top out of the heap and returns it, the heap
+ * mustn't be empty.
+ */
+int heap_pop(struct IndexedHeap *const restrict heap);
+
+/*
+ * Heap decrease key
+ *
+ * Gives an item in the heap a smaller key, moving it up.
+ */
+void heap_decrease_key(struct IndexedHeap *const restrict heap,
+                       const int item,
+                       const long long key);
+
+/*
+ * Heap remove
+ *
+ * Takes an item in the heap out, wherever it is.
+ */
+void heap_remove(struct IndexedHeap *const restrict heap, const int item);
+
+#endif
@@ -0,0 +1,332 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+
+#include "burst_predictor.h"
+#include "indexed_heap.h"
+#include "io_scheduler.h"
+
+/*
+ * IoQueues
+ *
+ * Where every process that has arrived and isn't finished is, numbered
+ * by index in the process table. A process's burst_time_remaining is
+ * what's left of the CPU burst it's on.
+ *
+ * phase - Index into the process's phases of the CPU burst it's on.
+ * blocked - Processes doing I/O, keyed on when it completes.
+ * shortest - The ready queue for SJF, keyed on the CPU burst, or on
+ *            the prediction of it if predicting.
+ * predicting - Whether SJF goes on predicted bursts, from predictor.
+ * fifo - The ready queue for round robin, a ring of fifo_count
+ *        processes starting at fifo_head. Every process is in it at
+ *        most once, so it never needs more than one slot for each.
+ * next_arrival - Index of the next process that hasn't arrived yet.
+ */
+struct IoQueues {
+  struct ProcessEntry *process_table;
+  const int *phases;
+  int total_processes;
+  enum IoPolicy policy;
+
+  int *phase;
+  struct IndexedHeap blocked;
+  struct IndexedHeap shortest;
+  bool predicting;
+  struct BurstPredictor predictor;
+
+  int *fifo;
+  int fifo_head;
+  int fifo_count;
+
+  int next_arrival;
+};
+
+// Forward defines.
+static void make_ready(struct IoQueues *const restrict queues,
+                       const int process);
+static bool ready_is_empty(const struct IoQueues *const restrict queues);
+static int take_ready(struct IoQueues *const restrict queues);
+static void admit_events(struct IoQueues *const restrict queues,
+                         const long long cpu_time);
+static long long next_event(const struct IoQueues *const restrict queues);
+static bool start_io(struct IoQueues *const restrict queues,
+                     const int process,
+                     const long long cpu_time);
+
+/*
+ * io_scheduler
+ *
+ * Moves from turn to turn, each turn running the process at the front
+ * of the ready queue until its CPU burst is done, or its quantum is up
+ * under round robin. Anything that happened during the turn joins the
+ * ready queue at the end of it. When nothing is ready the CPU is idle
+ * until the next arrival or I/O completion.
+ *
+ * Each turn costs a dispatch, and a context switch if the process
+ * isn't the one that just had the CPU.
+ */
+void io_scheduler(struct ProcessEntry *const restrict process_table,
+                  const int total_processes,
+                  const struct SchedulerParameters *const restrict parameters,
+                  const enum IoPolicy policy) {
+
+  assert(process_table != NULL);
+
+  struct IoQueues queues;
+  queues.process_table = process_table;
+  queues.phases = parameters->phases;
+  queues.total_processes = total_processes;
+  queues.policy = policy;
+  queues.fifo_head = 0;
+  queues.fifo_count = 0;
+  queues.next_arrival = 0;
+  queues.predicting = (policy == IO_POLICY_SJF &&
+                       parameters->prediction_weight > 0);
+
+  queues.phase = calloc(total_processes, sizeof(int));
+  queues.fifo = malloc(sizeof(int) * total_processes);
+  assert(queues.phase != NULL);
+  assert(queues.fifo != NULL);
+
+  init_indexed_heap(&queues.blocked, total_processes);
+  init_indexed_heap(&queues.shortest, total_processes);
+
+  if (queues.predicting) {
+    init_burst_predictor(&queues.predictor, process_table, total_processes,
+                         parameters);
+  }
+
+  // Processes with I/O start on their first CPU burst, not all of it.
+  for (int i = 0; i < total_processes; i++) {
+    if (process_table[i].phase_count > 0) {
+      process_table[i].burst_time_remaining =
+          queues.phases[process_table[i].first_phase];
+    }
+  }
+
+  long long cpu_time = process_table[0].arrival_time;
+  int processes_remaining = total_processes;
+  int last_run = -1;
+
+  while (processes_remaining > 0) {
+    admit_events(&queues, cpu_time);
+
+    if (ready_is_empty(&queues)) {
+      // Nothing to do until something arrives or finishes its I/O.
+      cpu_time = next_event(&queues);
+      last_run = -1;
+    } else {
+      const int running = take_ready(&queues);
+      struct ProcessEntry *const process = &process_table[running];
+
+      cpu_time += parameters->dispatch_cost;
+      process->dispatch_count++;
+
+      if (running != last_run) {
+        cpu_time += parameters->switch_cost;
+        process->switch_count++;
+        last_run = running;
+      }
+
+      int turn_length = process->burst_time_remaining;
+
+      if (policy == IO_POLICY_RR && turn_length > parameters->quantum) {
+        turn_length = parameters->quantum;
+      }
+
+      cpu_time += turn_length;
+      process->burst_time_remaining -= turn_length;
+
+      if (parameters->timeline != NULL) {
+        add_timeline_slice(parameters->timeline, running,
+                           cpu_time - turn_length, cpu_time);
+      }
+
+      // Anything that turned up during the turn is ahead of it, and
+      // predicted before the burst that just finished is known.
+      admit_events(&queues, cpu_time);
+
+      if (queues.predicting) {
+        record_burst(&queues.predictor, running, turn_length);
+      }
+
+      if (process->burst_time_remaining > 0) {
+        make_ready(&queues, running);
+      } else if (!start_io(&queues, running, cpu_time)) {
+        process->turnaround_time = cpu_time - process->arrival_time;
+        process->waiting_time = process->turnaround_time -
+            process->burst_time - process->io_time;
+        --processes_remaining;
+      }
+    }
+  }
+
+  if (queues.predicting) {
+    destroy_burst_predictor(&queues.predictor);
+  }
+
+  destroy_indexed_heap(&queues.shortest);
+  destroy_indexed_heap(&queues.blocked);
+  free(queues.fifo);
+  free(queues.phase);
+}
+
+/*
+ * make_ready
+ *
+ * Puts a process at the back of the ready queue, or in its place for
+ * SJF. A predicted burst is predicted as the process joins.
+ */
+static void make_ready(struct IoQueues *const restrict queues,
+                       const int process) {
+  if (queues->policy == IO_POLICY_SJF) {
+    long long burst = queues->process_table[process].burst_time_remaining;
+
+    if (queues->predicting) {
+      burst = predict_burst(&queues->predictor, process);
+    }
+
+    heap_push(&queues->shortest, process, burst);
+  } else {
+    int tail = queues->fifo_head + queues->fifo_count;
+
+    if (tail >= queues->total_processes) {
+      tail -= queues->total_processes;
+    }
+
+    queues->fifo[tail] = process;
+    ++queues->fifo_count;
+  }
+}
+
+/*
+ * ready_is_empty
+ *
+ * True if nothing is waiting for the CPU.
+ */
+static bool ready_is_empty(const struct IoQueues *const restrict queues) {
+  bool result;
+
+  if (queues->policy == IO_POLICY_SJF) {
+    result = heap_is_empty(&queues->shortest);
+  } else {
+    result = (queues->fifo_count == 0);
+  }
+
+  return result;
+}
+
+/*
+ * take_ready
+ *
+ * Takes the process that gets the CPU next out of the ready queue.
+ */
+static int take_ready(struct IoQueues *const restrict queues) {
+  int process;
+
+  if (queues->policy == IO_POLICY_SJF) {
+    process = heap_pop(&queues->shortest);
+  } else {
+    process = queues->fifo[queues->fifo_head];
+
+    ++queues->fifo_head;
+    if (queues->fifo_head == queues->total_processes) {
+      queues->fifo_head = 0;
+    }
+    --queues->fifo_count;
+  }
+
+  return process;
+}
+
+/*
+ * admit_events
+ *
+ * Everything that has arrived or finished its I/O by cpu_time joins
+ * the ready queue, in the order it happened.
+ */
+static void admit_events(struct IoQueues *const restrict queues,
+                         const long long cpu_time) {
+  bool keep_going = true;
+
+  while (keep_going) {
+    const bool arrived = queues->next_arrival < queues->total_processes &&
+        queues->process_table[queues->next_arrival].arrival_time <=
+        cpu_time;
+    const bool unblocked = !heap_is_empty(&queues->blocked) &&
+        heap_top_key(&queues->blocked) <= cpu_time;
+
+    if (arrived &&
+        (!unblocked ||
+         queues->process_table[queues->next_arrival].arrival_time <=
+         heap_top_key(&queues->blocked))) {
+      make_ready(queues, queues->next_arrival);
+      ++queues->next_arrival;
+    } else if (unblocked) {
+      make_ready(queues, heap_pop(&queues->blocked));
+    } else {
+      keep_going = false;
+    }
+  }
+}
+
+/*
+ * next_event
+ *
+ * When the next process arrives or finishes its I/O. There must be
+ * one, or there'd be nothing left to schedule.
+ */
+static long long next_event(const struct IoQueues *const restrict queues) {
+  assert(queues->next_arrival < queues->total_processes ||
+         !heap_is_empty(&queues->blocked));
+
+  long long result = 0;
+
+  if (queues->next_arrival < queues->total_processes) {
+    result = queues->process_table[queues->next_arrival].arrival_time;
+
+    if (!heap_is_empty(&queues->blocked) &&
+        heap_top_key(&queues->blocked) < result) {
+      result = heap_top_key(&queues->blocked);
+    }
+  } else {
+    result = heap_top_key(&queues->blocked);
+  }
+
+  return result;
+}
+
+/*
+ * start_io
+ *
+ * The process has finished a CPU burst, if it has I/O to do next it's
+ * blocked until that's done, and set up for the CPU burst after.
+ * Returns false if that was its last burst.
+ */
+static bool start_io(struct IoQueues *const restrict queues,
+                     const int process,
+                     const long long cpu_time) {
+  struct ProcessEntry *const entry = &queues->process_table[process];
+  const int next_io = queues->phase[process] + 1;
+  bool result = false;
+
+  if (next_io < entry->phase_count) {
+    const int *const phases = &queues->phases[entry->first_phase];
+
+    heap_push(&queues->blocked, process, cpu_time + phases[next_io]);
+
+    queues->phase[process] = next_io + 1;
+    entry->burst_time_remaining = phases[next_io + 1];
+    result = true;
+  }
+
+  return result;
+}
@@ -0,0 +1,60 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * For traces where processes go off and do I/O between CPU bursts.
+ * Processes doing I/O are blocked, and join the ready queue again
+ * when it completes. Any number of processes can be doing I/O at
+ * once, so it all overlaps with the CPU and with each other.
+ */
+
+#ifndef IO_SCHEDULER_H_
+#define IO_SCHEDULER_H_
+
+#include "process_entry.h"
+#include "scheduler_parameters.h"
+
+/*
+ * IoPolicy
+ *
+ * How the next process is picked from the ready queue.
+ *
+ * IO_POLICY_SJF - The one with the shortest next CPU burst, which it
+ *                 then runs all of. If the parameters are predicting,
+ *                 the one whose next burst is predicted to be
+ *                 shortest.
+ * IO_POLICY_RR - First come first served, running for at most a
+ *                quantum before going to the back of the queue.
+ */
+enum IoPolicy {
+  IO_POLICY_SJF,
+  IO_POLICY_RR
+};
+
+/*
+ * IO Scheduler
+ *
+ * Takes a pointer to an array of ProcessEntries, with their phases in
+ * the parameters, and schedules their CPU bursts with the given
+ * policy. Processes with no phases are a single CPU burst.
+ *
+ * Arrivals, and processes finishing I/O, join the ready queue in the
+ * order they happen, arrivals first when they're at the same time.
+ * With round robin anything that joins while a process is running
+ * goes ahead of it if it's preempted.
+ *
+ * Waiting time is only time spent in the ready queue, time doing I/O
+ * doesn't count.
+ *
+ * The array being passed in is expected to be sorted.
+ *
+ * When the scheduler is run, it will update the process entries with
+ * turnaround and waiting times. (Mutable data!)
+ */
+void io_scheduler(struct ProcessEntry *const restrict process_table,
+                  const int total_processes,
+                  const struct SchedulerParameters *const restrict parameters,
+                  const enum IoPolicy policy);
+
+#endif
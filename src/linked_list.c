@@ -16,16 +16,30 @@
 #include "linked_list.h"
 
 #include <assert.h>
+#include <limits.h>
 #include <stdlib.h>
+#include <string.h>
 
 // Forward decs
 static void remove_head_from_list(struct LinkedList *const restrict list);
+static enum ProcessEntryError total_phases(const int burst_time,
+                                           const int *const restrict
+                                           io_phases,
+                                           const int io_phase_count,
+                                           int *const restrict cpu_time,
+                                           int *const restrict io_time);
+static void add_phases(struct LinkedList *const restrict list,
+                       const int burst_time,
+                       const int *const restrict io_phases,
+                       const int io_phase_count);
 
 void init_list(struct LinkedList *const restrict list) {
   list->head = NULL;
   list->tail = NULL;
-  list->current_node = NULL;
   list->count = 0;
+  list->phases = NULL;
+  list->phase_count = 0;
+  list->phase_capacity = 0;
 }
 
 void destroy_list(struct LinkedList *const restrict list) {
@@ -33,13 +47,19 @@ void destroy_list(struct LinkedList *const restrict list) {
     remove_head_from_list(list);
   }
 
+  free(list->phases);
+
   // Reset
   init_list(list);
 }
 
 int add_to_list(struct LinkedList *const restrict list,
                 const int arrival_time,
-                const int burst_time) {
+                const int burst_time,
+                const int priority,
+                const int tickets,
+                const int *const restrict io_phases,
+                const int io_phase_count) {
 
   enum LinkedListError error = LIST_ERR_NONE;
 
@@ -50,8 +70,18 @@ int add_to_list(struct LinkedList *const restrict list,
   // this means isn't something this program can handle.
   assert(new_list_node != NULL);
 
+  int cpu_time = burst_time;
+  int io_time = 0;
+
   enum ProcessEntryError process_entry_error =
-      init_process_entry(&new_list_node->process, arrival_time, burst_time);
+      total_phases(burst_time, io_phases, io_phase_count, &cpu_time,
+                   &io_time);
+
+  if (process_entry_error == PROCESS_ENTRY_ERR_NONE) {
+    process_entry_error =
+        init_process_entry(&new_list_node->process, arrival_time, cpu_time,
+                           priority, tickets);
+  }
 
   /*
    * If there are any errors, then free the new list node and return
@@ -66,7 +96,22 @@ int add_to_list(struct LinkedList *const restrict list,
       error = LIST_ERR_BURST;
       free(new_list_node);
       break;
+    case PROCESS_ENTRY_ERR_TICKETS:
+      error = LIST_ERR_TICKETS;
+      free(new_list_node);
+      break;
+    case PROCESS_ENTRY_ERR_PHASES:
+      error = LIST_ERR_PHASES;
+      free(new_list_node);
+      break;
     case PROCESS_ENTRY_ERR_NONE:
+      if (io_phase_count > 0) {
+        new_list_node->process.first_phase = list->phase_count;
+        new_list_node->process.phase_count = io_phase_count + 1;
+        new_list_node->process.io_time = io_time;
+        add_phases(list, burst_time, io_phases, io_phase_count);
+      }
+
       new_list_node->next = NULL;
 
       if (list->tail != NULL) {
@@ -114,44 +159,37 @@ void remove_from_list(struct LinkedList *const restrict list,
     to_remove->next->previous = to_remove->previous;
   }
 
-  // Update the iterator if we're removing a node it's on.
-  if (to_remove == list->current_node) {
-    if (to_remove->next != NULL) {
-      list->current_node = to_remove->next;
-    } else {
-      list->current_node = list->head;
-    }
-  }
-
   free(to_remove);
   --list->count;
 }
 
-void reset_list_iterator(struct LinkedList *const restrict list) {
-  list->current_node = list->head;
+void init_list_iterator(const struct LinkedList *const restrict list,
+                        struct LinkedListIterator *const restrict iterator) {
+  iterator->current_node = list->head;
 }
 
-bool has_value(const struct LinkedList *const restrict list) {
+bool has_value(const struct LinkedListIterator *const restrict iterator) {
   bool result = false;
 
-  if (list->current_node != NULL) {
+  if (iterator->current_node != NULL) {
     result = true;
   }
 
   return result;
 }
 
-void next_list_item(struct LinkedList *const restrict list) {
-  if (list->current_node != NULL) {
-    list->current_node = list->current_node->next;
+void next_list_item(struct LinkedListIterator *const restrict iterator) {
+  if (iterator->current_node != NULL) {
+    iterator->current_node = iterator->current_node->next;
   }
 }
 
-struct ProcessEntry *node_value(struct LinkedList *const restrict list) {
-  struct ProcessEntry *result = NULL;
+const struct ProcessEntry *node_value(
+    const struct LinkedListIterator *const restrict iterator) {
+  const struct ProcessEntry *result = NULL;
 
-  if (list->current_node != NULL) {
-    result = &list->current_node->process;
+  if (iterator->current_node != NULL) {
+    result = &iterator->current_node->process;
   }
 
   return result;
@@ -179,3 +217,81 @@ static void remove_head_from_list(struct LinkedList *const restrict list) {
     free(old_head);
   }
 }
+
+/*
+ * total_phases
+ *
+ * Checks the bursts after the first are all at least one, and there's
+ * a CPU burst after every I/O one, then works out how long the
+ * process spends on the CPU and doing I/O in total.
+ */
+static enum ProcessEntryError total_phases(const int burst_time,
+                                           const int *const restrict
+                                           io_phases,
+                                           const int io_phase_count,
+                                           int *const restrict cpu_time,
+                                           int *const restrict io_time) {
+  enum ProcessEntryError error = PROCESS_ENTRY_ERR_NONE;
+
+  long long cpu_total = burst_time;
+  long long io_total = 0;
+
+  if (io_phase_count % 2 != 0) {
+    error = PROCESS_ENTRY_ERR_PHASES;
+  } else if (io_phase_count > 0 && burst_time < 1) {
+    error = PROCESS_ENTRY_ERR_BURST;
+  }
+
+  for (int i = 0; i < io_phase_count && error == PROCESS_ENTRY_ERR_NONE;
+       i++) {
+    if (io_phases[i] < 1) {
+      error = PROCESS_ENTRY_ERR_PHASES;
+    } else if (i % 2 == 0) {
+      io_total += io_phases[i];
+    } else {
+      cpu_total += io_phases[i];
+    }
+  }
+
+  if (cpu_total > INT_MAX || io_total > INT_MAX) {
+    error = PROCESS_ENTRY_ERR_PHASES;
+  }
+
+  if (error == PROCESS_ENTRY_ERR_NONE) {
+    *cpu_time = (int) cpu_total;
+    *io_time = (int) io_total;
+  }
+
+  return error;
+}
+
+/*
+ * add_phases
+ *
+ * Appends a process's bursts to the list's phases, the first CPU burst
+ * then the rest.
+ */
+static void add_phases(struct LinkedList *const restrict list,
+                       const int burst_time,
+                       const int *const restrict io_phases,
+                       const int io_phase_count) {
+  const int needed = list->phase_count + io_phase_count + 1;
+
+  if (needed > list->phase_capacity) {
+    int new_capacity = (list->phase_capacity > 0) ?
+        list->phase_capacity : 64;
+
+    while (new_capacity < needed) {
+      new_capacity *= 2;
+    }
+
+    list->phases = realloc(list->phases, sizeof(int) * new_capacity);
+    assert(list->phases != NULL);
+    list->phase_capacity = new_capacity;
+  }
+
+  list->phases[list->phase_count] = burst_time;
+  memcpy(&list->phases[list->phase_count + 1], io_phases,
+         sizeof(int) * io_phase_count);
+  list->phase_count = needed;
+}
@@ -17,7 +17,9 @@
 enum LinkedListError {
   LIST_ERR_NONE = 0,
   LIST_ERR_ARRIVAL,
-  LIST_ERR_BURST
+  LIST_ERR_BURST,
+  LIST_ERR_TICKETS,
+  LIST_ERR_PHASES
 };
 
 struct LinkedListNode {
@@ -26,14 +28,36 @@ struct LinkedListNode {
   struct ProcessEntry process;
 };
 
+/*
+ * LinkedList
+ *
+ * The CPU and I/O bursts of processes that have more than one are
+ * kept together in phases, each process knows where its own start.
+ * They stay with the list until it's destroyed, even once the nodes
+ * have been removed.
+ */
 struct LinkedList {
   struct LinkedListNode *head;
   struct LinkedListNode *tail;
 
   int count;
 
-  // For stepping through the list.
-  struct LinkedListNode *current_node;
+  int *phases;
+  int phase_count;
+  int phase_capacity;
+};
+
+/*
+ * LinkedListIterator
+ *
+ * Iteration state is kept outside of the list, so any number of
+ * traversals can be active at once. The iterator never modifies the
+ * list, so once a list has been loaded it can be shared between
+ * threads, each walking it with their own iterator, as long as no
+ * thread adds or removes nodes while that is happening.
+ */
+struct LinkedListIterator {
+  const struct LinkedListNode *current_node;
 };
 
 /*
@@ -57,10 +81,18 @@ void destroy_list(struct LinkedList *const restrict list);
  * Description:
  *   Given a pointer to a list, and a pointer to the
  *   process information, add it to the list.
+ *
+ *   io_phases are the bursts after burst_time, alternating I/O and
+ *   CPU, so there must be an even number of them. NULL with a count
+ *   of 0 for a process that's just the one CPU burst.
   */
 int add_to_list(struct LinkedList *const restrict list,
                 const int arrival_time,
-                const int burst_time);
+                const int burst_time,
+                const int priority,
+                const int tickets,
+                const int *const restrict io_phases,
+                const int io_phase_count);
 
 /*
  * Remove from list.
@@ -75,28 +107,30 @@ void remove_from_list(struct LinkedList *const restrict list,
  */
 
 /*
- * Reset the internal list iterator to the start of the list.
+ * Set the given iterator to the start of the list.
  */
-void reset_list_iterator(struct LinkedList *const restrict list);
+void init_list_iterator(const struct LinkedList *const restrict list,
+                        struct LinkedListIterator *const restrict iterator);
 
 /*
- * Given a list, returns true if there is a value to be read, NULL
- * otherwise.
+ * Given an iterator, returns true if there is a value to be read,
+ * false otherwise.
  */
-bool has_value(const struct LinkedList *const restrict list);
+bool has_value(const struct LinkedListIterator *const restrict iterator);
 
 /*
- * Moves the given list onto the next item. It is expected that
+ * Moves the given iterator onto the next item. It is expected that
  * has_value has been called first to check that there is a next value
  * to move onto.
  */
-void next_list_item(struct LinkedList *const restrict list);
+void next_list_item(struct LinkedListIterator *const restrict iterator);
 
 /*
- * Will return the ProcessEntry that the list iterator currently
- * points to. Expected that reset_list_iterator has been called to set
+ * Will return the ProcessEntry that the iterator currently points
+ * to. Expected that init_list_iterator has been called to set
  * everything up.
  */
-struct ProcessEntry *node_value(struct LinkedList *const restrict list);
+const struct ProcessEntry *node_value(
+    const struct LinkedListIterator *const restrict iterator);
 
 #endif
@@ -0,0 +1,15 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Mainline of the lottery scheduler.
+ */
+
+#include "lottery_scheduler.h"
+#include "scheduler_program.h"
+
+int main(int argc, char *argv[]) {
+  return scheduler_program(argc, argv, &lottery_scheduler, "LOTTERY",
+                           "Lottery Simulation: ");
+}
@@ -0,0 +1,101 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "fenwick_tree.h"
+#include "lottery_scheduler.h"
+#include "prng.h"
+
+/*
+ * lottery_scheduler
+ *
+ * A Fenwick tree holds the tickets of each process that's waiting,
+ * and nothing for the rest, so a drawn ticket is found in O(log n).
+ *
+ * The generator is seeded again at the start of every busy period,
+ * from the seed and the time, so the draws for a busy period don't
+ * depend on anything scheduled before it.
+ *
+ * Each turn costs a dispatch, and a context switch if the process
+ * isn't the one that just had the CPU.
+ */
+void lottery_scheduler(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  assert(process_table != NULL);
+
+  long long *const tickets = calloc(total_processes + 1, sizeof(long long));
+  assert(tickets != NULL);
+
+  long long cpu_time = process_table[0].arrival_time;
+  long long total_tickets = 0;
+  int next_arrival = 0;
+  int processes_remaining = total_processes;
+  int last_run = -1;
+
+  struct Prng prng;
+  seed_prng(&prng, parameters->seed + (uint64_t) cpu_time);
+
+  while (processes_remaining > 0) {
+    while (next_arrival < total_processes &&
+           process_table[next_arrival].arrival_time <= cpu_time) {
+      fenwick_add(tickets, total_processes, next_arrival,
+                  process_table[next_arrival].tickets);
+      total_tickets += process_table[next_arrival].tickets;
+      ++next_arrival;
+    }
+
+    if (total_tickets == 0) {
+      // Nothing to do until the next process turns up.
+      cpu_time = process_table[next_arrival].arrival_time;
+      last_run = -1;
+      seed_prng(&prng, parameters->seed + (uint64_t) cpu_time);
+    } else {
+      const int process_to_run =
+          fenwick_find(tickets, total_processes,
+                       random_below(&prng, total_tickets));
+      struct ProcessEntry *const process = &process_table[process_to_run];
+
+      cpu_time += parameters->dispatch_cost;
+      process->dispatch_count++;
+
+      if (process_to_run != last_run) {
+        cpu_time += parameters->switch_cost;
+        process->switch_count++;
+        last_run = process_to_run;
+      }
+
+      const int run_time = (process->burst_time_remaining <
+                            parameters->quantum) ?
+          process->burst_time_remaining : parameters->quantum;
+
+      cpu_time += run_time;
+      process->burst_time_remaining -= run_time;
+
+      if (parameters->timeline != NULL) {
+        add_timeline_slice(parameters->timeline, process_to_run,
+                           cpu_time - run_time, cpu_time);
+      }
+
+      if (process->burst_time_remaining == 0) {
+        fenwick_add(tickets, total_processes, process_to_run,
+                    -process->tickets);
+        total_tickets -= process->tickets;
+
+        process->turnaround_time = cpu_time - process->arrival_time;
+        process->waiting_time = process->turnaround_time -
+            process->burst_time;
+        --processes_remaining;
+      }
+    }
+  }
+
+  free(tickets);
+}
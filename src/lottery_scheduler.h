@@ -0,0 +1,35 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The lottery scheduler, a proportional share scheduler. Each turn
+ * goes to a process picked at random, weighted by its tickets.
+ */
+
+#ifndef LOTTERY_SCHEDULER_H_
+#define LOTTERY_SCHEDULER_H_
+
+#include "process_entry.h"
+#include "scheduler_parameters.h"
+
+/*
+ * Lottery Scheduler
+ *
+ * Takes a pointer to an array of ProcessEntries and runs a lottery
+ * scheduler on it. Every turn, of up to the quantum, a ticket is drawn
+ * from all the tickets held by processes that are waiting, and the
+ * process holding it runs. The draws come from the seed in the
+ * parameters, the same seed always gives the same schedule.
+ *
+ * The array being passed in is expected to be sorted.
+ *
+ * When the scheduler is run, it will update the process entries with
+ * turnaround and waiting times. (Mutable data!)
+ */
+void lottery_scheduler(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters);
+
+#endif
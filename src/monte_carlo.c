@@ -0,0 +1,310 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Replica r is done by worker r modulo the number of workers, in a
+ * table of the worker's own, and its averages go in slot r of the
+ * results. The results are only added up once every worker is done,
+ * in replica order, so the sums come out the same whichever thread
+ * did which replica.
+ *
+ * The intervals use the normal approximation, mean plus or minus 1.96
+ * standard errors, which wants a few dozen replicas at least.
+ */
+
+// For sysconf.
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <limits.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "monte_carlo.h"
+#include "prng.h"
+#include "statistics.h"
+#include "worker_pool.h"
+
+#define TWO_PI 6.283185307179586
+
+/*
+ * WhatIfRun
+ *
+ * Everything the workers need, only the results are written, and each
+ * worker only writes the slots of its own replicas.
+ */
+struct WhatIfRun {
+  const struct Trace *trace;
+  Scheduler scheduler;
+  const struct SchedulerParameters *parameters;
+  const struct WhatIf *what_if;
+  int total_workers;
+
+  double *waiting_times;
+  double *turnaround_times;
+};
+
+// Forward decs
+static void run_replicas(void *run_in, const int worker);
+static void jitter_replica(const struct WhatIfRun *const restrict run,
+                           const int replica,
+                           struct ProcessEntry *const restrict entries,
+                           int *const restrict phases);
+static int jitter_burst(struct Prng *const restrict prng,
+                        const struct WhatIf *const restrict what_if,
+                        const int burst);
+static void mean_and_margin(const double *const restrict values,
+                            const int count,
+                            double *const restrict mean,
+                            double *const restrict margin);
+
+int what_if_threads(const int sharing) {
+  long threads = sysconf(_SC_NPROCESSORS_ONLN) / sharing;
+
+  if (threads < 1) {
+    threads = 1;
+  } else if (threads > MONTE_CARLO_MAX_THREADS) {
+    threads = MONTE_CARLO_MAX_THREADS;
+  }
+
+  return (int) threads;
+}
+
+struct WhatIfResult what_if_trace(
+    const struct Trace *const restrict trace,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters,
+    const struct WhatIf *const restrict what_if,
+    const int threads) {
+
+  struct WhatIfResult result = {0, 0.0, 0.0, 0.0, 0.0};
+
+  if (trace->count > 0 && what_if->replicas > 0) {
+    struct SchedulerParameters replica_parameters = *parameters;
+    replica_parameters.timeline = NULL;
+
+    struct WhatIfRun run;
+    run.trace = trace;
+    run.scheduler = scheduler_to_use;
+    run.parameters = &replica_parameters;
+    run.what_if = what_if;
+    run.total_workers = (threads < what_if->replicas) ?
+        threads : what_if->replicas;
+
+    run.waiting_times = malloc(sizeof(double) * what_if->replicas);
+    run.turnaround_times = malloc(sizeof(double) * what_if->replicas);
+    assert(run.waiting_times != NULL);
+    assert(run.turnaround_times != NULL);
+
+    if (run.total_workers > 1) {
+      struct WorkerPool pool;
+      init_worker_pool(&pool, run.total_workers, &run_replicas, &run);
+      run_batch(&pool);
+      destroy_worker_pool(&pool);
+    } else {
+      run_replicas(&run, 0);
+    }
+
+    result.replicas = what_if->replicas;
+    mean_and_margin(run.waiting_times, what_if->replicas,
+                    &result.waiting_time, &result.waiting_margin);
+    mean_and_margin(run.turnaround_times, what_if->replicas,
+                    &result.turnaround_time, &result.turnaround_margin);
+
+    free(run.turnaround_times);
+    free(run.waiting_times);
+  }
+
+  return result;
+}
+
+struct WhatIfResult run_what_if(
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters,
+    const struct WhatIf *const restrict what_if,
+    const int threads) {
+  struct Trace trace;
+  struct WhatIfResult result = {0, 0.0, 0.0, 0.0, 0.0};
+
+  if (!load_trace(filename, &trace)) {
+    perror("main() - File Error");
+  } else {
+    struct SchedulerParameters file_parameters = *parameters;
+    file_parameters.quantum = trace.quantum;
+
+    result = what_if_trace(&trace, scheduler_to_use, &file_parameters,
+                           what_if, threads);
+
+    destroy_trace(&trace);
+  }
+
+  return result;
+}
+
+int format_what_if(char *const restrict buffer, const size_t size,
+                   const struct WhatIfResult *const restrict result) {
+  return snprintf(buffer, size,
+                  "Over %d replicas, 95%% intervals: "
+                  "Waiting %.2f +/- %.2f. Turnaround %.2f +/- %.2f\n",
+                  result->replicas,
+                  result->waiting_time, result->waiting_margin,
+                  result->turnaround_time, result->turnaround_margin);
+}
+
+/*
+ * run_replicas
+ *
+ * The worker function, schedules each of the worker's replicas in
+ * turn, reusing the one table. The worker allocates it itself, so it's
+ * in memory close to where the worker runs.
+ */
+static void run_replicas(void *run_in, const int worker) {
+  const struct WhatIfRun *const run = run_in;
+  const struct Trace *const trace = run->trace;
+
+  struct ProcessEntry *const entries = malloc(sizeof(struct ProcessEntry) *
+                                              trace->count);
+  assert(entries != NULL);
+
+  int *phases = NULL;
+
+  if (trace->phase_count > 0) {
+    phases = malloc(sizeof(int) * trace->phase_count);
+    assert(phases != NULL);
+  }
+
+  struct SchedulerParameters parameters = *run->parameters;
+  parameters.phases = phases;
+
+  for (int replica = worker; replica < run->what_if->replicas;
+       replica += run->total_workers) {
+    memcpy(entries, trace->entries, sizeof(struct ProcessEntry) *
+           trace->count);
+
+    if (phases != NULL) {
+      memcpy(phases, trace->phases, sizeof(int) * trace->phase_count);
+    }
+
+    jitter_replica(run, replica, entries, phases);
+
+    (*run->scheduler)(entries, trace->count, &parameters);
+
+    struct ProcessStatistics statistics;
+    init_process_statistics(&statistics);
+    add_process_statistics(&statistics, entries, trace->count);
+
+    const struct SchedulerAverages averages =
+        averages_from_statistics(&statistics, &parameters);
+
+    run->waiting_times[replica] = averages.waiting_time;
+    run->turnaround_times[replica] = averages.turnaround_time;
+  }
+
+  free(phases);
+  free(entries);
+}
+
+/*
+ * jitter_replica
+ *
+ * Jitters every CPU burst in the copy of the trace, in table order,
+ * from a generator of the replica's own. A process with I/O has each
+ * of its CPU bursts jittered, and its burst time is their new total.
+ */
+static void jitter_replica(const struct WhatIfRun *const restrict run,
+                           const int replica,
+                           struct ProcessEntry *const restrict entries,
+                           int *const restrict phases) {
+  struct Prng prng;
+  seed_prng(&prng, run->parameters->seed + (uint64_t) replica);
+
+  for (int i = 0; i < run->trace->count; i++) {
+    struct ProcessEntry *const process = &entries[i];
+
+    if (process->phase_count == 0) {
+      process->burst_time = jitter_burst(&prng, run->what_if,
+                                         process->burst_time);
+    } else {
+      int *const bursts = &phases[process->first_phase];
+      long long total = 0;
+
+      // CPU and I/O alternate, starting with CPU.
+      for (int phase = 0; phase < process->phase_count; phase += 2) {
+        bursts[phase] = jitter_burst(&prng, run->what_if, bursts[phase]);
+        total += bursts[phase];
+      }
+
+      process->burst_time = (total < INT_MAX) ? (int) total : INT_MAX;
+    }
+
+    reset_process_entry(process);
+  }
+}
+
+/*
+ * jitter_burst
+ *
+ * A normal draw comes from the Box-Muller transform, using 1 minus the
+ * first fraction so the log is never of 0. The jittered burst is
+ * rounded, and kept to at least 1.
+ */
+static int jitter_burst(struct Prng *const restrict prng,
+                        const struct WhatIf *const restrict what_if,
+                        const int burst) {
+  double deviation;
+
+  if (what_if->distribution == JITTER_NORMAL) {
+    const double radius = sqrt(-2.0 * log(1.0 - random_fraction(prng)));
+    deviation = radius * cos(TWO_PI * random_fraction(prng));
+  } else {
+    deviation = 2.0 * random_fraction(prng) - 1.0;
+  }
+
+  const double jittered =
+      burst * (1.0 + deviation * what_if->percent / 100.0) + 0.5;
+  int result = 1;
+
+  if (jittered >= INT_MAX) {
+    result = INT_MAX;
+  } else if (jittered >= 1.0) {
+    result = (int) jittered;
+  }
+
+  return result;
+}
+
+/*
+ * mean_and_margin
+ *
+ * The mean of the values, and the half width of the 95% interval on
+ * it, from their sample standard deviation. A single value has no
+ * spread to go on, so its margin is 0.
+ */
+static void mean_and_margin(const double *const restrict values,
+                            const int count,
+                            double *const restrict mean,
+                            double *const restrict margin) {
+  double sum = 0.0;
+
+  for (int i = 0; i < count; i++) {
+    sum += values[i];
+  }
+
+  *mean = sum / count;
+  *margin = 0.0;
+
+  if (count > 1) {
+    double squares = 0.0;
+
+    for (int i = 0; i < count; i++) {
+      squares += (values[i] - *mean) * (values[i] - *mean);
+    }
+
+    *margin = 1.96 * sqrt(squares / (count - 1) / count);
+  }
+}
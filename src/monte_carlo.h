@@ -0,0 +1,117 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   What if runs, scheduling many copies of a trace with their bursts
+ *   jittered, to see how much the averages depend on the bursts being
+ *   exactly right.
+ */
+
+#ifndef MONTE_CARLO_H_
+#define MONTE_CARLO_H_
+
+#include <stddef.h>
+
+#include "scheduler.h"
+#include "scheduler_parameters.h"
+
+/*
+ * Most threads the replicas can be shared between.
+ */
+#define MONTE_CARLO_MAX_THREADS 64
+
+/*
+ * How bursts are jittered.
+ */
+enum JitterDistribution {
+  JITTER_UNIFORM,
+  JITTER_NORMAL
+};
+
+/*
+ * WhatIf
+ *
+ * replicas - How many jittered copies of the trace to schedule, 0 for
+ *            no what if runs.
+ * percent - How much the bursts are jittered, as a percentage of each
+ *           burst. Uniform jitter is anywhere up to that much shorter
+ *           or longer, normal jitter has that standard deviation.
+ *           Bursts never go below 1.
+ */
+struct WhatIf {
+  int replicas;
+  int percent;
+  enum JitterDistribution distribution;
+};
+
+/*
+ * WhatIfResult
+ *
+ * The mean over the replicas of their average waiting and turnaround
+ * times, and the half width of a 95% confidence interval on each.
+ */
+struct WhatIfResult {
+  int replicas;
+  double waiting_time;
+  double waiting_margin;
+  double turnaround_time;
+  double turnaround_margin;
+};
+
+/*
+ * What if threads
+ *
+ * How many threads to run replicas on, when sharing is how many
+ * callers are running what if runs at the same time. The CPUs that
+ * are online, split between them, at least 1 each.
+ */
+int what_if_threads(const int sharing);
+
+/*
+ * What if trace
+ *
+ * Schedules what_if->replicas copies of the loaded trace, each with
+ * its bursts jittered, on up to threads threads. Each replica has its
+ * own generator, seeded from the seed in the parameters and its
+ * number, so the results are the same for the same seed however many
+ * threads there are. The threads share nothing they write but their
+ * own replicas' results.
+ *
+ * The parameters are used as schedule_trace uses them, except that
+ * there's no timeline, and each replica is scheduled on one thread.
+ * A trace with no processes gives a result of zero.
+ */
+struct WhatIfResult what_if_trace(
+    const struct Trace *const restrict trace,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters,
+    const struct WhatIf *const restrict what_if,
+    const int threads);
+
+/*
+ * Run what if
+ *
+ * Loads the trace in the file and runs what_if_trace on it, with the
+ * quantum from the file. If the file can't be read the error is shown
+ * and the result is zero.
+ */
+struct WhatIfResult run_what_if(
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters,
+    const struct WhatIf *const restrict what_if,
+    const int threads);
+
+/*
+ * Format what if
+ *
+ * Writes the result into the buffer as a line of text. Won't write
+ * more than size characters, returns the length of the full line like
+ * snprintf does.
+ */
+int format_what_if(char *const restrict buffer, const size_t size,
+                   const struct WhatIfResult *const restrict result);
+
+#endif
@@ -0,0 +1,360 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+// For getopt.
+#define _POSIX_C_SOURCE 200809L
+
+#include <errno.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "options.h"
+#include "split_scheduler.h"
+
+// Forward decs
+static void print_usage(const char *const program_name);
+static bool parse_cost(const char *const restrict text,
+                       int *const restrict cost);
+static bool parse_seed(const char *const restrict text,
+                       uint64_t *const restrict seed);
+static bool parse_threads(const char *const restrict text,
+                          int *const restrict threads);
+static bool parse_megabytes(const char *const restrict text,
+                            int *const restrict megabytes);
+static bool parse_quanta(const char *const restrict text,
+                         struct Options *const restrict options);
+static bool parse_what_if(const char *const restrict text,
+                          struct WhatIf *const restrict what_if);
+static bool parse_prediction(const char *const restrict text,
+                             struct SchedulerParameters *const restrict
+                             parameters);
+
+/*
+ * parse_options
+ *
+ * Uses getopt, so options can only be given as single letters.
+ */
+bool parse_options(int argc, char *argv[],
+                   struct Options *const restrict options) {
+  bool result = true;
+
+  options->follow = false;
+  options->spread = false;
+  options->cache_filename = NULL;
+  options->timeline_filename = NULL;
+  options->pin = false;
+  options->socket_filename = NULL;
+  options->quanta_count = 0;
+  options->what_if.replicas = 0;
+  options->what_if.percent = 0;
+  options->what_if.distribution = JITTER_UNIFORM;
+  options->count_stages = false;
+  options->parameters.quantum = 0;
+  options->parameters.dispatch_cost = 0;
+  options->parameters.switch_cost = 0;
+  options->parameters.aging_interval = 0;
+  options->parameters.seed = 1;
+  options->parameters.timeline = NULL;
+  options->parameters.phases = NULL;
+  options->parameters.split_threads = 1;
+  options->parameters.stream = false;
+  options->parameters.sort_memory = 64;
+  options->parameters.prediction_weight = 0;
+  options->parameters.prediction_guess = 10;
+  options->parameters.counters = NULL;
+  options->parameters.loader = NULL;
+
+  const char *const option_letters = "fspobc:d:x:a:r:t:l:j:m:q:w:e:";
+  int option;
+
+  while (result && (option = getopt(argc, argv, option_letters)) != -1) {
+    switch (option) {
+      case 'f':
+        options->follow = true;
+        break;
+      case 's':
+        options->spread = true;
+        break;
+      case 'p':
+        options->pin = true;
+        break;
+      case 'o':
+        options->parameters.stream = true;
+        break;
+      case 'b':
+        options->count_stages = true;
+        break;
+      case 'c':
+        options->cache_filename = optarg;
+        break;
+      case 'd':
+        result = parse_cost(optarg, &options->parameters.dispatch_cost);
+        break;
+      case 'x':
+        result = parse_cost(optarg, &options->parameters.switch_cost);
+        break;
+      case 'a':
+        result = parse_cost(optarg, &options->parameters.aging_interval);
+        break;
+      case 'r':
+        result = parse_seed(optarg, &options->parameters.seed);
+        break;
+      case 't':
+        options->timeline_filename = optarg;
+        break;
+      case 'l':
+        options->socket_filename = optarg;
+        break;
+      case 'j':
+        result = parse_threads(optarg, &options->parameters.split_threads);
+        break;
+      case 'm':
+        result = parse_megabytes(optarg, &options->parameters.sort_memory);
+        break;
+      case 'q':
+        result = parse_quanta(optarg, options);
+        break;
+      case 'w':
+        result = parse_what_if(optarg, &options->what_if);
+        break;
+      case 'e':
+        result = parse_prediction(optarg, &options->parameters);
+        break;
+      default:
+        result = false;
+    }
+  }
+
+  if (optind < argc) {
+    result = false;
+  }
+
+  if (!result) {
+    print_usage(argv[0]);
+  }
+
+  return result;
+}
+
+/*
+ * parse_cost
+ *
+ * Costs are whole time units and can't be negative. Also used for the
+ * aging interval, which is the same sort of thing.
+ */
+static bool parse_cost(const char *const restrict text,
+                       int *const restrict cost) {
+  char *end;
+  long value = strtol(text, &end, 10);
+
+  bool result = end != text && *end == '\0' && value >= 0 && value <= 1000000;
+
+  if (result) {
+    *cost = (int)value;
+  }
+
+  return result;
+}
+
+/*
+ * parse_seed
+ *
+ * Any unsigned 64 bit number will do.
+ */
+static bool parse_seed(const char *const restrict text,
+                       uint64_t *const restrict seed) {
+  char *end;
+  errno = 0;
+  unsigned long long value = strtoull(text, &end, 10);
+
+  bool result = end != text && *end == '\0' && errno == 0 &&
+      text[0] != '-';
+
+  if (result) {
+    *seed = value;
+  }
+
+  return result;
+}
+
+/*
+ * parse_threads
+ *
+ * At least one thread, and no more than a trace can be split over.
+ */
+static bool parse_threads(const char *const restrict text,
+                          int *const restrict threads) {
+  char *end;
+  long value = strtol(text, &end, 10);
+
+  bool result = end != text && *end == '\0' && value >= 1 &&
+      value <= SPLIT_MAX_THREADS;
+
+  if (result) {
+    *threads = (int)value;
+  }
+
+  return result;
+}
+
+/*
+ * parse_megabytes
+ *
+ * At least a megabyte, and few enough that the bytes fit in a size_t
+ * on anything we'll run on.
+ */
+static bool parse_megabytes(const char *const restrict text,
+                            int *const restrict megabytes) {
+  char *end;
+  long value = strtol(text, &end, 10);
+
+  bool result = end != text && *end == '\0' && value >= 1 && value <= 4095;
+
+  if (result) {
+    *megabytes = (int)value;
+  }
+
+  return result;
+}
+
+/*
+ * parse_quanta
+ *
+ * A comma separated list of quanta, each at least 1 and no more than
+ * a cost can be. Given more than once, the lists are joined.
+ */
+static bool parse_quanta(const char *const restrict text,
+                         struct Options *const restrict options) {
+  const char *start = text;
+  bool result = true;
+  bool more = true;
+
+  while (result && more) {
+    char *end;
+    long value = strtol(start, &end, 10);
+
+    result = end != start && (*end == '\0' || *end == ',') &&
+        value >= 1 && value <= 1000000 &&
+        options->quanta_count < MAX_EXTRA_QUANTA;
+
+    if (result) {
+      options->quanta[options->quanta_count++] = (int)value;
+      more = (*end == ',');
+      start = end + 1;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * parse_what_if
+ *
+ * Replicas and percent, then optionally the distribution, uniform or
+ * normal, all separated by commas. At least one replica, and the
+ * percent can't be more than 100.
+ */
+static bool parse_what_if(const char *const restrict text,
+                          struct WhatIf *const restrict what_if) {
+  char *end;
+  long replicas = strtol(text, &end, 10);
+  bool result = end != text && *end == ',' &&
+      replicas >= 1 && replicas <= 1000000;
+
+  if (result) {
+    const char *const percent_text = end + 1;
+    long percent = strtol(percent_text, &end, 10);
+
+    result = end != percent_text && percent >= 0 && percent <= 100;
+
+    what_if->replicas = (int)replicas;
+    what_if->percent = (int)percent;
+    what_if->distribution = JITTER_UNIFORM;
+
+    if (result && *end == ',') {
+      if (strcmp(end + 1, "normal") == 0) {
+        what_if->distribution = JITTER_NORMAL;
+      } else {
+        result = strcmp(end + 1, "uniform") == 0;
+      }
+    } else if (*end != '\0') {
+      result = false;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * parse_prediction
+ *
+ * The weight as a percent from 1 to 100, then optionally a comma and
+ * the first guess, which is anything a cost can be.
+ */
+static bool parse_prediction(const char *const restrict text,
+                             struct SchedulerParameters *const restrict
+                             parameters) {
+  char *end;
+  long weight = strtol(text, &end, 10);
+  bool result = end != text && (*end == '\0' || *end == ',') &&
+      weight >= 1 && weight <= 100;
+
+  if (result) {
+    parameters->prediction_weight = (int)weight;
+
+    if (*end == ',') {
+      result = parse_cost(end + 1, &parameters->prediction_guess);
+    }
+  }
+
+  return result;
+}
+
+/*
+ * print_usage
+ *
+ * Lets the user know what options we take.
+ */
+static void print_usage(const char *const program_name) {
+  fprintf(stderr,
+          "Usage: %s [-f] [-s] [-p] [-o] [-b] [-c cache_file] [-d cost] "
+          "[-x cost] [-a interval] [-r seed] [-t timeline_file] [-l socket] "
+          "[-j threads] [-m megabytes] [-q quanta]\n"
+          "       [-w replicas,percent[,normal]] [-e weight[,guess]]\n"
+          "  -f             Follow traces that are still being written to.\n"
+          "  -s             Show the spread of times, not just averages.\n"
+          "  -p             Pin the simulator's threads to their own CPUs.\n"
+          "  -o             Schedule traces as they're read, for traces too\n"
+          "                 big to load.\n"
+          "  -b             Count cycles, instructions, cache and branch\n"
+          "                 misses in each stage of scheduling a trace.\n"
+          "  -c cache_file  Keep scheduler results in cache_file.\n"
+          "  -d cost        Time taken to dispatch a process.\n"
+          "  -x cost        Time taken to switch to a different process.\n"
+          "  -a interval    Age waiting processes by one priority every\n"
+          "                 interval, for the priority scheduler.\n"
+          "  -r seed        Seed for the lottery scheduler.\n"
+          "  -t timeline_file\n"
+          "                 Write when each process ran to timeline_file.\n"
+          "  -l socket      Unix socket for the daemon to listen on.\n"
+          "  -j threads     Split big traces where the CPU goes idle, and\n"
+          "                 schedule the pieces on this many threads.\n"
+          "  -m megabytes   Memory to sort streamed traces in.\n"
+          "  -q quanta      With -o, the simulator also runs round robin at\n"
+          "                 each of these comma separated quanta.\n"
+          "  -w replicas,percent[,normal]\n"
+          "                 Also schedule replicas of each trace with\n"
+          "                 bursts jittered by up to percent, or by a\n"
+          "                 standard deviation of percent if normal.\n"
+          "  -e weight[,guess]\n"
+          "                 SJF goes on bursts predicted from earlier ones\n"
+          "                 of the process, or its priority, each counting\n"
+          "                 weight percent, and compares with known bursts.\n",
+          program_name);
+}
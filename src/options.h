@@ -0,0 +1,78 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Command line options common to all of the scheduler programs.
+ */
+
+#ifndef OPTIONS_H_
+#define OPTIONS_H_
+
+#include <stdbool.h>
+
+#include "monte_carlo.h"
+#include "scheduler_parameters.h"
+
+/*
+ * Most extra round robin quanta that can be given.
+ */
+#define MAX_EXTRA_QUANTA 6
+
+/*
+ * Options
+ *
+ * follow - Treat each file as a trace that's still being written to,
+ *          if the same file is entered again only what has been
+ *          appended since last time is read.
+ * spread - Show the min, max and variance of the times as well as the
+ *          averages.
+ * cache_filename - File to keep scheduler results in between runs,
+ *                  NULL if results are only cached in memory.
+ * timeline_filename - File to write the timeline of each schedule to,
+ *                     NULL if there's no timeline.
+ * pin - Keep each of the simulator's scheduler threads on its own CPU.
+ * socket_filename - Unix socket for the daemon to listen on, NULL if
+ *                   not given.
+ * quanta - Extra quanta for the simulator to run round robin at,
+ *          quanta_count of them.
+ * what_if - Jittered replicas to schedule each trace as well, none if
+ *           not given.
+ * count_stages - Count cycles, instructions, cache misses and branch
+ *                misses in each stage of running a scheduler on a
+ *                trace. Not in follow mode, which has stages of its
+ *                own.
+ * parameters - Dispatch and switch costs, aging interval, seed, split
+ *              threads, streaming, sort memory and burst prediction to
+ *              give the schedulers, the quantum is left at zero as it
+ *              comes from the trace, and there's no timeline until the
+ *              file is opened, or counters or loader until they
+ *              are.
+ */
+struct Options {
+  bool follow;
+  bool spread;
+  const char *cache_filename;
+  const char *timeline_filename;
+  bool pin;
+  const char *socket_filename;
+  int quanta[MAX_EXTRA_QUANTA];
+  int quanta_count;
+  struct WhatIf what_if;
+  bool count_stages;
+  struct SchedulerParameters parameters;
+};
+
+/*
+ * Parse options
+ *
+ * Takes the arguments given to main and fills in the options
+ * structure. Any options not given are left at their defaults. Will
+ * print the usage and return false if there's anything it doesn't
+ * understand.
+ */
+bool parse_options(int argc, char *argv[],
+                   struct Options *const restrict options);
+
+#endif
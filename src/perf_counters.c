@@ -0,0 +1,205 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The counters come from perf_event_open, there's no wrapper for it in
+ * libc so it's called through syscall. Each event gets a counter of
+ * its own rather than being put in a group, so one the CPU doesn't
+ * have doesn't stop the rest being counted.
+ *
+ * With more events than the CPU has counters for, the kernel takes
+ * turns counting them, so each count is scaled up by how long the
+ * event was enabled over how long it was actually counted.
+ */
+
+// For syscall.
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "perf_counters.h"
+
+// Forward decs
+static void open_event(struct PerfCounters *const restrict counters,
+                       const enum PerfEvent event);
+static double read_event(const int fd);
+
+static const char *const STAGE_NAMES[PERF_STAGES] = {
+  "Parse", "Sort", "Schedule", "Aggregate"
+};
+
+static const char *const EVENT_NAMES[PERF_EVENTS] = {
+  "Cycles", "Instructions", "Cache misses", "Branch misses"
+};
+
+void open_perf_counters(struct PerfCounters *const restrict counters) {
+  counters->error[0] = '\0';
+
+  for (int event = 0; event < PERF_EVENTS; event++) {
+    open_event(counters, (enum PerfEvent) event);
+  }
+
+  reset_perf_counters(counters);
+}
+
+void close_perf_counters(struct PerfCounters *const restrict counters) {
+  for (int event = 0; event < PERF_EVENTS; event++) {
+    if (counters->fds[event] >= 0) {
+      close(counters->fds[event]);
+      counters->fds[event] = -1;
+    }
+  }
+}
+
+void reset_perf_counters(struct PerfCounters *const restrict counters) {
+  for (int stage = 0; stage < PERF_STAGES; stage++) {
+    for (int event = 0; event < PERF_EVENTS; event++) {
+      counters->totals[stage][event] = 0.0;
+    }
+  }
+
+  counters->records = 0;
+}
+
+void start_perf_stage(struct PerfCounters *const counters) {
+  if (counters != NULL) {
+    for (int event = 0; event < PERF_EVENTS; event++) {
+      counters->start[event] = read_event(counters->fds[event]);
+    }
+  }
+}
+
+void stop_perf_stage(struct PerfCounters *const counters,
+                     const enum PerfStage stage) {
+  if (counters != NULL) {
+    for (int event = 0; event < PERF_EVENTS; event++) {
+      counters->totals[stage][event] +=
+          read_event(counters->fds[event]) - counters->start[event];
+    }
+  }
+}
+
+int format_perf_counters(char *const restrict buffer, const size_t size,
+                         const struct PerfCounters *const restrict
+                         counters) {
+  bool any = false;
+
+  for (int event = 0; event < PERF_EVENTS; event++) {
+    any = any || counters->fds[event] >= 0;
+  }
+
+  int length;
+
+  if (!any) {
+    length = snprintf(buffer, size, "Hardware counters unavailable: %s\n",
+                      counters->error);
+  } else {
+    length = snprintf(buffer, size, "Hardware counters over %lld records, "
+                      "per record in brackets\n%-10s", counters->records,
+                      "Stage");
+
+    for (int event = 0; event < PERF_EVENTS && length < (int) size;
+         event++) {
+      length += snprintf(buffer + length, size - length, "%24s",
+                         EVENT_NAMES[event]);
+    }
+
+    for (int stage = 0; stage < PERF_STAGES && length < (int) size;
+         stage++) {
+      length += snprintf(buffer + length, size - length, "\n%-10s",
+                         STAGE_NAMES[stage]);
+
+      for (int event = 0; event < PERF_EVENTS && length < (int) size;
+           event++) {
+        const double total = counters->totals[stage][event];
+
+        if (counters->fds[event] < 0) {
+          length += snprintf(buffer + length, size - length, "%24s", "n/a");
+        } else {
+          // An empty trace has no records to count per, leave it at 0.
+          length += snprintf(buffer + length, size - length,
+                             "%13.0f (%8.2f)", total,
+                             (counters->records > 0) ?
+                             total / counters->records : 0.0);
+        }
+      }
+    }
+
+    if (length < (int) size) {
+      length += snprintf(buffer + length, size - length, "\n");
+    }
+  }
+
+  return length;
+}
+
+/*
+ * open_event
+ *
+ * Opens the counter for the event on the calling thread, counting
+ * threads it starts too, or sets it to -1 and keeps the reason if it's
+ * the first that couldn't be.
+ */
+static void open_event(struct PerfCounters *const restrict counters,
+                       const enum PerfEvent event) {
+  int fd = -1;
+  int error = ENOSYS;
+
+#ifdef __linux__
+  static const unsigned long long CONFIGS[PERF_EVENTS] = {
+    PERF_COUNT_HW_CPU_CYCLES,
+    PERF_COUNT_HW_INSTRUCTIONS,
+    PERF_COUNT_HW_CACHE_MISSES,
+    PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  struct perf_event_attr attr;
+  memset(&attr, 0, sizeof(attr));
+  attr.size = sizeof(attr);
+  attr.type = PERF_TYPE_HARDWARE;
+  attr.config = CONFIGS[event];
+  attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED |
+      PERF_FORMAT_TOTAL_TIME_RUNNING;
+  attr.inherit = 1;
+  attr.exclude_kernel = 1;
+  attr.exclude_hv = 1;
+
+  fd = (int) syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+  error = errno;
+#endif
+
+  counters->fds[event] = fd;
+
+  if (fd < 0 && counters->error[0] == '\0') {
+    snprintf(counters->error, sizeof(counters->error), "%s",
+             strerror(error));
+  }
+}
+
+/*
+ * read_event
+ *
+ * The counter's count so far, scaled for any time it wasn't being
+ * counted. 0 if there's no counter.
+ */
+static double read_event(const int fd) {
+  double result = 0.0;
+  unsigned long long values[3];
+
+  if (fd >= 0 &&
+      read(fd, values, sizeof(values)) == (ssize_t) sizeof(values) &&
+      values[2] > 0) {
+    result = (double) values[0] * values[1] / values[2];
+  }
+
+  return result;
+}
@@ -0,0 +1,126 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Optional hardware counters around each stage of running a
+ *   scheduler on a trace, to see where the time goes when wall time
+ *   alone doesn't say why.
+ */
+
+#ifndef PERF_COUNTERS_H_
+#define PERF_COUNTERS_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * The stages of running a scheduler on a trace that are counted.
+ *
+ * PERF_STAGE_PARSE - Reading the trace file into a list.
+ * PERF_STAGE_SORT - Sorting the list into a table by arrival time, and
+ *                   grouping identical processes.
+ * PERF_STAGE_SCHEDULE - Running the scheduler on the table.
+ * PERF_STAGE_AGGREGATE - Adding up the statistics and averages.
+ */
+enum PerfStage {
+  PERF_STAGE_PARSE,
+  PERF_STAGE_SORT,
+  PERF_STAGE_SCHEDULE,
+  PERF_STAGE_AGGREGATE,
+  PERF_STAGES
+};
+
+/*
+ * The counters kept for each stage.
+ */
+enum PerfEvent {
+  PERF_CYCLES,
+  PERF_INSTRUCTIONS,
+  PERF_CACHE_MISSES,
+  PERF_BRANCH_MISSES,
+  PERF_EVENTS
+};
+
+/*
+ * Size of a buffer big enough for format_perf_counters.
+ */
+#define PERF_REPORT_SIZE 640
+
+/*
+ * PerfCounters
+ *
+ * Counts for the thread that opened them, and any threads it starts
+ * once they've finished, only in user space.
+ *
+ * fds - Each event's counter, -1 if the kernel or the CPU won't count
+ *       it, say in a VM, or with perf_event_paranoid set too high.
+ * start - Each event's count when the current stage started.
+ * totals - What each stage has counted since the last reset.
+ * records - Processes in the trace the stages were run on, for the
+ *           counts per record.
+ * error - Why the first counter that couldn't be opened couldn't be,
+ *         empty if they all were.
+ */
+struct PerfCounters {
+  int fds[PERF_EVENTS];
+  double start[PERF_EVENTS];
+  double totals[PERF_STAGES][PERF_EVENTS];
+  long long records;
+  char error[128];
+};
+
+/*
+ * Open perf counters
+ *
+ * Opens whichever counters it can for the calling thread, and resets
+ * them. It's never an error if none can be opened, they're reported as
+ * unavailable instead.
+ */
+void open_perf_counters(struct PerfCounters *const restrict counters);
+
+/*
+ * Close perf counters
+ *
+ * Closes any counters that were opened.
+ */
+void close_perf_counters(struct PerfCounters *const restrict counters);
+
+/*
+ * Reset perf counters
+ *
+ * Zeroes the totals, for a new trace.
+ */
+void reset_perf_counters(struct PerfCounters *const restrict counters);
+
+/*
+ * Start perf stage
+ *
+ * Notes the counts at the start of a stage. Does nothing if counters
+ * is NULL, so callers needn't check.
+ */
+void start_perf_stage(struct PerfCounters *const counters);
+
+/*
+ * Stop perf stage
+ *
+ * Adds what's been counted since start_perf_stage to the stage's
+ * totals. Does nothing if counters is NULL.
+ */
+void stop_perf_stage(struct PerfCounters *const counters,
+                     const enum PerfStage stage);
+
+/*
+ * Format perf counters
+ *
+ * Writes a line for each stage, with each event's total and its count
+ * per record, or n/a for events that can't be counted. Just the one
+ * line saying why if none can. Won't write more than size characters,
+ * returns the length of the full text like snprintf does.
+ */
+int format_perf_counters(char *const restrict buffer, const size_t size,
+                         const struct PerfCounters *const restrict
+                         counters);
+
+#endif
@@ -0,0 +1,15 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Mainline of the priority scheduler.
+ */
+
+#include "priority_scheduler.h"
+#include "scheduler_program.h"
+
+int main(int argc, char *argv[]) {
+  return scheduler_program(argc, argv, &priority_scheduler, "PRIO",
+                           "Priority Simulation: ");
+}
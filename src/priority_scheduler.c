@@ -0,0 +1,246 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+#include "indexed_heap.h"
+#include "priority_scheduler.h"
+
+/*
+ * ReadyQueue
+ *
+ * Processes waiting for the CPU are kept in two heaps, both of them
+ * numbered by index in the process table.
+ *
+ * ready - Keyed on the priority each process has right now, so the
+ *         most important is on top.
+ * aging - Keyed on when each process next gets more important, only
+ *         used if there's aging.
+ * next_arrival - Index of the next process that hasn't arrived yet.
+ */
+struct ReadyQueue {
+  struct ProcessEntry *process_table;
+  int total_processes;
+  int aging_interval;
+
+  struct IndexedHeap ready;
+  struct IndexedHeap aging;
+  int next_arrival;
+};
+
+// Forward defines.
+static void make_ready(struct ReadyQueue *const restrict queue,
+                       const int process,
+                       const long long cpu_time);
+static void admit_arrivals(struct ReadyQueue *const restrict queue,
+                           const long long cpu_time);
+static void age_waiting(struct ReadyQueue *const restrict queue,
+                        const long long cpu_time);
+static long long next_event(const struct ReadyQueue *const restrict queue,
+                            const long long cpu_time,
+                            const int running);
+static void record_run(const struct SchedulerParameters *const restrict
+                       parameters,
+                       const int process,
+                       const long long run_start,
+                       const long long cpu_time);
+
+/*
+ * priority_scheduler
+ *
+ * Moves from event to event, an event being an arrival, a waiting
+ * process aging, or the running process finishing. At each one, if
+ * something waiting is now strictly more important than the running
+ * process, it takes over.
+ *
+ * Anything that happens while a process is being dispatched is dealt
+ * with once it's running, and can only take the CPU from it at the
+ * next event. So a process always gets to run for a while once it's
+ * been dispatched, otherwise with large costs two processes could keep
+ * taking the CPU from each other without either getting anywhere.
+ */
+void priority_scheduler(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  assert(process_table != NULL);
+
+  struct ReadyQueue queue;
+  queue.process_table = process_table;
+  queue.total_processes = total_processes;
+  queue.aging_interval = parameters->aging_interval;
+  queue.next_arrival = 0;
+
+  init_indexed_heap(&queue.ready, total_processes);
+  init_indexed_heap(&queue.aging, total_processes);
+
+  long long cpu_time = process_table[0].arrival_time;
+  int processes_remaining = total_processes;
+  int running = -1;
+  int last_run = -1;
+  long long run_start = 0;
+
+  while (processes_remaining > 0) {
+    admit_arrivals(&queue, cpu_time);
+    age_waiting(&queue, cpu_time);
+
+    if (running < 0 && heap_is_empty(&queue.ready)) {
+      // Nothing to do until the next process turns up.
+      cpu_time = process_table[queue.next_arrival].arrival_time;
+      last_run = -1;
+    } else if (running >= 0 && !heap_is_empty(&queue.ready) &&
+               heap_top_key(&queue.ready) <
+               process_table[running].priority) {
+      // Preempted, back in the queue at its own priority.
+      record_run(parameters, running, run_start, cpu_time);
+      make_ready(&queue, running, cpu_time);
+      running = -1;
+    } else {
+      if (running < 0) {
+        running = heap_pop(&queue.ready);
+
+        if (queue.aging_interval > 0) {
+          heap_remove(&queue.aging, running);
+        }
+
+        cpu_time += parameters->dispatch_cost;
+        process_table[running].dispatch_count++;
+
+        if (running != last_run) {
+          cpu_time += parameters->switch_cost;
+          process_table[running].switch_count++;
+          last_run = running;
+        }
+
+        run_start = cpu_time;
+
+        admit_arrivals(&queue, cpu_time);
+        age_waiting(&queue, cpu_time);
+      }
+
+      const long long run_until = next_event(&queue, cpu_time, running);
+      struct ProcessEntry *const process = &process_table[running];
+
+      process->burst_time_remaining -= run_until - cpu_time;
+      cpu_time = run_until;
+
+      if (process->burst_time_remaining == 0) {
+        record_run(parameters, running, run_start, cpu_time);
+
+        process->turnaround_time = cpu_time - process->arrival_time;
+        process->waiting_time = process->turnaround_time -
+            process->burst_time;
+
+        running = -1;
+        --processes_remaining;
+      }
+    }
+  }
+
+  destroy_indexed_heap(&queue.aging);
+  destroy_indexed_heap(&queue.ready);
+}
+
+/*
+ * make_ready
+ *
+ * Puts a process in the queue at the priority from its trace. It
+ * starts aging from now.
+ */
+static void make_ready(struct ReadyQueue *const restrict queue,
+                       const int process,
+                       const long long cpu_time) {
+  heap_push(&queue->ready, process, queue->process_table[process].priority);
+
+  if (queue->aging_interval > 0) {
+    heap_push(&queue->aging, process, cpu_time + queue->aging_interval);
+  }
+}
+
+/*
+ * admit_arrivals
+ *
+ * Anything that has arrived by cpu_time goes in the queue. Processes
+ * that turned up while a process was being dispatched have been
+ * waiting since they arrived, not since now.
+ */
+static void admit_arrivals(struct ReadyQueue *const restrict queue,
+                           const long long cpu_time) {
+  while (queue->next_arrival < queue->total_processes &&
+         queue->process_table[queue->next_arrival].arrival_time <=
+         cpu_time) {
+    make_ready(queue, queue->next_arrival,
+               queue->process_table[queue->next_arrival].arrival_time);
+    ++queue->next_arrival;
+  }
+}
+
+/*
+ * age_waiting
+ *
+ * Every process that has waited another aging interval by cpu_time
+ * gets one more important.
+ */
+static void age_waiting(struct ReadyQueue *const restrict queue,
+                        const long long cpu_time) {
+  while (!heap_is_empty(&queue->aging) &&
+         heap_top_key(&queue->aging) <= cpu_time) {
+    const long long aged_at = heap_top_key(&queue->aging);
+    const int process = heap_pop(&queue->aging);
+
+    heap_decrease_key(&queue->ready, process,
+                      heap_key(&queue->ready, process) - 1);
+    heap_push(&queue->aging, process, aged_at + queue->aging_interval);
+  }
+}
+
+/*
+ * next_event
+ *
+ * When the running process next has to stop and let the scheduler
+ * look again, either it's finished, something arrives, or something
+ * waiting ages. Always after cpu_time, everything up to then has
+ * been dealt with.
+ */
+static long long next_event(const struct ReadyQueue *const restrict queue,
+                            const long long cpu_time,
+                            const int running) {
+  long long result = cpu_time +
+      queue->process_table[running].burst_time_remaining;
+
+  if (queue->next_arrival < queue->total_processes &&
+      queue->process_table[queue->next_arrival].arrival_time < result) {
+    result = queue->process_table[queue->next_arrival].arrival_time;
+  }
+
+  if (!heap_is_empty(&queue->aging) &&
+      heap_top_key(&queue->aging) < result) {
+    result = heap_top_key(&queue->aging);
+  }
+
+  assert(result > cpu_time);
+
+  return result;
+}
+
+/*
+ * record_run
+ *
+ * The process has finished or been preempted, put the time it had the
+ * CPU in the timeline if there is one.
+ */
+static void record_run(const struct SchedulerParameters *const restrict
+                       parameters,
+                       const int process,
+                       const long long run_start,
+                       const long long cpu_time) {
+  if (parameters->timeline != NULL) {
+    add_timeline_slice(parameters->timeline, process, run_start, cpu_time);
+  }
+}
@@ -0,0 +1,40 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The priority scheduler, the most important process that's waiting
+ * always has the CPU, and will take it from a less important one as
+ * soon as it arrives. Processes that wait a long time slowly become
+ * more important, so nothing waits forever.
+ */
+
+#ifndef PRIORITY_SCHEDULER_H_
+#define PRIORITY_SCHEDULER_H_
+
+#include "process_entry.h"
+#include "scheduler_parameters.h"
+
+/*
+ * Priority Scheduler
+ *
+ * Takes a pointer to an array of ProcessEntries and runs a preemptive
+ * priority scheduler with aging on it. Lower priority numbers are more
+ * important, processes with the same priority run in order of
+ * arrival.
+ *
+ * Every aging_interval a process spends waiting, its priority goes
+ * down by one. Once it gets the CPU it goes back to its priority from
+ * the trace. An aging interval of 0 turns aging off.
+ *
+ * The array being passed in is expected to be sorted.
+ *
+ * When the scheduler is run, it will update the process entries with
+ * turnaround and waiting times. (Mutable data!)
+ */
+void priority_scheduler(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters);
+
+#endif
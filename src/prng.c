@@ -0,0 +1,60 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+
+#include "prng.h"
+
+// Forward decs
+static uint64_t mix(uint64_t value);
+
+void seed_prng(struct Prng *const restrict prng, const uint64_t seed) {
+  prng->state = mix(seed);
+}
+
+uint64_t next_random(struct Prng *const restrict prng) {
+  prng->state += 0x9e3779b97f4a7c15;
+
+  return mix(prng->state);
+}
+
+/*
+ * random_below
+ *
+ * Taking the remainder on its own would favour small numbers a
+ * little, so values from the incomplete range at the bottom are
+ * thrown away. That's rarely more than one try.
+ */
+uint64_t random_below(struct Prng *const restrict prng, const uint64_t limit) {
+  assert(limit > 0);
+
+  // (2^64 - limit) % limit, the size of the incomplete range.
+  const uint64_t threshold = -limit % limit;
+  uint64_t value;
+
+  do {
+    value = next_random(prng);
+  } while (value < threshold);
+
+  return value % limit;
+}
+
+double random_fraction(struct Prng *const restrict prng) {
+  return (double) (next_random(prng) >> 11) * 0x1.0p-53;
+}
+
+/*
+ * mix
+ *
+ * The SplitMix64 finaliser, every bit of the result depends on every
+ * bit of the value.
+ */
+static uint64_t mix(uint64_t value) {
+  value = (value ^ (value >> 30)) * 0xbf58476d1ce4e5b9;
+  value = (value ^ (value >> 27)) * 0x94d049bb133111eb;
+
+  return value ^ (value >> 31);
+}
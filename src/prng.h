@@ -0,0 +1,57 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Small, fast pseudo random number generator, so randomised
+ *   schedulers give the same results for the same seed on any
+ *   platform.
+ */
+
+#ifndef PRNG_H_
+#define PRNG_H_
+
+#include <stdint.h>
+
+/*
+ * Prng
+ *
+ * SplitMix64, all of its state is a single 64 bit counter.
+ */
+struct Prng {
+  uint64_t state;
+};
+
+/*
+ * Seed prng
+ *
+ * Starts the generator off from the seed. Seeds that are close
+ * together still give unrelated sequences.
+ */
+void seed_prng(struct Prng *const restrict prng, const uint64_t seed);
+
+/*
+ * Next random
+ *
+ * The next 64 random bits.
+ */
+uint64_t next_random(struct Prng *const restrict prng);
+
+/*
+ * Random below
+ *
+ * A random number from 0 up to, but not including, limit, with every
+ * number equally likely. Limit must be more than 0.
+ */
+uint64_t random_below(struct Prng *const restrict prng, const uint64_t limit);
+
+/*
+ * Random fraction
+ *
+ * A random number from 0 up to, but not including, 1, using all 53
+ * bits of a double.
+ */
+double random_fraction(struct Prng *const restrict prng);
+
+#endif
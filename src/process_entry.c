@@ -12,30 +12,45 @@
  * init_process_entry
  *
  * Given a pointer to a process entry, the arrival and burst times,
- * set up the entry.
+ * priority and tickets, set up the entry. Any priority is valid.
  */
 enum ProcessEntryError init_process_entry(
     struct ProcessEntry *const restrict process_entry,
     const int arrival_time,
-    const int burst_time) {
+    const int burst_time,
+    const int priority,
+    const int tickets) {
 
   enum ProcessEntryError entry_error = PROCESS_ENTRY_ERR_NONE;
 
   // Check for valid values.
-  if (arrival_time < 0 || burst_time < 1) {
+  if (arrival_time < 0 || burst_time < 1 || tickets < 1) {
     if (arrival_time < 0) {
       entry_error = PROCESS_ENTRY_ERR_ARRIVAL;
-    } else {
+    } else if (burst_time < 1) {
       entry_error = PROCESS_ENTRY_ERR_BURST;
+    } else {
+      entry_error = PROCESS_ENTRY_ERR_TICKETS;
     }
   } else {
     // Good to go.
     process_entry->arrival_time = arrival_time;
     process_entry->burst_time = burst_time;
-    process_entry->burst_time_remaining = burst_time;
-    process_entry->turnaround_time = 0;
-    process_entry->waiting_time = 0;
+    process_entry->priority = priority;
+    process_entry->tickets = tickets;
+    process_entry->first_phase = 0;
+    process_entry->phase_count = 0;
+    process_entry->io_time = 0;
+    reset_process_entry(process_entry);
   }
 
   return entry_error;
 }
+
+void reset_process_entry(struct ProcessEntry *const restrict process_entry) {
+  process_entry->burst_time_remaining = process_entry->burst_time;
+  process_entry->turnaround_time = 0;
+  process_entry->waiting_time = 0;
+  process_entry->dispatch_count = 0;
+  process_entry->switch_count = 0;
+}
@@ -11,6 +11,11 @@
 #ifndef PROCESS_ENTRY_H_
 #define PROCESS_ENTRY_H_
 
+/*
+ * Tickets for a process when the trace doesn't give any.
+ */
+#define DEFAULT_TICKETS 100
+
 /*
  * ProcessEntry
  *
@@ -25,9 +30,34 @@
 struct ProcessEntry {
   int arrival_time;
   int burst_time;
+
+  // Lower numbers are more important, only used by schedulers that
+  // care about it.
+  int priority;
+
+  // Share of the CPU for proportional share schedulers, relative to
+  // the other processes' tickets.
+  int tickets;
+
+  // For processes that go off and do I/O, where their bursts start in
+  // the trace's list of phases, and how many there are. The phases
+  // alternate CPU and I/O, starting and ending with CPU, and burst_time
+  // is the total of the CPU ones. No phases means the process is just
+  // the one CPU burst.
+  int first_phase;
+  int phase_count;
+  int io_time;
+
+  // The times are long long, a long trace can end long after
+  // anything an int can hold.
   int burst_time_remaining;
-  int turnaround_time;
-  int waiting_time;
+  long long turnaround_time;
+  long long waiting_time;
+
+  // Times the process was given the CPU, and how many of those needed
+  // a context switch.
+  int dispatch_count;
+  int switch_count;
 };
 
 /*
@@ -36,7 +66,9 @@ struct ProcessEntry {
 enum ProcessEntryError {
   PROCESS_ENTRY_ERR_NONE = 0,
   PROCESS_ENTRY_ERR_ARRIVAL,
-  PROCESS_ENTRY_ERR_BURST
+  PROCESS_ENTRY_ERR_BURST,
+  PROCESS_ENTRY_ERR_TICKETS,
+  PROCESS_ENTRY_ERR_PHASES
 };
 
 /*
@@ -48,11 +80,24 @@ enum ProcessEntryError {
  * process_entry - Entry to update.
  * arrival_time - Arrival time.
  * burst_time - Burst time.
+ * priority - Priority, lower is more important.
+ * tickets - Tickets, must be at least one.
  */
 enum ProcessEntryError init_process_entry(
     struct ProcessEntry *const restrict process_entry,
     const int arrival_time,
-    const int burst_time);
+    const int burst_time,
+    const int priority,
+    const int tickets);
 
+/*
+ * Reset process entry
+ *
+ * Clears the results from an entry that has already been scheduled,
+ * so it can be scheduled again.
+ *
+ * process_entry - Entry to reset.
+ */
+void reset_process_entry(struct ProcessEntry *const restrict process_entry);
 
 #endif
@@ -0,0 +1,720 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The cache file is plain text, one result to a line:
+ *
+ *   <content hash> <scheduler name> <dispatch cost> <switch cost>
+ *   <aging interval> <seed> <turnaround> <waiting>
+ *   <min turnaround> <max turnaround> <turnaround variance>
+ *   <min waiting> <max waiting> <waiting variance>
+ *   <context switches> <overhead fraction>
+ *
+ * The doubles are written as hex floats so they come back exactly as
+ * they went in. New results are appended, lines that can't be
+ * read are ignored.
+ */
+
+// For strdup and st_mtim.
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include "result_cache.h"
+
+// FNV-1a constants.
+#define FNV_OFFSET_BASIS UINT64_C(14695981039346656037)
+#define FNV_PRIME UINT64_C(1099511628211)
+
+#define INITIAL_CAPACITY 64
+#define HASH_BUFFER_SIZE 65536
+
+// Forward decs
+static void init_key(struct ResultCacheEntry *const restrict key,
+                     const char *const restrict scheduler_name,
+                     const struct SchedulerParameters *const restrict
+                     parameters);
+static bool lookup_result(struct ResultCache *const restrict cache,
+                          const char *const restrict filename,
+                          struct ResultCacheEntry *const restrict key,
+                          bool *const restrict hashed);
+static void store_result(struct ResultCache *const restrict cache,
+                         struct ResultCacheEntry *const restrict key,
+                         const struct SchedulerAverages *const restrict
+                         averages);
+static uint64_t hash_bytes(uint64_t hash, const void *const bytes,
+                           const size_t size);
+static bool hash_file(const char *const restrict filename,
+                      uint64_t *const restrict content_hash);
+static bool content_hash_for(struct ResultCache *const restrict cache,
+                             const char *const restrict filename,
+                             uint64_t *const restrict content_hash);
+static struct FileHashEntry *find_file(struct ResultCache *const restrict
+                                       cache,
+                                       const char *const restrict filename);
+static void set_file_stat(struct FileHashEntry *const restrict entry,
+                          const struct stat *const restrict file_stat);
+static bool same_file_stat(const struct FileHashEntry *const restrict entry,
+                           const struct stat *const restrict file_stat);
+static struct ResultCacheEntry *find_result(
+    struct ResultCache *const restrict cache,
+    const struct ResultCacheEntry *const restrict key);
+static bool same_key(const struct ResultCacheEntry *const restrict first,
+                     const struct ResultCacheEntry *const restrict second);
+static uint64_t hash_key(const struct ResultCacheEntry *const restrict key);
+static void insert_result(struct ResultCache *const restrict cache,
+                          const struct ResultCacheEntry *const entry);
+static void grow_results(struct ResultCache *const restrict cache);
+static void grow_files(struct ResultCache *const restrict cache);
+static void load_cache_file(struct ResultCache *const restrict cache);
+static void append_cache_file(struct ResultCache *const restrict cache,
+                              const struct ResultCacheEntry *const entry);
+static void format_cache_header(char *const restrict buffer,
+                                const size_t size);
+
+void init_result_cache(struct ResultCache *const restrict cache,
+                       const char *const restrict filename) {
+  pthread_mutex_init(&cache->mutex, NULL);
+
+  cache->results_count = 0;
+  cache->results_capacity = INITIAL_CAPACITY;
+  cache->results = calloc(cache->results_capacity,
+                          sizeof(struct ResultCacheEntry));
+  assert(cache->results != NULL);
+
+  cache->files_count = 0;
+  cache->files_capacity = INITIAL_CAPACITY;
+  cache->files = calloc(cache->files_capacity, sizeof(struct FileHashEntry));
+  assert(cache->files != NULL);
+
+  cache->filename = NULL;
+  cache->file_current = false;
+
+  if (filename != NULL) {
+    cache->filename = strdup(filename);
+    assert(cache->filename != NULL);
+
+    load_cache_file(cache);
+  }
+}
+
+void destroy_result_cache(struct ResultCache *const restrict cache) {
+  for (int i = 0; i < cache->files_capacity; i++) {
+    free(cache->files[i].filename);
+  }
+
+  free(cache->files);
+  free(cache->results);
+  free(cache->filename);
+
+  pthread_mutex_destroy(&cache->mutex);
+}
+
+struct SchedulerAverages cached_run_scheduler(
+    struct ResultCache *const restrict cache,
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const char *const restrict scheduler_name,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  struct SchedulerAverages averages;
+
+  if (cache == NULL || parameters->timeline != NULL ||
+      parameters->counters != NULL) {
+    averages = run_scheduler(filename, scheduler_to_use, parameters);
+  } else {
+    struct ResultCacheEntry key;
+    init_key(&key, scheduler_name, parameters);
+
+    bool hashed = false;
+
+    if (lookup_result(cache, filename, &key, &hashed)) {
+      averages = key.averages;
+    } else {
+      // Don't hold the cache up while we're scheduling.
+      averages = run_scheduler(filename, scheduler_to_use, parameters);
+
+      if (hashed) {
+        store_result(cache, &key, &averages);
+      }
+    }
+  }
+
+  return averages;
+}
+
+void cached_stream_schedulers(
+    struct ResultCache *const restrict cache,
+    const char *const restrict filename,
+    const struct StreamPolicy *const restrict policies,
+    const char *const *const restrict names,
+    const int count,
+    const struct SchedulerParameters *const restrict parameters,
+    struct SchedulerAverages *const restrict averages) {
+
+  if (cache == NULL || parameters->timeline != NULL) {
+    stream_schedulers(filename, policies, count, parameters, averages);
+  } else {
+    struct ResultCacheEntry *const keys =
+        malloc(sizeof(struct ResultCacheEntry) * count);
+    struct StreamPolicy *const missing_policies =
+        malloc(sizeof(struct StreamPolicy) * count);
+    struct SchedulerAverages *const missing_averages =
+        malloc(sizeof(struct SchedulerAverages) * count);
+    int *const missing = malloc(sizeof(int) * count);
+
+    assert(keys != NULL);
+    assert(missing_policies != NULL);
+    assert(missing_averages != NULL);
+    assert(missing != NULL);
+
+    bool hashed = false;
+    int missing_count = 0;
+
+    for (int i = 0; i < count; i++) {
+      init_key(&keys[i], names[i], parameters);
+
+      if (lookup_result(cache, filename, &keys[i], &hashed)) {
+        averages[i] = keys[i].averages;
+      } else {
+        missing[missing_count] = i;
+        missing_policies[missing_count] = policies[i];
+        ++missing_count;
+      }
+    }
+
+    // Only what wasn't cached is scheduled, still in the one pass.
+    if (missing_count > 0) {
+      stream_schedulers(filename, missing_policies, missing_count,
+                        parameters, missing_averages);
+
+      for (int i = 0; i < missing_count; i++) {
+        averages[missing[i]] = missing_averages[i];
+
+        if (hashed) {
+          store_result(cache, &keys[missing[i]], &missing_averages[i]);
+        }
+      }
+    }
+
+    free(missing);
+    free(missing_averages);
+    free(missing_policies);
+    free(keys);
+  }
+}
+
+/*
+ * init_key
+ *
+ * Fills in everything in the key but the content hash and the
+ * averages.
+ */
+static void init_key(struct ResultCacheEntry *const restrict key,
+                     const char *const restrict scheduler_name,
+                     const struct SchedulerParameters *const restrict
+                     parameters) {
+  assert(strlen(scheduler_name) < RESULT_CACHE_NAME_SIZE);
+
+  memset(key, 0, sizeof(*key));
+  strcpy(key->scheduler_name, scheduler_name);
+  key->dispatch_cost = parameters->dispatch_cost;
+  key->switch_cost = parameters->switch_cost;
+  key->aging_interval = parameters->aging_interval;
+  key->seed = parameters->seed;
+  key->prediction_weight = parameters->prediction_weight;
+
+  // The guess makes no difference if nothing's predicted.
+  if (parameters->prediction_weight > 0) {
+    key->prediction_guess = parameters->prediction_guess;
+  }
+
+  // Split threads, streaming and sort memory aren't part of the key,
+  // they don't change results.
+}
+
+/*
+ * lookup_result
+ *
+ * Hashes the file into the key and looks it up. Returns true, with
+ * the averages in the key, if it was found. hashed is set if the
+ * file could be hashed, so the result can be stored once it's worked
+ * out.
+ */
+static bool lookup_result(struct ResultCache *const restrict cache,
+                          const char *const restrict filename,
+                          struct ResultCacheEntry *const restrict key,
+                          bool *const restrict hashed) {
+  bool found = false;
+
+  *hashed = content_hash_for(cache, filename, &key->content_hash);
+
+  if (*hashed) {
+    pthread_mutex_lock(&cache->mutex);
+
+    const struct ResultCacheEntry *const entry = find_result(cache, key);
+
+    if (entry != NULL) {
+      key->averages = entry->averages;
+      found = true;
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+  }
+
+  return found;
+}
+
+/*
+ * store_result
+ *
+ * Adds the averages to the cache under the key, which must have been
+ * hashed by lookup_result.
+ */
+static void store_result(struct ResultCache *const restrict cache,
+                         struct ResultCacheEntry *const restrict key,
+                         const struct SchedulerAverages *const restrict
+                         averages) {
+  // Only keep results from files we could actually read. Every
+  // process takes at least a unit of time, so a zero turnaround
+  // means the trace couldn't be used, and we want the error shown
+  // again next time.
+  if (averages->turnaround_time > 0.0) {
+    key->averages = *averages;
+
+    pthread_mutex_lock(&cache->mutex);
+
+    // Another thread may have got here first.
+    if (find_result(cache, key) == NULL) {
+      insert_result(cache, key);
+      append_cache_file(cache, key);
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+  }
+}
+
+/*
+ * hash_bytes
+ *
+ * Carries on an FNV-1a hash over the given bytes.
+ */
+static uint64_t hash_bytes(uint64_t hash, const void *const bytes,
+                           const size_t size) {
+  const unsigned char *const data = bytes;
+
+  for (size_t i = 0; i < size; i++) {
+    hash ^= data[i];
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
+
+/*
+ * hash_file
+ *
+ * Reads the whole file to hash its contents. Returns false if the
+ * file couldn't be read.
+ */
+static bool hash_file(const char *const restrict filename,
+                      uint64_t *const restrict content_hash) {
+  bool result = false;
+
+  FILE *const file_to_hash = fopen(filename, "rb");
+
+  if (file_to_hash != NULL) {
+    unsigned char *const buffer = malloc(HASH_BUFFER_SIZE);
+    assert(buffer != NULL);
+
+    uint64_t hash = FNV_OFFSET_BASIS;
+    size_t read_size;
+
+    while ((read_size = fread(buffer, 1, HASH_BUFFER_SIZE,
+                              file_to_hash)) > 0) {
+      hash = hash_bytes(hash, buffer, read_size);
+    }
+
+    result = !ferror(file_to_hash);
+    *content_hash = hash;
+
+    free(buffer);
+    fclose(file_to_hash);
+  }
+
+  return result;
+}
+
+/*
+ * content_hash_for
+ *
+ * Gets the content hash for the file, only reading the file if it's
+ * new to us, or stat says it has changed since we last hashed it. The
+ * file is read without the cache mutex, and the hash only kept if stat
+ * says the file didn't change while it was being read. Returns false
+ * if it couldn't be read, or changed.
+ */
+static bool content_hash_for(struct ResultCache *const restrict cache,
+                             const char *const restrict filename,
+                             uint64_t *const restrict content_hash) {
+  bool result = false;
+  struct stat file_stat;
+
+  if (stat(filename, &file_stat) == 0) {
+    pthread_mutex_lock(&cache->mutex);
+
+    const struct FileHashEntry *const entry = find_file(cache, filename);
+
+    if (entry->filename != NULL && same_file_stat(entry, &file_stat)) {
+      *content_hash = entry->content_hash;
+      result = true;
+    }
+
+    pthread_mutex_unlock(&cache->mutex);
+
+    if (!result && hash_file(filename, content_hash)) {
+      struct FileHashEntry hashed;
+      set_file_stat(&hashed, &file_stat);
+
+      pthread_mutex_lock(&cache->mutex);
+
+      if (stat(filename, &file_stat) == 0 &&
+          same_file_stat(&hashed, &file_stat)) {
+        // The table may have grown while we were reading.
+        struct FileHashEntry *const stored = find_file(cache, filename);
+
+        if (stored->filename == NULL) {
+          stored->filename = strdup(filename);
+          assert(stored->filename != NULL);
+          cache->files_count++;
+        }
+
+        set_file_stat(stored, &file_stat);
+        stored->content_hash = *content_hash;
+        result = true;
+      }
+
+      pthread_mutex_unlock(&cache->mutex);
+    }
+  }
+
+  return result;
+}
+
+/*
+ * find_file
+ *
+ * Finds the file's entry in the file hash table, or the empty one it
+ * would go in, growing the table first if it's getting full. Expects
+ * the cache mutex to be held.
+ */
+static struct FileHashEntry *find_file(struct ResultCache *const restrict
+                                       cache,
+                                       const char *const restrict filename) {
+  if (cache->files_count * 2 >= cache->files_capacity) {
+    grow_files(cache);
+  }
+
+  const uint64_t mask = cache->files_capacity - 1;
+  uint64_t index = hash_bytes(FNV_OFFSET_BASIS, filename,
+                              strlen(filename)) & mask;
+
+  while (cache->files[index].filename != NULL &&
+         strcmp(cache->files[index].filename, filename) != 0) {
+    index = (index + 1) & mask;
+  }
+
+  return &cache->files[index];
+}
+
+/*
+ * set_file_stat
+ *
+ * Copies the details of the file that tell when it's changed into the
+ * entry.
+ */
+static void set_file_stat(struct FileHashEntry *const restrict entry,
+                          const struct stat *const restrict file_stat) {
+  entry->device = file_stat->st_dev;
+  entry->inode = file_stat->st_ino;
+  entry->size = file_stat->st_size;
+  entry->modified = file_stat->st_mtim;
+}
+
+/*
+ * same_file_stat
+ *
+ * Whether stat says the file is the same as when the entry was set.
+ */
+static bool same_file_stat(const struct FileHashEntry *const restrict entry,
+                           const struct stat *const restrict file_stat) {
+  return entry->device == file_stat->st_dev &&
+      entry->inode == file_stat->st_ino &&
+      entry->size == file_stat->st_size &&
+      entry->modified.tv_sec == file_stat->st_mtim.tv_sec &&
+      entry->modified.tv_nsec == file_stat->st_mtim.tv_nsec;
+}
+
+/*
+ * find_result
+ *
+ * Look up a result matching the key, returns NULL if there isn't one.
+ */
+static struct ResultCacheEntry *find_result(
+    struct ResultCache *const restrict cache,
+    const struct ResultCacheEntry *const restrict key) {
+
+  const uint64_t mask = cache->results_capacity - 1;
+  uint64_t index = hash_key(key) & mask;
+
+  struct ResultCacheEntry *result = NULL;
+
+  // Empty slots have no name.
+  while (result == NULL && cache->results[index].scheduler_name[0] != '\0') {
+    if (same_key(&cache->results[index], key)) {
+      result = &cache->results[index];
+    }
+    index = (index + 1) & mask;
+  }
+
+  return result;
+}
+
+/*
+ * same_key
+ *
+ * True if both entries are for the same trace, scheduler and
+ * parameters.
+ */
+static bool same_key(const struct ResultCacheEntry *const restrict first,
+                     const struct ResultCacheEntry *const restrict second) {
+  return first->content_hash == second->content_hash &&
+      first->dispatch_cost == second->dispatch_cost &&
+      first->switch_cost == second->switch_cost &&
+      first->aging_interval == second->aging_interval &&
+      first->seed == second->seed &&
+      first->prediction_weight == second->prediction_weight &&
+      first->prediction_guess == second->prediction_guess &&
+      strcmp(first->scheduler_name, second->scheduler_name) == 0;
+}
+
+/*
+ * hash_key
+ *
+ * Where to start looking for an entry in the results table.
+ */
+static uint64_t hash_key(const struct ResultCacheEntry *const restrict key) {
+  uint64_t hash = hash_bytes(key->content_hash, key->scheduler_name,
+                             strlen(key->scheduler_name));
+  hash = hash_bytes(hash, &key->dispatch_cost, sizeof(key->dispatch_cost));
+  hash = hash_bytes(hash, &key->switch_cost, sizeof(key->switch_cost));
+  hash = hash_bytes(hash, &key->aging_interval, sizeof(key->aging_interval));
+  hash = hash_bytes(hash, &key->seed, sizeof(key->seed));
+  hash = hash_bytes(hash, &key->prediction_weight,
+                    sizeof(key->prediction_weight));
+  hash = hash_bytes(hash, &key->prediction_guess,
+                    sizeof(key->prediction_guess));
+
+  return hash;
+}
+
+/*
+ * insert_result
+ *
+ * Puts a result into the table, growing it first if it's getting
+ * full. Expects that the result isn't already in there.
+ */
+static void insert_result(struct ResultCache *const restrict cache,
+                          const struct ResultCacheEntry *const entry) {
+  if (cache->results_count * 2 >= cache->results_capacity) {
+    grow_results(cache);
+  }
+
+  const uint64_t mask = cache->results_capacity - 1;
+  uint64_t index = hash_key(entry) & mask;
+
+  while (cache->results[index].scheduler_name[0] != '\0') {
+    index = (index + 1) & mask;
+  }
+
+  cache->results[index] = *entry;
+  cache->results_count++;
+}
+
+/*
+ * grow_results
+ *
+ * Doubles the size of the results table, putting everything back in.
+ */
+static void grow_results(struct ResultCache *const restrict cache) {
+  struct ResultCacheEntry *const old_results = cache->results;
+  const int old_capacity = cache->results_capacity;
+
+  cache->results_capacity *= 2;
+  cache->results_count = 0;
+  cache->results = calloc(cache->results_capacity,
+                          sizeof(struct ResultCacheEntry));
+  assert(cache->results != NULL);
+
+  for (int i = 0; i < old_capacity; i++) {
+    if (old_results[i].scheduler_name[0] != '\0') {
+      insert_result(cache, &old_results[i]);
+    }
+  }
+
+  free(old_results);
+}
+
+/*
+ * grow_files
+ *
+ * Doubles the size of the file hash table, putting everything back
+ * in. The filename strings move over, rather than being copied.
+ */
+static void grow_files(struct ResultCache *const restrict cache) {
+  struct FileHashEntry *const old_files = cache->files;
+  const int old_capacity = cache->files_capacity;
+
+  cache->files_capacity *= 2;
+  cache->files = calloc(cache->files_capacity, sizeof(struct FileHashEntry));
+  assert(cache->files != NULL);
+
+  const uint64_t mask = cache->files_capacity - 1;
+
+  for (int i = 0; i < old_capacity; i++) {
+    if (old_files[i].filename != NULL) {
+      uint64_t index = hash_bytes(FNV_OFFSET_BASIS, old_files[i].filename,
+                                  strlen(old_files[i].filename)) & mask;
+
+      while (cache->files[index].filename != NULL) {
+        index = (index + 1) & mask;
+      }
+
+      cache->files[index] = old_files[i];
+    }
+  }
+
+  free(old_files);
+}
+
+/*
+ * load_cache_file
+ *
+ * Reads in any results saved by earlier runs, if the file starts with
+ * this version's first line. It's fine for the file not to exist yet.
+ */
+static void load_cache_file(struct ResultCache *const restrict cache) {
+  FILE *const cache_file = fopen(cache->filename, "r");
+
+  if (cache_file != NULL) {
+    char header[64];
+    char line[512];
+
+    format_cache_header(header, sizeof(header));
+
+    cache->file_current = fgets(line, sizeof(line), cache_file) != NULL &&
+        strcmp(line, header) == 0;
+
+    while (cache->file_current &&
+           fgets(line, sizeof(line), cache_file) != NULL) {
+      struct ResultCacheEntry entry;
+      memset(&entry, 0, sizeof(entry));
+      struct SchedulerAverages *const averages = &entry.averages;
+
+      const int fields =
+          sscanf(line, "%" SCNx64 " %15s %d %d %d %" SCNu64
+                 " %la %la %lld %lld %la %lld %lld %la %lld %la %d %d",
+                 &entry.content_hash, entry.scheduler_name,
+                 &entry.dispatch_cost,
+                 &entry.switch_cost,
+                 &entry.aging_interval,
+                 &entry.seed,
+                 &averages->turnaround_time,
+                 &averages->waiting_time,
+                 &averages->min_turnaround_time,
+                 &averages->max_turnaround_time,
+                 &averages->turnaround_variance,
+                 &averages->min_waiting_time,
+                 &averages->max_waiting_time,
+                 &averages->waiting_variance,
+                 &averages->context_switches,
+                 &averages->overhead_fraction,
+                 &entry.prediction_weight,
+                 &entry.prediction_guess);
+
+      if (fields == 18 &&
+          find_result(cache, &entry) == NULL) {
+        insert_result(cache, &entry);
+      }
+    }
+
+    fclose(cache_file);
+  }
+}
+
+/*
+ * append_cache_file
+ *
+ * Adds a result to the end of the cache file, if we have one. If the
+ * file isn't current, it's started again with this version's first
+ * line, throwing away what was there.
+ */
+static void append_cache_file(struct ResultCache *const restrict cache,
+                              const struct ResultCacheEntry *const entry) {
+  if (cache->filename != NULL) {
+    FILE *const cache_file = fopen(cache->filename,
+                                   cache->file_current ? "a" : "w");
+
+    if (cache_file == NULL) {
+      perror("Result cache");
+    } else {
+      const struct SchedulerAverages *const averages = &entry->averages;
+
+      if (!cache->file_current) {
+        char header[64];
+        format_cache_header(header, sizeof(header));
+        fputs(header, cache_file);
+        cache->file_current = true;
+      }
+
+      fprintf(cache_file, "%016" PRIx64 " %s %d %d %d %" PRIu64
+              " %a %a %lld %lld %a %lld %lld %a %lld %a %d %d\n",
+              entry->content_hash, entry->scheduler_name,
+              entry->dispatch_cost,
+              entry->switch_cost,
+              entry->aging_interval,
+              entry->seed,
+              averages->turnaround_time,
+              averages->waiting_time,
+              averages->min_turnaround_time,
+              averages->max_turnaround_time,
+              averages->turnaround_variance,
+              averages->min_waiting_time,
+              averages->max_waiting_time,
+              averages->waiting_variance,
+              averages->context_switches,
+              averages->overhead_fraction,
+              entry->prediction_weight,
+              entry->prediction_guess);
+      fclose(cache_file);
+    }
+  }
+}
+
+/*
+ * format_cache_header
+ *
+ * The first line of a cache file written by this version.
+ */
+static void format_cache_header(char *const restrict buffer,
+                                const size_t size) {
+  snprintf(buffer, size, "OS200 result cache %d %s\n", RESULT_CACHE_VERSION,
+           RESULT_CACHE_HASH);
+}
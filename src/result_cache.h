@@ -0,0 +1,163 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Cache of scheduler results, so running the same trace through
+ *   the same scheduler again doesn't have to do all the work again.
+ */
+
+#ifndef RESULT_CACHE_H_
+#define RESULT_CACHE_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <time.h>
+
+#include "scheduler.h"
+#include "stream_scheduler.h"
+
+/*
+ * Longest scheduler name the cache will keep, including the
+ * terminator.
+ */
+#define RESULT_CACHE_NAME_SIZE 16
+
+/*
+ * Version of the cache file, written on its first line along with the
+ * hash the results are keyed on. A file that starts any other way was
+ * written by a build whose results might not match, so it's started
+ * again rather than loaded. This has to go up whenever a scheduler's
+ * results change, or the lines written for them do.
+ */
+#define RESULT_CACHE_VERSION 1
+#define RESULT_CACHE_HASH "fnv1a-64"
+
+/*
+ * ResultCacheEntry
+ *
+ * A single cached result. Results are keyed on a hash of the trace
+ * file contents, not its name, so an edited file won't match, and
+ * copies of the same trace will. The quantum is part of the file, so
+ * it's covered by the hash as well, the other scheduler parameters
+ * are part of the key.
+ */
+struct ResultCacheEntry {
+  uint64_t content_hash;
+  char scheduler_name[RESULT_CACHE_NAME_SIZE];
+  int dispatch_cost;
+  int switch_cost;
+  int aging_interval;
+  uint64_t seed;
+  int prediction_weight;
+  int prediction_guess;
+
+  struct SchedulerAverages averages;
+};
+
+/*
+ * FileHashEntry
+ *
+ * Hashing the contents of a file means reading it, which is most of
+ * the cost we're trying to avoid. So the hash is remembered along with
+ * enough details from stat to tell when the file has changed.
+ */
+struct FileHashEntry {
+  char *filename;
+  dev_t device;
+  ino_t inode;
+  off_t size;
+  struct timespec modified;
+
+  uint64_t content_hash;
+};
+
+/*
+ * ResultCache
+ *
+ * Both tables are open addressed, and are always a power of two in
+ * size so the hash can be masked. The mutex covers everything, the
+ * cache is shared between all of the scheduler threads. Files are read
+ * and hashed without it, so one thread hashing a big trace doesn't
+ * hold up the others.
+ *
+ * If filename is set, results are also appended to that file, and
+ * loaded from it when the cache is created, so they survive between
+ * runs of the programs. file_current is set once the file is known to
+ * start with this version's first line, until then the first result
+ * written starts it again.
+ */
+struct ResultCache {
+  pthread_mutex_t mutex;
+
+  struct ResultCacheEntry *results;
+  int results_count;
+  int results_capacity;
+
+  struct FileHashEntry *files;
+  int files_count;
+  int files_capacity;
+
+  char *filename;
+  bool file_current;
+};
+
+/*
+ * Init result cache
+ *
+ * Sets up an empty cache. If a filename is given, any results already
+ * in that file are loaded, as long as it was written with this
+ * version, and new results will be written there. Pass NULL to only
+ * keep results in memory.
+ */
+void init_result_cache(struct ResultCache *const restrict cache,
+                       const char *const restrict filename);
+
+/*
+ * Destroy result cache
+ *
+ * Frees everything held by the cache.
+ */
+void destroy_result_cache(struct ResultCache *const restrict cache);
+
+/*
+ * Cached run scheduler
+ *
+ * Same as run_scheduler, but will return the result straight from the
+ * cache if this trace has been run through the named scheduler with
+ * the same parameters before. The name is what identifies the
+ * scheduler in the cache, so it must be different for each scheduler
+ * used with the same cache.
+ *
+ * If the cache is NULL, or there's a timeline or counters that need
+ * the trace to actually be scheduled, this is the same as calling
+ * run_scheduler.
+ */
+struct SchedulerAverages cached_run_scheduler(
+    struct ResultCache *const restrict cache,
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const char *const restrict scheduler_name,
+    const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * Cached stream schedulers
+ *
+ * Same as stream_schedulers, but any policies with results in the
+ * cache aren't scheduled again, the rest are streamed together. Each
+ * policy has its own name in the cache, in names, and they must all
+ * be different.
+ */
+void cached_stream_schedulers(
+    struct ResultCache *const restrict cache,
+    const char *const restrict filename,
+    const struct StreamPolicy *const restrict policies,
+    const char *const *const restrict names,
+    const int count,
+    const struct SchedulerParameters *const restrict parameters,
+    struct SchedulerAverages *const restrict averages);
+
+#endif
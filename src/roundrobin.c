@@ -7,29 +7,10 @@
  * robin scheduler.
  */
 
-#include <assert.h>
-#include <stdio.h>
-#include <stdlib.h>
-
 #include "rr_scheduler.h"
-#include "scheduler.h"
-#include "user_input.h"
-
-int main() {
-  const int FILENAME_SIZE = 100;
-  char filename[FILENAME_SIZE];
-
-  printf("RR Simulation: ");
-
-  while (file_from_user(filename, FILENAME_SIZE)) {
-    struct SchedulerAverages averages;
-
-    averages = run_scheduler(filename, &rr_scheduler);
-
-    printf("Average turnaround time=%.2f."
-           "Average waiting time=%.2f\n",
-           averages.turnaround_time, averages.waiting_time);
+#include "scheduler_program.h"
 
-    printf("RR Simulation: ");
-  }
+int main(int argc, char *argv[]) {
+  return scheduler_program(argc, argv, &rr_scheduler, "RR",
+                           "RR Simulation: ");
 }
@@ -9,19 +9,157 @@
 #include <assert.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdlib.h>
 
+#include "fenwick_tree.h"
+#include "io_scheduler.h"
 #include "rr_scheduler.h"
 
+/*
+ * RoundsEntry
+ *
+ * For the batch scheduler, how many rounds of the queue a process
+ * needs before it's done, along with where it is in the table.
+ */
+struct RoundsEntry {
+  int rounds;
+  int index;
+};
+
 // Forward defines.
+static int busy_period_end(
+    const struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const int period_start,
+    const struct SchedulerParameters *const restrict parameters);
+static void rr_simulate(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters);
+static void rr_batch(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters);
+static int compare_rounds(const void *first, const void *second);
+static void complete_process(struct ProcessEntry *const restrict process,
+                             const long long cpu_time);
+static int turns_needed(const int burst_time, const int quantum);
+static int stable_passes(
+    const struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const int start,
+    const int end,
+    const long long cpu_time,
+    const int last_run,
+    const struct SchedulerParameters *const restrict parameters,
+    int *const restrict in_queue,
+    int *const restrict turn_length,
+    int *const restrict last_in_queue);
 static int smallest(const int num1, const int num2);
 static int find_waiting(struct ProcessEntry *const restrict process_table,
                         const int total_processes,
-                        const int cpu_time,
+                        const long long cpu_time,
                         const int waiting);
 
 /*
  * rr_scheduler
  *
+ * The table is split up into busy periods, stretches of time where
+ * the CPU never goes idle. Once the CPU is idle every process that
+ * arrived before has finished, so each busy period can be scheduled
+ * on its own.
+ *
+ * When everything in a busy period arrives at the same time, which is
+ * common for batch traces, the completion times can be worked out
+ * directly without running through each quantum.
+ *
+ * Each turn a process gets costs a dispatch, and a context switch if
+ * the process isn't the one that just had the CPU.
+ *
+ * A timeline needs every turn, so then the whole table is simulated
+ * one turn at a time.
+ *
+ * Processes doing I/O leave the queue and come back, which the passes
+ * over the table can't follow, so traces with I/O are left to
+ * io_scheduler and its queue.
+ */
+void rr_scheduler(struct ProcessEntry *const restrict process_table,
+                  const int total_processes,
+                  const struct SchedulerParameters *const restrict parameters) {
+
+  assert(process_table != NULL);
+
+  if (parameters->phases != NULL) {
+    io_scheduler(process_table, total_processes, parameters, IO_POLICY_RR);
+  } else if (parameters->timeline != NULL) {
+    rr_simulate(process_table, total_processes, parameters);
+  } else {
+    int period_start = 0;
+
+    while (period_start < total_processes) {
+      const int period_end = busy_period_end(process_table, total_processes,
+                                             period_start, parameters);
+
+      if (process_table[period_start].arrival_time ==
+          process_table[period_end - 1].arrival_time) {
+        rr_batch(&process_table[period_start], period_end - period_start,
+                 parameters);
+      } else {
+        rr_simulate(&process_table[period_start], period_end - period_start,
+                    parameters);
+      }
+
+      period_start = period_end;
+    }
+  }
+}
+
+/*
+ * busy_period_end
+ *
+ * Given the index of the first process in a busy period, returns the
+ * index just past the last process in it. The CPU is busy until the
+ * total burst time of everything that has turned up is used, any
+ * process arriving after that starts a new period.
+ *
+ * A process arriving just as the CPU finishes is treated as part of
+ * the same period, the queue may pick it up in the pass that's
+ * underway.
+ *
+ * How many of a process's turns need a context switch depends on what
+ * else is in the queue, so every turn is counted as a switch. With
+ * switch costs that can overestimate the period, and join two periods
+ * that are really separate. That's fine, the simulation copes with
+ * the CPU going idle, but it means two periods are never split when
+ * they shouldn't be.
+ */
+static int busy_period_end(
+    const struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const int period_start,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  const long long turn_cost = (long long) parameters->dispatch_cost +
+      parameters->switch_cost;
+
+  long long busy_until = process_table[period_start].arrival_time;
+  int period_end = period_start;
+
+  do {
+    const struct ProcessEntry *const process = &process_table[period_end];
+
+    busy_until += process->burst_time_remaining + turn_cost *
+        turns_needed(process->burst_time_remaining, parameters->quantum);
+    ++period_end;
+  } while (period_end < total_processes &&
+           process_table[period_end].arrival_time <= busy_until);
+
+  return period_end;
+}
+
+/*
+ * rr_simulate
+ *
  * All scheduling is based off the process table. RR scheduling relies
  * on using a queue to keep track of what are the next processes to
  * execute. In order to handle this, we have:
@@ -37,25 +175,70 @@ static int find_waiting(struct ProcessEntry *const restrict process_table,
  *
  * waiting - The largest index of the processes that are to be added
  *           to the end of the queue when the start is reached.
+ *
+ * Each pass through the queue, after the first process to run has had
+ * its turn, the waiting processes are added to the end.
+ *
+ * last_run - Index of the process that last had the CPU, so we know
+ *            if a turn needs a context switch. -1 when the CPU has
+ *            been idle.
  */
-void rr_scheduler(struct ProcessEntry *const restrict process_table,
-                  const int total_processes,
-                  const int quantum) {
+static void rr_simulate(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters) {
 
-  assert(process_table != NULL);
+  const int quantum = parameters->quantum;
   int processes_remaining = total_processes;
 
   // Just skip to the CPU time for the first process.
-  int cpu_time = process_table[0].arrival_time;
+  long long cpu_time = process_table[0].arrival_time;
 
   int start = 0;
   int end = 0;
   int waiting = 0;
+  int last_run = -1;
 
   while (processes_remaining > 0) {
     int process_to_run = start;
     bool no_process_execd = true;
 
+    /*
+     * If the next few passes would just give everyone in the queue a
+     * full quantum, with nobody finishing or being added, do them all
+     * at once.
+     */
+    int in_queue;
+    int turn_length;
+    int last_in_queue;
+    int passes = 0;
+
+    if (parameters->timeline == NULL) {
+      passes = stable_passes(process_table, total_processes,
+                             start, end, cpu_time, last_run,
+                             parameters, &in_queue, &turn_length,
+                             &last_in_queue);
+    }
+
+    if (passes > 0) {
+      for (int index = start; index <= end; index++) {
+        struct ProcessEntry *const process = &process_table[index];
+
+        if (process->burst_time_remaining != 0) {
+          process->burst_time_remaining -= passes * quantum;
+          process->dispatch_count += passes;
+
+          // On its own, a process just carries on without a switch.
+          if (in_queue > 1) {
+            process->switch_count += passes;
+          }
+        }
+      }
+
+      cpu_time += (long long) passes * turn_length * in_queue;
+      last_run = last_in_queue;
+    }
+
     /*
      * This is the loop that runs processes in the queue.
      */
@@ -66,8 +249,21 @@ void rr_scheduler(struct ProcessEntry *const restrict process_table,
             smallest(process_table[process_to_run].burst_time_remaining,
                      quantum);
 
+        cpu_time += parameters->dispatch_cost;
+        process_table[process_to_run].dispatch_count++;
+
+        if (process_to_run != last_run) {
+          cpu_time += parameters->switch_cost;
+          process_table[process_to_run].switch_count++;
+          last_run = process_to_run;
+        }
+
         cpu_time += burst_or_quantum;
-        no_process_execd = false;
+
+        if (parameters->timeline != NULL) {
+          add_timeline_slice(parameters->timeline, process_to_run,
+                             cpu_time - burst_or_quantum, cpu_time);
+        }
 
         process_table[process_to_run].burst_time_remaining -=
             burst_or_quantum;
@@ -75,19 +271,17 @@ void rr_scheduler(struct ProcessEntry *const restrict process_table,
         waiting = find_waiting(process_table, total_processes,
                                cpu_time, waiting);
 
-        // At the start of the queue, move the end of the queue so the
-        // waiting processes will now be executed.
-        if (process_to_run == start) {
+        // After the first process in this pass, move the end of the
+        // queue so the waiting processes will now be executed.
+        if (no_process_execd) {
           end = waiting;
         }
 
+        no_process_execd = false;
+
         // If a process is done, remove it and figure out our results.
         if (process_table[process_to_run].burst_time_remaining < 1) {
-          process_table[process_to_run].turnaround_time = cpu_time -
-              process_table[process_to_run].arrival_time;
-          process_table[process_to_run].waiting_time =
-              process_table[process_to_run].turnaround_time -
-              process_table[process_to_run].burst_time;
+          complete_process(&process_table[process_to_run], cpu_time);
           --processes_remaining;
         }
       }
@@ -95,34 +289,202 @@ void rr_scheduler(struct ProcessEntry *const restrict process_table,
     }
 
     /*
-     * Haven't run any process, this means the CPU is idle.
+     * Haven't run any process, everything in the queue is done.
      *
-     * The next process to run will be the one with the lowest arrival
-     * time that still has burst time. We find it and update cpu_time
-     * to it's arrival time.
+     * The next process to run is the one after the end of the queue,
+     * if it hasn't arrived yet the CPU is idle until it does.
      */
     if (no_process_execd) {
-      int search_index = start + 1;
-      int lowest_index = start + 1;
-
-      while (search_index < total_processes) {
-        if (process_table[search_index].burst_time_remaining != 0 &&
-            process_table[search_index].arrival_time <
-            process_table[lowest_index].arrival_time) {
-          lowest_index = search_index;
-        }
-        ++search_index;
+      const int next_index = end + 1;
+
+      assert(next_index < total_processes);
+
+      if (process_table[next_index].arrival_time > cpu_time) {
+        cpu_time = process_table[next_index].arrival_time;
+        last_run = -1;
       }
 
-      cpu_time = process_table[lowest_index].arrival_time;
-      start = end = lowest_index;
-      waiting = find_waiting(process_table, total_processes,
-                             cpu_time, waiting);
+      start = end = waiting = next_index;
     }
-    no_process_execd = true;
   }
 }
 
+/*
+ * rr_batch
+ *
+ * Everything arrives together, so the queue is just the table order
+ * and nothing joins it later. A process needing r rounds finishes in
+ * round r, every process still in the queue gets a full quantum in
+ * each round, except in their last round.
+ *
+ * Processes are handled in order of the number of rounds they need.
+ * A Fenwick tree holds what each process still in the queue runs for
+ * in the current round, so the completion time of a process is the
+ * start of the round plus the sum up to and including its index.
+ * Rounds where nothing finishes are skipped over in one go.
+ *
+ * While there are two or more processes in the queue, every turn is a
+ * context switch. The last process can be left on its own, and then
+ * only its first turn alone might be a switch, it's not if it was the
+ * last to run in the round before.
+ */
+static void rr_batch(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  const int quantum = parameters->quantum;
+  const long long turn_cost = (long long) parameters->dispatch_cost +
+      parameters->switch_cost;
+
+  struct RoundsEntry *const order = malloc(sizeof(struct RoundsEntry) *
+                                           total_processes);
+  long long *const tree = calloc(total_processes + 1, sizeof(long long));
+
+  assert(order != NULL);
+  assert(tree != NULL);
+
+  for (int i = 0; i < total_processes; i++) {
+    order[i].rounds = turns_needed(process_table[i].burst_time_remaining,
+                                   quantum);
+    order[i].index = i;
+
+    fenwick_add(tree, total_processes, i, quantum + turn_cost);
+  }
+
+  qsort(order, total_processes, sizeof(struct RoundsEntry), compare_rounds);
+
+  long long round_start = process_table[0].arrival_time;
+  int rounds_done = 0;
+  int in_queue = total_processes;
+
+  // Highest index to finish in the last round a group finished in.
+  // If it's above the one left on its own, it ran after it in that
+  // round.
+  int last_finished = -1;
+
+  int group_start = 0;
+
+  while (group_start < total_processes && in_queue > 1) {
+    const int rounds = order[group_start].rounds;
+
+    int group_end = group_start;
+    while (group_end < total_processes && order[group_end].rounds == rounds) {
+      ++group_end;
+    }
+
+    // Full rounds where nobody finishes.
+    round_start += (rounds - 1 - rounds_done) * (quantum + turn_cost) *
+        in_queue;
+
+    // The last round for this group only runs what's left of each.
+    long long round_length = (quantum + turn_cost) * in_queue;
+
+    for (int i = group_start; i < group_end; i++) {
+      const int index = order[i].index;
+      const int last_run = process_table[index].burst_time_remaining -
+          (rounds - 1) * quantum;
+
+      fenwick_add(tree, total_processes, index, last_run - quantum);
+      round_length += last_run - quantum;
+    }
+
+    last_finished = -1;
+
+    for (int i = group_start; i < group_end; i++) {
+      const int index = order[i].index;
+
+      complete_process(&process_table[index],
+                       round_start + fenwick_sum(tree, index));
+
+      process_table[index].dispatch_count = rounds;
+      process_table[index].switch_count = rounds;
+
+      if (index > last_finished) {
+        last_finished = index;
+      }
+    }
+
+    // Now they're out of the queue.
+    for (int i = group_start; i < group_end; i++) {
+      const int index = order[i].index;
+      const int last_run = process_table[index].burst_time_remaining -
+          (rounds - 1) * quantum;
+
+      fenwick_add(tree, total_processes, index, -(last_run + turn_cost));
+      process_table[index].burst_time_remaining = 0;
+    }
+
+    round_start += round_length;
+    rounds_done = rounds;
+    in_queue -= group_end - group_start;
+    group_start = group_end;
+  }
+
+  // One left on its own, its turns come straight after each other.
+  if (group_start < total_processes) {
+    struct ProcessEntry *const process =
+        &process_table[order[group_start].index];
+
+    const int rounds = order[group_start].rounds;
+    const int turns = rounds - rounds_done;
+    const bool switched = (order[group_start].index < last_finished ||
+                           rounds_done == 0);
+
+    complete_process(process,
+                     round_start + process->burst_time_remaining -
+                     (long long) rounds_done * quantum +
+                     (long long) turns * parameters->dispatch_cost +
+                     (switched ? parameters->switch_cost : 0));
+
+    process->dispatch_count = rounds;
+    process->switch_count = rounds_done + (switched ? 1 : 0);
+    process->burst_time_remaining = 0;
+  }
+
+  free(tree);
+  free(order);
+}
+
+/*
+ * compare_rounds
+ *
+ * For qsort, fewest rounds first, table order when they're equal.
+ */
+static int compare_rounds(const void *first, const void *second) {
+  const struct RoundsEntry *const first_entry = first;
+  const struct RoundsEntry *const second_entry = second;
+
+  int result = first_entry->rounds - second_entry->rounds;
+
+  if (result == 0) {
+    result = first_entry->index - second_entry->index;
+  }
+
+  return result;
+}
+
+/*
+ * turns_needed
+ *
+ * How many turns a process with this much burst time left needs
+ * before it's done.
+ */
+static int turns_needed(const int burst_time, const int quantum) {
+  return (burst_time + quantum - 1) / quantum;
+}
+
+/*
+ * complete_process
+ *
+ * The process finished at cpu_time, work out our results.
+ */
+static void complete_process(struct ProcessEntry *const restrict process,
+                             const long long cpu_time) {
+  process->turnaround_time = cpu_time - process->arrival_time;
+  process->waiting_time = process->turnaround_time - process->burst_time;
+}
+
 /*
  * FindWaiting
  *
@@ -138,20 +500,106 @@ void rr_scheduler(struct ProcessEntry *const restrict process_table,
  */
 static int find_waiting(struct ProcessEntry *const restrict process_table,
                         const int total_processes,
-                        const int cpu_time,
+                        const long long cpu_time,
                         const int waiting) {
   int result = waiting;
 
-  for (int index = waiting; index < total_processes; ++index) {
-    if (process_table[index].burst_time_remaining != 0 &&
-        process_table[index].arrival_time <= cpu_time) {
-      result = index;
-    }
+  // Everything past the waiting index hasn't run yet, and the table is
+  // sorted, so we only need to go as far as the first one that hasn't
+  // arrived.
+  while (result + 1 < total_processes &&
+         process_table[result + 1].arrival_time <= cpu_time) {
+    ++result;
   }
 
   return result;
 }
 
+/*
+ * stable_passes
+ *
+ * Called at the start of a pass through the queue. Returns how many
+ * whole passes can be run where every process in the queue uses a
+ * full quantum, and nothing is added to the queue. That's limited by
+ * the process with the least burst time left, it mustn't finish, and
+ * by the next process to arrive, it mustn't have arrived when the
+ * first process of a pass has had its turn.
+ *
+ * Every turn in those passes has to cost the same, so with more than
+ * one process in the queue the first turn must be a switch, and with
+ * one it must not be. That's nearly always the case, if not a pass is
+ * run as normal first.
+ *
+ * Returned through the pointers are the number of processes in the
+ * queue, how long each of their turns take, and the index of the last
+ * one in the queue.
+ */
+static int stable_passes(
+    const struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const int start,
+    const int end,
+    const long long cpu_time,
+    const int last_run,
+    const struct SchedulerParameters *const restrict parameters,
+    int *const restrict in_queue,
+    int *const restrict turn_length,
+    int *const restrict last_in_queue) {
+
+  const int quantum = parameters->quantum;
+
+  int least_remaining = 0;
+  int first_in_queue = -1;
+  *in_queue = 0;
+  *last_in_queue = -1;
+
+  for (int index = start; index <= end; index++) {
+    const int remaining = process_table[index].burst_time_remaining;
+
+    if (remaining != 0) {
+      if (*in_queue == 0 || remaining < least_remaining) {
+        least_remaining = remaining;
+      }
+      if (first_in_queue < 0) {
+        first_in_queue = index;
+      }
+      *last_in_queue = index;
+      ++*in_queue;
+    }
+  }
+
+  long long passes = 0;
+  *turn_length = quantum + parameters->dispatch_cost;
+
+  if (*in_queue > 1) {
+    *turn_length += parameters->switch_cost;
+  }
+
+  if (*in_queue > 0 && (*in_queue > 1) == (first_in_queue != last_run)) {
+    passes = (least_remaining - 1) / quantum;
+
+    if (end + 1 < total_processes && passes > 0) {
+      // Pass p adds anything that's arrived by its first turn, at
+      // cpu_time + p * pass_length + turn_length.
+      const long long pass_length = (long long) *turn_length * *in_queue;
+      const long long until_arrival =
+          process_table[end + 1].arrival_time - cpu_time -
+          *turn_length;
+      long long before_arrival = 0;
+
+      if (until_arrival > 0) {
+        before_arrival = (until_arrival + pass_length - 1) / pass_length;
+      }
+
+      if (before_arrival < passes) {
+        passes = before_arrival;
+      }
+    }
+  }
+
+  return passes;
+}
+
 /*
  * Smallest
  *
@@ -12,6 +12,7 @@
 #define RR_SCHEDULER_H_
 
 #include "process_entry.h"
+#include "scheduler_parameters.h"
 
 /*
  * RR Scheduler
@@ -26,6 +27,6 @@
  */
 void rr_scheduler(struct ProcessEntry *const restrict process_table,
                   const int total_processes,
-                  const int quantum);
+                  const struct SchedulerParameters *const restrict parameters);
 
 #endif
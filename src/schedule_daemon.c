@@ -0,0 +1,1283 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The scheduling daemon. Listens on a Unix socket, and keeps every
+ * trace it has loaded, along with the results it has worked out for
+ * it, so asking again costs a stat of the file and nothing else.
+ *
+ * Requests are one to a line:
+ *
+ *   <scheduler> [-q quantum] [-s] <filename>
+ *
+ * The scheduler is one of the names the simulator shows, in any case.
+ * Without -q the quantum comes from the trace, -s asks for the spread
+ * as well as the averages. The filename is the rest of the line, so
+ * it can have spaces in it. Each response is what the simulator would
+ * show for that scheduler, or a line starting with ERROR, followed by
+ * an empty line. Responses on a connection come back in the order the
+ * requests were sent.
+ *
+ * All of the socket handling is done by the main thread with epoll,
+ * and nothing it does blocks. Loading traces and scheduling them is
+ * left to the worker pool, which a batch thread keeps running for as
+ * long as there are requests queued. Each worker takes the next
+ * request nobody has started, so one that turns up while a big trace
+ * is being worked on is taken by another worker straight away, rather
+ * than waiting for it. The main thread is told with an eventfd when a
+ * request is done, and sends the responses for a connection as soon
+ * as everything before them is done too.
+ *
+ * The loaded traces and their results are shared by the workers under
+ * the mutex, but loading and scheduling are done without it. A trace
+ * in use is counted, so one that's replaced because its file changed
+ * is only freed once nobody is using it.
+ *
+ * SIGINT and SIGTERM are blocked in every thread, and come in through
+ * a signalfd with everything else, so there's no window between
+ * checking for them and waiting in epoll.
+ */
+
+// For accept4, eventfd, signalfd, and the epoll and socket flags.
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "options.h"
+#include "scheduler.h"
+#include "scheduler_table.h"
+#include "thread.h"
+#include "worker_pool.h"
+
+/*
+ * Longest request line, anything longer closes the connection.
+ */
+#define REQUEST_LINE_SIZE 4096
+
+/*
+ * Most epoll events to deal with at once.
+ */
+#define MAX_EVENTS 64
+
+#define INITIAL_CAPACITY 64
+
+/*
+ * Fewest workers, whatever the CPUs, so a small request still has one
+ * to take it while a big one is being worked on.
+ */
+#define MIN_WORKERS 4
+
+// FNV-1a constants.
+#define FNV_OFFSET_BASIS UINT64_C(14695981039346656037)
+#define FNV_PRIME UINT64_C(1099511628211)
+
+/*
+ * Connection
+ *
+ * input holds what has been read that isn't a whole line yet. output
+ * holds responses the socket hasn't taken yet, from output_sent up to
+ * output_used.
+ *
+ * Once the client has finished sending, or something has gone wrong,
+ * closing is set, and the connection is closed as soon as everything
+ * has been sent. Nothing else is read from a closing connection.
+ *
+ * events is what epoll is watching the connection for. first_job to
+ * last_job are its requests that haven't been answered yet, in the
+ * order they came in, it isn't closed until they have been.
+ */
+struct Connection {
+  int fd;
+  bool closing;
+  uint32_t events;
+  struct Job *first_job;
+  struct Job *last_job;
+
+  char input[REQUEST_LINE_SIZE];
+  size_t input_used;
+
+  char *output;
+  size_t output_used;
+  size_t output_sent;
+  size_t output_capacity;
+};
+
+/*
+ * CachedResult
+ *
+ * A result for a cached trace, the other scheduler parameters are the
+ * daemon's and never change.
+ */
+struct CachedResult {
+  int scheduler;
+  int quantum;
+  struct SchedulerAverages averages;
+};
+
+/*
+ * CachedTrace
+ *
+ * A loaded trace, with enough from stat to tell when the file has
+ * changed, and every result worked out for it so far.
+ *
+ * users is how many jobs are using it. Once replaced is set it's no
+ * longer in the table, and it's freed when the last of them is done.
+ */
+struct CachedTrace {
+  char *filename;
+  dev_t device;
+  ino_t inode;
+  off_t size;
+  struct timespec modified;
+
+  struct Trace trace;
+
+  struct CachedResult *results;
+  int results_count;
+  int results_capacity;
+
+  int users;
+  bool replaced;
+};
+
+/*
+ * Job
+ *
+ * A request waiting for a response. If there was something wrong with
+ * it, error says what, and it's done without being run. Otherwise it's
+ * queued for the workers, which find the trace for filename, a copy,
+ * and fill in the rest.
+ *
+ * next is the connection's next job, which only the main thread
+ * follows, next_queued the next job waiting for a worker. done is set
+ * under the mutex once everything else has been filled in.
+ */
+struct Job {
+  struct Connection *connection;
+  struct Job *next;
+  struct Job *next_queued;
+
+  const char *error;
+  int scheduler;
+  int quantum;
+  bool spread;
+  char *filename;
+
+  bool done;
+  struct SchedulerAverages averages;
+};
+
+/*
+ * Daemon
+ *
+ * traces is open addressed on a hash of the filename, always a power
+ * of two in size. Traces are only ever replaced in it, never taken
+ * out.
+ *
+ * The main thread adds jobs to the end of the queue, from first_queued
+ * to last_queued, and the workers take them from the front. The mutex
+ * covers the queue, jobs_running, quit, whether each job is done, and
+ * the traces and their results. changed is signalled whenever a job is
+ * queued or finished, or it's time to quit.
+ */
+struct Daemon {
+  struct Options options;
+  int listen_fd;
+  int signal_fd;
+  int done_fd;
+  int epoll_fd;
+
+  struct Connection **connections;
+  int connections_count;
+  int connections_capacity;
+
+  struct CachedTrace **traces;
+  int traces_count;
+  int traces_capacity;
+
+  pthread_t batch_thread;
+  pthread_mutex_t mutex;
+  pthread_cond_t changed;
+  struct Job *first_queued;
+  struct Job *last_queued;
+  int jobs_running;
+  bool quit;
+
+  struct WorkerPool pool;
+  int total_workers;
+};
+
+// Forward decs
+static bool open_listener(struct Daemon *const restrict daemon);
+static bool watch_fd(struct Daemon *const restrict daemon, const int fd,
+                     void *const tag);
+static void accept_connections(struct Daemon *const restrict daemon);
+static void read_requests(struct Daemon *const restrict daemon,
+                          struct Connection *const restrict connection);
+static struct Job *new_job(struct Connection *const connection);
+static void add_job(struct Daemon *const restrict daemon,
+                    struct Connection *const connection,
+                    char *const restrict line);
+static void send_responses(struct Daemon *const restrict daemon);
+static void respond(struct Daemon *const restrict daemon,
+                    const struct Job *const restrict job);
+static void *run_batch_thread(void *daemon_in);
+static void run_job_worker(void *daemon_in, const int worker);
+static void run_job(struct Daemon *const restrict daemon,
+                    struct Job *const restrict job);
+static void queue_output(struct Connection *const restrict connection,
+                         const char *const restrict text,
+                         const size_t length);
+static void write_output(struct Daemon *const restrict daemon,
+                         struct Connection *const restrict connection);
+static void watch_connection(struct Daemon *const restrict daemon,
+                             struct Connection *const restrict connection);
+static void close_finished(struct Daemon *const restrict daemon);
+static void close_connection(struct Daemon *const restrict daemon,
+                             struct Connection *const restrict connection);
+static struct CachedTrace *find_trace(struct Daemon *const restrict daemon,
+                                      const char *const restrict filename,
+                                      const char **const restrict error);
+static void release_trace(struct Daemon *const restrict daemon,
+                          struct CachedTrace *const restrict cached);
+static bool same_file(const struct CachedTrace *const restrict cached,
+                      const struct stat *const restrict file_stat);
+static struct CachedTrace **trace_slot(struct Daemon *const restrict daemon,
+                                       const char *const restrict filename);
+static void grow_traces(struct Daemon *const restrict daemon);
+static void destroy_cached_trace(struct CachedTrace *const restrict cached);
+static struct CachedResult *find_cached_result(
+    struct CachedTrace *const restrict cached,
+    const int scheduler,
+    const int quantum);
+static void add_cached_result(struct CachedTrace *const restrict cached,
+                              const struct Job *const restrict job);
+static uint64_t hash_filename(const char *const restrict filename);
+
+/*
+ * Main
+ *
+ * Takes the same options as the other programs, -l is required and
+ * -f, -p, -c and -t are ignored. Runs until interrupted or terminated.
+ */
+int main(int argc, char *argv[]) {
+  struct Daemon daemon;
+
+  if (!parse_options(argc, argv, &daemon.options)) {
+    return EXIT_FAILURE;
+  }
+
+  if (daemon.options.socket_filename == NULL) {
+    fprintf(stderr, "%s: a socket must be given with -l\n", argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // Blocked before any threads start, so they all have them blocked.
+  sigset_t stop_signals;
+  sigemptyset(&stop_signals);
+  sigaddset(&stop_signals, SIGINT);
+  sigaddset(&stop_signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &stop_signals, NULL);
+
+  if (!open_listener(&daemon)) {
+    return EXIT_FAILURE;
+  }
+
+  daemon.signal_fd = signalfd(-1, &stop_signals, SFD_NONBLOCK | SFD_CLOEXEC);
+  daemon.done_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+  if (daemon.signal_fd < 0 || daemon.done_fd < 0 ||
+      !watch_fd(&daemon, daemon.signal_fd, &daemon.signal_fd) ||
+      !watch_fd(&daemon, daemon.done_fd, &daemon.done_fd)) {
+    perror("main() - signalfd and eventfd");
+    unlink(daemon.options.socket_filename);
+    return EXIT_FAILURE;
+  }
+
+  daemon.connections_count = 0;
+  daemon.connections_capacity = INITIAL_CAPACITY;
+  daemon.connections = malloc(sizeof(struct Connection *) *
+                              daemon.connections_capacity);
+  assert(daemon.connections != NULL);
+
+  daemon.traces_count = 0;
+  daemon.traces_capacity = INITIAL_CAPACITY;
+  daemon.traces = calloc(daemon.traces_capacity,
+                         sizeof(struct CachedTrace *));
+  assert(daemon.traces != NULL);
+
+  daemon.first_queued = NULL;
+  daemon.last_queued = NULL;
+  daemon.jobs_running = 0;
+  daemon.quit = false;
+  pthread_mutex_init(&daemon.mutex, NULL);
+  pthread_cond_init(&daemon.changed, NULL);
+
+  long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+  daemon.total_workers = (cpus > MIN_WORKERS) ? (int) cpus : MIN_WORKERS;
+  init_worker_pool(&daemon.pool, daemon.total_workers, &run_job_worker,
+                   &daemon);
+
+  int error = pthread_create(&daemon.batch_thread, NULL, &run_batch_thread,
+                             &daemon);
+  assert(error == 0);
+  (void) error;
+
+  struct epoll_event events[MAX_EVENTS];
+  bool stopping = false;
+
+  while (!stopping) {
+    int ready = epoll_wait(daemon.epoll_fd, events, MAX_EVENTS, -1);
+
+    if (ready < 0 && errno != EINTR) {
+      perror("main() - epoll_wait");
+      stopping = true;
+    }
+
+    for (int i = 0; i < ready; i++) {
+      void *const tag = events[i].data.ptr;
+
+      if (tag == &daemon.listen_fd) {
+        accept_connections(&daemon);
+      } else if (tag == &daemon.signal_fd) {
+        // Only SIGINT or SIGTERM come this way, which doesn't matter.
+        stopping = true;
+      } else if (tag == &daemon.done_fd) {
+        // The responses are sent below, with any for errors.
+        eventfd_t count;
+        eventfd_read(daemon.done_fd, &count);
+      } else {
+        struct Connection *const connection = tag;
+
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+          read_requests(&daemon, connection);
+        }
+
+        if (events[i].events & EPOLLOUT) {
+          write_output(&daemon, connection);
+        }
+      }
+    }
+
+    send_responses(&daemon);
+    close_finished(&daemon);
+  }
+
+  // Jobs already running are finished first, the rest are dropped.
+  pthread_mutex_lock(&daemon.mutex);
+  daemon.quit = true;
+  pthread_cond_broadcast(&daemon.changed);
+  pthread_mutex_unlock(&daemon.mutex);
+  pthread_join(daemon.batch_thread, NULL);
+
+  destroy_worker_pool(&daemon.pool);
+  pthread_cond_destroy(&daemon.changed);
+  pthread_mutex_destroy(&daemon.mutex);
+
+  while (daemon.connections_count > 0) {
+    close_connection(&daemon, daemon.connections[0]);
+  }
+
+  for (int i = 0; i < daemon.traces_capacity; i++) {
+    if (daemon.traces[i] != NULL) {
+      destroy_cached_trace(daemon.traces[i]);
+    }
+  }
+
+  free(daemon.traces);
+  free(daemon.connections);
+
+  close(daemon.epoll_fd);
+  close(daemon.done_fd);
+  close(daemon.signal_fd);
+  close(daemon.listen_fd);
+  unlink(daemon.options.socket_filename);
+
+  return EXIT_SUCCESS;
+}
+
+/*
+ * open_listener
+ *
+ * Creates the socket, and the epoll instance watching it. A socket
+ * file left behind by a daemon that's gone is replaced, one that's
+ * still being listened on isn't. Returns false, having said why, if
+ * that can't be done.
+ */
+static bool open_listener(struct Daemon *const restrict daemon) {
+  bool result = true;
+  struct sockaddr_un address;
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+
+  if (strlen(daemon->options.socket_filename) >= sizeof(address.sun_path)) {
+    fprintf(stderr, "Socket name is too long: %s\n",
+            daemon->options.socket_filename);
+    result = false;
+  } else {
+    strcpy(address.sun_path, daemon->options.socket_filename);
+
+    daemon->listen_fd = socket(AF_UNIX,
+                               SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (daemon->listen_fd < 0) {
+      perror("open_listener() - socket");
+      result = false;
+    } else if (bind(daemon->listen_fd, (struct sockaddr *) &address,
+                    sizeof(address)) != 0) {
+      bool stale = false;
+
+      if (errno == EADDRINUSE) {
+        // Only replace it if nobody answers.
+        int probe = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+
+        stale = probe >= 0 &&
+            connect(probe, (struct sockaddr *) &address,
+                    sizeof(address)) != 0 &&
+            errno == ECONNREFUSED;
+
+        if (probe >= 0) {
+          close(probe);
+        }
+      }
+
+      if (!stale || unlink(address.sun_path) != 0 ||
+          bind(daemon->listen_fd, (struct sockaddr *) &address,
+               sizeof(address)) != 0) {
+        perror("open_listener() - bind");
+        close(daemon->listen_fd);
+        result = false;
+      }
+    }
+  }
+
+  if (result && listen(daemon->listen_fd, SOMAXCONN) != 0) {
+    perror("open_listener() - listen");
+    close(daemon->listen_fd);
+    unlink(address.sun_path);
+    result = false;
+  }
+
+  if (result) {
+    daemon->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (daemon->epoll_fd < 0 ||
+        !watch_fd(daemon, daemon->listen_fd, &daemon->listen_fd)) {
+      perror("open_listener() - epoll");
+      close(daemon->listen_fd);
+      unlink(address.sun_path);
+      result = false;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * watch_fd
+ *
+ * Has epoll watch one of the daemon's own file descriptors for input.
+ * The tag is what its events come back with, the address of where the
+ * daemon keeps it, so they can't be mistaken for a connection.
+ */
+static bool watch_fd(struct Daemon *const restrict daemon, const int fd,
+                     void *const tag) {
+  struct epoll_event event;
+  event.events = EPOLLIN;
+  event.data.ptr = tag;
+
+  return epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+/*
+ * accept_connections
+ *
+ * Takes every connection that's waiting, and starts watching it for
+ * requests.
+ */
+static void accept_connections(struct Daemon *const restrict daemon) {
+  int fd;
+
+  while ((fd = accept4(daemon->listen_fd, NULL, NULL,
+                       SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+    struct Connection *const connection = malloc(sizeof(struct Connection));
+    assert(connection != NULL);
+
+    connection->fd = fd;
+    connection->closing = false;
+    connection->events = EPOLLIN;
+    connection->first_job = NULL;
+    connection->last_job = NULL;
+    connection->input_used = 0;
+    connection->output = NULL;
+    connection->output_used = 0;
+    connection->output_sent = 0;
+    connection->output_capacity = 0;
+
+    struct epoll_event event;
+    event.events = EPOLLIN;
+    event.data.ptr = connection;
+
+    if (epoll_ctl(daemon->epoll_fd, EPOLL_CTL_ADD, fd, &event) != 0) {
+      perror("accept_connections() - epoll_ctl");
+      close(fd);
+      free(connection);
+    } else {
+      if (daemon->connections_count == daemon->connections_capacity) {
+        daemon->connections_capacity *= 2;
+        daemon->connections = realloc(daemon->connections,
+                                      sizeof(struct Connection *) *
+                                      daemon->connections_capacity);
+        assert(daemon->connections != NULL);
+      }
+
+      daemon->connections[daemon->connections_count++] = connection;
+    }
+  }
+
+  if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+    perror("accept_connections() - accept");
+  }
+}
+
+/*
+ * read_requests
+ *
+ * Reads everything the connection has for us, adding a job for each
+ * whole line. Once the client has finished, anything left without a
+ * newline is the last line.
+ */
+static void read_requests(struct Daemon *const restrict daemon,
+                          struct Connection *const restrict connection) {
+  bool keep_reading = !connection->closing;
+
+  while (keep_reading) {
+    ssize_t length = read(connection->fd,
+                          connection->input + connection->input_used,
+                          REQUEST_LINE_SIZE - connection->input_used);
+
+    if (length > 0) {
+      connection->input_used += length;
+
+      char *line = connection->input;
+      char *end;
+
+      while ((end = memchr(line, '\n',
+                           connection->input + connection->input_used -
+                           line)) != NULL) {
+        *end = '\0';
+        add_job(daemon, connection, line);
+        line = end + 1;
+      }
+
+      connection->input_used -= line - connection->input;
+      memmove(connection->input, line, connection->input_used);
+
+      if (connection->input_used == REQUEST_LINE_SIZE) {
+        // As a job, so it's answered after what came before it.
+        struct Job *const job = new_job(connection);
+        job->error = "request too long";
+        job->done = true;
+        connection->closing = true;
+        keep_reading = false;
+      }
+    } else if (length == 0) {
+      // Client's done sending, finish off what it's asked for. There's
+      // always room to end the last line, a full buffer would already
+      // have closed the connection.
+      if (connection->input_used > 0) {
+        connection->input[connection->input_used] = '\0';
+        add_job(daemon, connection, connection->input);
+        connection->input_used = 0;
+      }
+
+      connection->closing = true;
+      keep_reading = false;
+    } else {
+      if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+        connection->closing = true;
+      }
+      keep_reading = (errno == EINTR);
+    }
+  }
+  watch_connection(daemon, connection);
+}
+
+/*
+ * new_job
+ *
+ * Adds a job to the end of the connection's, with nothing asked for
+ * yet. It isn't queued.
+ */
+static struct Job *new_job(struct Connection *const connection) {
+  struct Job *const job = malloc(sizeof(struct Job));
+  assert(job != NULL);
+
+  job->connection = connection;
+  job->next = NULL;
+  job->next_queued = NULL;
+  job->error = NULL;
+  job->scheduler = -1;
+  job->quantum = 0;
+  job->spread = false;
+  job->filename = NULL;
+  job->done = false;
+
+  if (connection->last_job != NULL) {
+    connection->last_job->next = job;
+  } else {
+    connection->first_job = job;
+  }
+
+  connection->last_job = job;
+
+  return job;
+}
+
+/*
+ * add_job
+ *
+ * Works out what a request line is asking for, and queues it for the
+ * workers. Bad requests still get a job, so the error goes back in
+ * order with everything else.
+ */
+static void add_job(struct Daemon *const restrict daemon,
+                    struct Connection *const connection,
+                    char *const restrict line) {
+  struct Job *const job = new_job(connection);
+
+  // Clients on a terminal send \r\n.
+  size_t length = strlen(line);
+  if (length > 0 && line[length - 1] == '\r') {
+    line[length - 1] = '\0';
+  }
+
+  char *position = line + strspn(line, " \t");
+  char *word_end = position + strcspn(position, " \t");
+  const bool had_more = (*word_end != '\0');
+  *word_end = '\0';
+
+  job->scheduler = find_scheduler(position);
+  position = had_more ? word_end + 1 : word_end;
+
+  if (job->scheduler < 0) {
+    job->error = "unknown scheduler";
+  }
+
+  bool options_done = false;
+
+  while (job->error == NULL && !options_done) {
+    position += strspn(position, " \t");
+
+    if (strncmp(position, "-s", 2) == 0 &&
+        (position[2] == ' ' || position[2] == '\t')) {
+      job->spread = true;
+      position += 2;
+    } else if (strncmp(position, "-q", 2) == 0 &&
+               (position[2] == ' ' || position[2] == '\t')) {
+      char *end;
+      long quantum = strtol(position + 2, &end, 10);
+
+      if (end == position + 2 || quantum < 1 || quantum > 9999 ||
+          (*end != ' ' && *end != '\t')) {
+        job->error = "bad quantum";
+      } else {
+        job->quantum = (int) quantum;
+        position = end;
+      }
+    } else {
+      options_done = true;
+    }
+  }
+
+  if (job->error == NULL && *position == '\0') {
+    job->error = "no trace given";
+  }
+
+  if (job->error != NULL) {
+    job->done = true;
+  } else {
+    // The line is gone once the next is read.
+    job->filename = strdup(position);
+    assert(job->filename != NULL);
+
+    pthread_mutex_lock(&daemon->mutex);
+
+    if (daemon->last_queued != NULL) {
+      daemon->last_queued->next_queued = job;
+    } else {
+      daemon->first_queued = job;
+    }
+
+    daemon->last_queued = job;
+    pthread_cond_broadcast(&daemon->changed);
+    pthread_mutex_unlock(&daemon->mutex);
+  }
+}
+
+/*
+ * send_responses
+ *
+ * Queues the response for every job that's done, and has nothing
+ * before it on its connection still to be done, then sends what the
+ * sockets will take.
+ */
+static void send_responses(struct Daemon *const restrict daemon) {
+  pthread_mutex_lock(&daemon->mutex);
+
+  for (int i = 0; i < daemon->connections_count; i++) {
+    struct Connection *const connection = daemon->connections[i];
+    struct Job *job;
+
+    while ((job = connection->first_job) != NULL && job->done) {
+      respond(daemon, job);
+
+      connection->first_job = job->next;
+      if (connection->first_job == NULL) {
+        connection->last_job = NULL;
+      }
+
+      free(job->filename);
+      free(job);
+    }
+  }
+
+  pthread_mutex_unlock(&daemon->mutex);
+
+  for (int i = 0; i < daemon->connections_count; i++) {
+    struct Connection *const connection = daemon->connections[i];
+
+    if (connection->output_used > 0 && !(connection->events & EPOLLOUT)) {
+      write_output(daemon, connection);
+    }
+  }
+}
+
+/*
+ * respond
+ *
+ * Queues the job's response on its connection, without sending it.
+ */
+static void respond(struct Daemon *const restrict daemon,
+                    const struct Job *const restrict job) {
+  char response[OUTPUT_BUFFER_SIZE + 1];
+  int length;
+
+  if (job->error != NULL) {
+    length = snprintf(response, sizeof(response), "ERROR %s\n", job->error);
+  } else {
+    length = format_results(response, OUTPUT_BUFFER_SIZE,
+                            SCHEDULERS[job->scheduler].name,
+                            &job->averages, job->spread,
+                            &daemon->options.parameters);
+  }
+
+  if (length >= OUTPUT_BUFFER_SIZE) {
+    length = OUTPUT_BUFFER_SIZE - 1;
+  }
+
+  // An empty line ends each response.
+  response[length++] = '\n';
+
+  queue_output(job->connection, response, length);
+}
+
+/*
+ * run_batch_thread
+ *
+ * The batch thread, runs a batch on the worker pool whenever there are
+ * jobs queued, until it's time to quit. The batch lasts until the
+ * queue is empty and nothing is running, so jobs queued while it's
+ * going are taken by whichever worker is free.
+ */
+static void *run_batch_thread(void *daemon_in) {
+  struct Daemon *const daemon = daemon_in;
+
+  pthread_mutex_lock(&daemon->mutex);
+
+  while (!daemon->quit) {
+    if (daemon->first_queued != NULL) {
+      pthread_mutex_unlock(&daemon->mutex);
+      run_batch(&daemon->pool);
+      pthread_mutex_lock(&daemon->mutex);
+    } else {
+      pthread_cond_wait(&daemon->changed, &daemon->mutex);
+    }
+  }
+
+  pthread_mutex_unlock(&daemon->mutex);
+
+  return NULL;
+}
+
+/*
+ * run_job_worker
+ *
+ * Worker function for the pool, each worker runs the next job in the
+ * queue until there are none left. While other workers are still
+ * running jobs it waits for more to be queued rather than finishing,
+ * as they can't take any new ones until the batch is over.
+ */
+static void run_job_worker(void *daemon_in, const int worker) {
+  struct Daemon *const daemon = daemon_in;
+  bool working = true;
+  (void) worker;
+
+  pthread_mutex_lock(&daemon->mutex);
+
+  while (working) {
+    struct Job *const job = daemon->first_queued;
+
+    if (job != NULL && !daemon->quit) {
+      daemon->first_queued = job->next_queued;
+      if (daemon->first_queued == NULL) {
+        daemon->last_queued = NULL;
+      }
+      ++daemon->jobs_running;
+
+      pthread_mutex_unlock(&daemon->mutex);
+      run_job(daemon, job);
+      pthread_mutex_lock(&daemon->mutex);
+
+      job->done = true;
+      --daemon->jobs_running;
+      pthread_cond_broadcast(&daemon->changed);
+      eventfd_write(daemon->done_fd, 1);
+    } else if (daemon->jobs_running > 0) {
+      pthread_cond_wait(&daemon->changed, &daemon->mutex);
+    } else {
+      working = false;
+    }
+  }
+
+  pthread_mutex_unlock(&daemon->mutex);
+}
+
+/*
+ * run_job
+ *
+ * Finds the trace for the job, loading it if it has to, and answers it
+ * from the cache if it can, or by scheduling it and keeping the result
+ * in the cache if it can't. Called without the mutex.
+ */
+static void run_job(struct Daemon *const restrict daemon,
+                    struct Job *const restrict job) {
+  struct CachedTrace *const cached = find_trace(daemon, job->filename,
+                                                &job->error);
+
+  if (cached != NULL) {
+    if (job->quantum == 0) {
+      job->quantum = cached->trace.quantum;
+    }
+
+    pthread_mutex_lock(&daemon->mutex);
+    const struct CachedResult *const result =
+        find_cached_result(cached, job->scheduler, job->quantum);
+
+    if (result != NULL) {
+      job->averages = result->averages;
+    }
+    pthread_mutex_unlock(&daemon->mutex);
+
+    if (result == NULL) {
+      struct SchedulerParameters parameters = daemon->options.parameters;
+      parameters.quantum = job->quantum;
+      parameters.timeline = NULL;
+
+      job->averages = schedule_trace(&cached->trace,
+                                     SCHEDULERS[job->scheduler].scheduler,
+                                     &parameters);
+
+      // Another worker can have worked it out in the meantime.
+      pthread_mutex_lock(&daemon->mutex);
+      if (find_cached_result(cached, job->scheduler, job->quantum) == NULL) {
+        add_cached_result(cached, job);
+      }
+      pthread_mutex_unlock(&daemon->mutex);
+    }
+
+    release_trace(daemon, cached);
+  }
+}
+
+/*
+ * queue_output
+ *
+ * Adds text to what's waiting to be sent on the connection. Nothing is
+ * sent yet.
+ */
+static void queue_output(struct Connection *const restrict connection,
+                         const char *const restrict text,
+                         const size_t length) {
+  if (connection->output_used + length > connection->output_capacity) {
+    size_t new_capacity = (connection->output_capacity > 0) ?
+        connection->output_capacity : REQUEST_LINE_SIZE;
+
+    while (new_capacity < connection->output_used + length) {
+      new_capacity *= 2;
+    }
+
+    connection->output = realloc(connection->output, new_capacity);
+    assert(connection->output != NULL);
+    connection->output_capacity = new_capacity;
+  }
+
+  memcpy(connection->output + connection->output_used, text, length);
+  connection->output_used += length;
+}
+
+/*
+ * write_output
+ *
+ * Sends as much of what's waiting as the socket will take. If it
+ * won't take it all, epoll lets us know when it will.
+ */
+static void write_output(struct Daemon *const restrict daemon,
+                         struct Connection *const restrict connection) {
+  bool keep_writing = true;
+
+  while (keep_writing && connection->output_sent < connection->output_used) {
+    ssize_t sent = send(connection->fd,
+                        connection->output + connection->output_sent,
+                        connection->output_used - connection->output_sent,
+                        MSG_NOSIGNAL);
+
+    if (sent >= 0) {
+      connection->output_sent += sent;
+    } else if (errno != EINTR) {
+      if (errno != EAGAIN && errno != EWOULDBLOCK) {
+        // Nobody to send it to.
+        connection->closing = true;
+        connection->output_sent = connection->output_used;
+      }
+      keep_writing = false;
+    }
+  }
+
+  if (connection->output_sent == connection->output_used) {
+    connection->output_sent = 0;
+    connection->output_used = 0;
+  }
+
+  watch_connection(daemon, connection);
+}
+
+/*
+ * watch_connection
+ *
+ * Makes sure epoll is watching the connection for what it needs,
+ * requests unless it's closing, and room to send if there's anything
+ * waiting to go.
+ */
+static void watch_connection(struct Daemon *const restrict daemon,
+                             struct Connection *const restrict connection) {
+  uint32_t events = connection->closing ? 0 : EPOLLIN;
+
+  if (connection->output_used > 0) {
+    events |= EPOLLOUT;
+  }
+
+  if (events != connection->events) {
+    struct epoll_event event;
+    event.events = events;
+    event.data.ptr = connection;
+
+    epoll_ctl(daemon->epoll_fd, EPOLL_CTL_MOD, connection->fd, &event);
+    connection->events = events;
+  }
+}
+
+/*
+ * close_finished
+ *
+ * Closes every connection that's closing, has had all its requests
+ * answered, and has nothing left to send, so no job refers to it.
+ */
+static void close_finished(struct Daemon *const restrict daemon) {
+  int i = 0;
+
+  while (i < daemon->connections_count) {
+    struct Connection *const connection = daemon->connections[i];
+
+    if (connection->closing && connection->first_job == NULL &&
+        connection->output_used == 0) {
+      // Moves the last connection into this slot.
+      close_connection(daemon, connection);
+    } else {
+      ++i;
+    }
+  }
+}
+
+/*
+ * close_connection
+ *
+ * Closes the connection and forgets about it, whatever state it's in.
+ * Any jobs it still has are freed, so none of them can be running.
+ */
+static void close_connection(struct Daemon *const restrict daemon,
+                             struct Connection *const restrict connection) {
+  int index = 0;
+
+  while (daemon->connections[index] != connection) {
+    ++index;
+  }
+
+  daemon->connections[index] =
+      daemon->connections[--daemon->connections_count];
+
+  while (connection->first_job != NULL) {
+    struct Job *const job = connection->first_job;
+    connection->first_job = job->next;
+    free(job->filename);
+    free(job);
+  }
+
+  // Closing the socket takes it out of epoll.
+  close(connection->fd);
+  free(connection->output);
+  free(connection);
+}
+
+/*
+ * find_trace
+ *
+ * Returns the cached trace for the file, loading it if it isn't
+ * cached, or the file has changed since it was, and counts the caller
+ * as using it until it calls release_trace. Returns NULL, with error
+ * set, if the file can't be read. Called without the mutex, which
+ * isn't held while loading.
+ */
+static struct CachedTrace *find_trace(struct Daemon *const restrict daemon,
+                                      const char *const restrict filename,
+                                      const char **const restrict error) {
+  struct CachedTrace *result = NULL;
+  struct stat file_stat;
+
+  if (stat(filename, &file_stat) != 0) {
+    *error = "couldn't read trace";
+  } else {
+    pthread_mutex_lock(&daemon->mutex);
+    struct CachedTrace *const cached = *trace_slot(daemon, filename);
+
+    if (cached != NULL && same_file(cached, &file_stat)) {
+      ++cached->users;
+      result = cached;
+    }
+    pthread_mutex_unlock(&daemon->mutex);
+
+    if (result == NULL) {
+      struct CachedTrace *const loaded = malloc(sizeof(struct CachedTrace));
+      assert(loaded != NULL);
+
+      if (!load_trace(filename, &loaded->trace)) {
+        // Whatever was cached is left, the file is tried again next time.
+        free(loaded);
+        *error = "couldn't read trace";
+      } else {
+        loaded->filename = strdup(filename);
+        assert(loaded->filename != NULL);
+
+        loaded->device = file_stat.st_dev;
+        loaded->inode = file_stat.st_ino;
+        loaded->size = file_stat.st_size;
+        loaded->modified = file_stat.st_mtim;
+
+        loaded->results = NULL;
+        loaded->results_count = 0;
+        loaded->results_capacity = 0;
+
+        loaded->users = 1;
+        loaded->replaced = false;
+        result = loaded;
+
+        pthread_mutex_lock(&daemon->mutex);
+        struct CachedTrace **const slot = trace_slot(daemon, filename);
+
+        if (*slot != NULL) {
+          // Changed, or another worker loaded it at the same time.
+          (*slot)->replaced = true;
+
+          if ((*slot)->users == 0) {
+            destroy_cached_trace(*slot);
+          }
+
+          *slot = loaded;
+        } else {
+          *slot = loaded;
+          ++daemon->traces_count;
+
+          // Keep the table no more than half full.
+          if (daemon->traces_count * 2 > daemon->traces_capacity) {
+            grow_traces(daemon);
+          }
+        }
+        pthread_mutex_unlock(&daemon->mutex);
+      }
+    }
+  }
+
+  return result;
+}
+
+/*
+ * release_trace
+ *
+ * The caller has finished with a trace from find_trace, which is freed
+ * if it's been replaced and nobody else is using it either.
+ */
+static void release_trace(struct Daemon *const restrict daemon,
+                          struct CachedTrace *const restrict cached) {
+  pthread_mutex_lock(&daemon->mutex);
+
+  if (--cached->users == 0 && cached->replaced) {
+    destroy_cached_trace(cached);
+  }
+
+  pthread_mutex_unlock(&daemon->mutex);
+}
+
+/*
+ * same_file
+ *
+ * Whether the file is the one the trace was loaded from, as it was.
+ */
+static bool same_file(const struct CachedTrace *const restrict cached,
+                      const struct stat *const restrict file_stat) {
+  return cached->device == file_stat->st_dev &&
+      cached->inode == file_stat->st_ino &&
+      cached->size == file_stat->st_size &&
+      cached->modified.tv_sec == file_stat->st_mtim.tv_sec &&
+      cached->modified.tv_nsec == file_stat->st_mtim.tv_nsec;
+}
+
+/*
+ * trace_slot
+ *
+ * Where the file's trace is in the table, or where it would go.
+ */
+static struct CachedTrace **trace_slot(struct Daemon *const restrict daemon,
+                                       const char *const restrict filename) {
+  const int mask = daemon->traces_capacity - 1;
+  int index = (int) (hash_filename(filename) & mask);
+
+  while (daemon->traces[index] != NULL &&
+         strcmp(daemon->traces[index]->filename, filename) != 0) {
+    index = (index + 1) & mask;
+  }
+
+  return &daemon->traces[index];
+}
+
+/*
+ * grow_traces
+ *
+ * Doubles the size of the trace table, putting everything back in
+ * where it now belongs. The traces themselves don't move, so jobs can
+ * keep pointing at them.
+ */
+static void grow_traces(struct Daemon *const restrict daemon) {
+  struct CachedTrace **const old_traces = daemon->traces;
+  const int old_capacity = daemon->traces_capacity;
+
+  daemon->traces_capacity *= 2;
+  daemon->traces = calloc(daemon->traces_capacity,
+                          sizeof(struct CachedTrace *));
+  assert(daemon->traces != NULL);
+
+  for (int i = 0; i < old_capacity; i++) {
+    if (old_traces[i] != NULL) {
+      *trace_slot(daemon, old_traces[i]->filename) = old_traces[i];
+    }
+  }
+
+  free(old_traces);
+}
+
+/*
+ * destroy_cached_trace
+ *
+ * Frees the cached trace and everything it holds.
+ */
+static void destroy_cached_trace(struct CachedTrace *const restrict cached) {
+  destroy_trace(&cached->trace);
+  free(cached->results);
+  free(cached->filename);
+  free(cached);
+}
+
+/*
+ * find_cached_result
+ *
+ * Returns the result already worked out for the trace with the
+ * scheduler and quantum, NULL if there isn't one. A trace only ever
+ * has a few, so they're just searched.
+ */
+static struct CachedResult *find_cached_result(
+    struct CachedTrace *const restrict cached,
+    const int scheduler,
+    const int quantum) {
+  struct CachedResult *result = NULL;
+
+  for (int i = 0; i < cached->results_count && result == NULL; i++) {
+    if (cached->results[i].scheduler == scheduler &&
+        cached->results[i].quantum == quantum) {
+      result = &cached->results[i];
+    }
+  }
+
+  return result;
+}
+
+/*
+ * add_cached_result
+ *
+ * Keeps the job's result with its trace.
+ */
+static void add_cached_result(struct CachedTrace *const restrict cached,
+                              const struct Job *const restrict job) {
+  if (cached->results_count == cached->results_capacity) {
+    cached->results_capacity = (cached->results_capacity > 0) ?
+        cached->results_capacity * 2 : NUM_SCHEDULERS;
+    cached->results = realloc(cached->results, sizeof(struct CachedResult) *
+                              cached->results_capacity);
+    assert(cached->results != NULL);
+  }
+
+  struct CachedResult *const result = &cached->results[cached->results_count++];
+  result->scheduler = job->scheduler;
+  result->quantum = job->quantum;
+  result->averages = job->averages;
+}
+
+/*
+ * hash_filename
+ *
+ * FNV-1a hash of the filename, for the trace table.
+ */
+static uint64_t hash_filename(const char *const restrict filename) {
+  uint64_t hash = FNV_OFFSET_BASIS;
+
+  for (const char *c = filename; *c != '\0'; c++) {
+    hash ^= (unsigned char) *c;
+    hash *= FNV_PRIME;
+  }
+
+  return hash;
+}
@@ -9,63 +9,590 @@
  * everything else around that is common.
  */
 
+// For strdup.
+#define _POSIX_C_SOURCE 200809L
+
 #include <assert.h>
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "scheduler.h"
 
 #include "file_reader.h"
+#include "grouped_scheduler.h"
 #include "linked_list.h"
 #include "sorting.h"
+#include "sjf_scheduler.h"
+#include "split_scheduler.h"
+#include "stream_scheduler.h"
+#include "trace_loader.h"
 #include "user_input.h"
 
+// Forward decs
+static void reset_trace_state(struct TraceState *const restrict state,
+                              const char *const restrict filename);
+static void add_to_trace_state(
+    struct TraceState *const restrict state,
+    const struct ProcessEntry *const new_entries,
+    const int new_count,
+    const bool reschedule,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters);
+static void total_trace_state(struct TraceState *const restrict state,
+                              const struct ProcessEntry *const entries,
+                              const int count);
+static void add_trace_phases(struct TraceState *const restrict state,
+                             const struct LinkedList *const restrict
+                             process_list,
+                             struct ProcessEntry *const new_entries,
+                             const int new_count);
+static bool load_counted_trace(const char *const restrict filename,
+                               struct Trace *const restrict trace,
+                               struct TraceLoader *const loader,
+                               struct PerfCounters *const counters);
+
 /*
  * run_scheduler
  *
  * Given a filename and a function pointer to a scheduler function,
- * return the waiting time and the turnaround time averages.
+ * return the waiting time and the turnaround time averages. When the
+ * stages are counted the trace is never streamed, so each stage is
+ * done on its own.
  */
-struct SchedulerAverages run_scheduler(const char *const filename,
-                                       const Scheduler scheduler_to_use) {
-  struct LinkedList process_list;
-  int quantum;
+struct SchedulerAverages run_scheduler(
+    const char *const filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters) {
+  struct Trace trace;
+  struct SchedulerAverages averages = {0.0,0.0};
+
+  if (parameters->counters != NULL) {
+    reset_perf_counters(parameters->counters);
+  }
+
+  if (parameters->stream && parameters->counters == NULL &&
+      can_stream(scheduler_to_use, parameters)) {
+    averages = stream_scheduler(filename, scheduler_to_use, parameters);
+  } else if (!load_counted_trace(filename, &trace, parameters->loader,
+                                 parameters->counters)) {
+    perror("main() - File Error");
+  } else {
+    struct SchedulerParameters file_parameters = *parameters;
+    file_parameters.quantum = trace.quantum;
+
+    if (parameters->counters != NULL) {
+      parameters->counters->records = trace.count;
+    }
+
+    averages = schedule_trace(&trace, scheduler_to_use, &file_parameters);
+
+    destroy_trace(&trace);
+  }
+
+  return averages;
+}
+
+bool load_trace(const char *const restrict filename,
+                struct Trace *const restrict trace) {
+  return load_counted_trace(filename, trace, NULL, NULL);
+}
+
+void destroy_trace(struct Trace *const restrict trace) {
+  free(trace->entries);
+  free(trace->phases);
+  free(trace->groups);
+  free(trace->sjf_groups);
+
+  trace->entries = NULL;
+  trace->count = 0;
+  trace->phases = NULL;
+  trace->phase_count = 0;
+  trace->groups = NULL;
+  trace->group_count = 0;
+  trace->sjf_groups = NULL;
+  trace->sjf_group_count = 0;
+}
+
+struct SchedulerAverages schedule_trace(
+    const struct Trace *const restrict trace,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters) {
+  struct SchedulerAverages averages = {0.0,0.0};
+
+  if (trace->count > 0) {
+    struct SchedulerParameters trace_parameters = *parameters;
+
+    if (trace->phase_count > 0) {
+      trace_parameters.phases = trace->phases;
+    } else {
+      trace_parameters.phases = NULL;
+    }
+
+    struct ProcessStatistics statistics;
+    init_process_statistics(&statistics);
+
+    const struct ProcessGroup *groups = trace->groups;
+    int group_count = trace->group_count;
+
+    if (scheduler_to_use == &sjf_scheduler) {
+      groups = trace->sjf_groups;
+      group_count = trace->sjf_group_count;
+    }
+
+    if (groups != NULL && can_group(scheduler_to_use, &trace_parameters)) {
+      // The groups are added up as they're scheduled.
+      start_perf_stage(trace_parameters.counters);
+      grouped_scheduler(groups, group_count, scheduler_to_use,
+                        &trace_parameters, &statistics);
+      stop_perf_stage(trace_parameters.counters, PERF_STAGE_SCHEDULE);
+    } else {
+      // The scheduler writes its results into the table, so it gets a
+      // copy and the trace can be scheduled again.
+      struct ProcessEntry *entries = malloc(sizeof(struct ProcessEntry) *
+                                            trace->count);
+      assert(entries != NULL);
+
+      memcpy(entries, trace->entries, sizeof(struct ProcessEntry) *
+             trace->count);
+
+      // Run the scheduler.
+      start_perf_stage(trace_parameters.counters);
+
+      if (trace_parameters.timeline != NULL) {
+        start_timeline_run(trace_parameters.timeline);
+      }
+
+      split_scheduler(entries, trace->count, scheduler_to_use,
+                      &trace_parameters);
+
+      if (trace_parameters.timeline != NULL) {
+        flush_timeline(trace_parameters.timeline);
+      }
+
+      stop_perf_stage(trace_parameters.counters, PERF_STAGE_SCHEDULE);
+
+      start_perf_stage(trace_parameters.counters);
+      add_process_statistics(&statistics, entries, trace->count);
+      stop_perf_stage(trace_parameters.counters, PERF_STAGE_AGGREGATE);
+
+      free(entries);
+    }
+
+    start_perf_stage(trace_parameters.counters);
+    averages = averages_from_statistics(&statistics, &trace_parameters);
+    stop_perf_stage(trace_parameters.counters, PERF_STAGE_AGGREGATE);
+  }
+
+  return averages;
+}
+
+struct SchedulerAverages averages_from_statistics(
+    const struct ProcessStatistics *const restrict stats,
+    const struct SchedulerParameters *const restrict parameters) {
+  struct SchedulerAverages averages = {0.0,0.0};
+
+  if (stats->count > 0) {
+    averages.waiting_time = (double) stats->waiting.total / stats->count;
+    averages.turnaround_time =
+        (double) stats->turnaround.total / stats->count;
+
+    averages.min_turnaround_time = stats->turnaround.min;
+    averages.max_turnaround_time = stats->turnaround.max;
+    averages.turnaround_variance = time_variance(&stats->turnaround,
+                                                 stats->count);
+
+    averages.min_waiting_time = stats->waiting.min;
+    averages.max_waiting_time = stats->waiting.max;
+    averages.waiting_variance = time_variance(&stats->waiting, stats->count);
+
+    averages.context_switches = stats->context_switches;
+
+    const long long overhead_time =
+        stats->dispatches * parameters->dispatch_cost +
+        stats->context_switches * parameters->switch_cost;
+
+    averages.overhead_fraction =
+        (double) overhead_time / (overhead_time + stats->total_burst);
+  }
+
+  return averages;
+}
+
+int format_spread(char *const restrict buffer, const size_t size,
+                  const struct SchedulerAverages *const restrict averages) {
+  return snprintf(buffer, size,
+                  "Turnaround min=%lld max=%lld variance=%.2f. "
+                  "Waiting min=%lld max=%lld variance=%.2f\n",
+                  averages->min_turnaround_time,
+                  averages->max_turnaround_time,
+                  averages->turnaround_variance,
+                  averages->min_waiting_time,
+                  averages->max_waiting_time,
+                  averages->waiting_variance);
+}
+
+int format_overhead(char *const restrict buffer, const size_t size,
+                    const struct SchedulerAverages *const restrict averages) {
+  return snprintf(buffer, size,
+                  "Context switches=%lld. CPU lost to overhead=%.2f%%\n",
+                  averages->context_switches,
+                  averages->overhead_fraction * 100.0);
+}
+
+int format_prediction_gap(char *const restrict buffer, const size_t size,
+                          const struct SchedulerAverages *const restrict
+                          predicted,
+                          const struct SchedulerAverages *const restrict
+                          known) {
+  return snprintf(buffer, size,
+                  "Known bursts: Average waiting time=%.2f, %.2f less "
+                  "than predicted\n",
+                  known->waiting_time,
+                  predicted->waiting_time - known->waiting_time);
+}
+
+void init_trace_state(struct TraceState *const restrict state) {
+  state->filename = NULL;
+  state->offset = 0;
+  state->quantum = 0;
+  state->entries = NULL;
+  state->count = 0;
+  state->capacity = 0;
+  state->phases = NULL;
+  state->phase_count = 0;
+  state->phase_capacity = 0;
+  init_process_statistics(&state->statistics);
+  state->finish_time = 0;
+}
+
+void destroy_trace_state(struct TraceState *const restrict state) {
+  free(state->filename);
+  free(state->entries);
+  free(state->phases);
+
+  init_trace_state(state);
+}
+
+struct SchedulerAverages follow_scheduler(
+    struct TraceState *const restrict state,
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters) {
+
   struct SchedulerAverages averages = {0.0,0.0};
 
-  enum FileError error = read_file(filename, &process_list, &quantum);
+  if (state->filename == NULL || strcmp(state->filename, filename) != 0) {
+    reset_trace_state(state, filename);
+  }
+
+  struct LinkedList process_list;
+  init_list(&process_list);
+
+  enum FileError error = read_file_from(filename, &process_list,
+                                        &state->quantum, &state->offset);
+
+  if (error == FILE_ERR_TRUNCATED) {
+    // Not the file we were following any more, start over.
+    destroy_list(&process_list);
+    reset_trace_state(state, filename);
+    error = read_file_from(filename, &process_list,
+                           &state->quantum, &state->offset);
+  }
 
   if (error != FILE_ERR_NONE) {
     perror("main() - File Error");
+    destroy_list(&process_list);
+    reset_trace_state(state, filename);
   } else {
-    int list_count = process_list.count;
+    int new_count = process_list.count;
+
+    if (new_count > 0) {
+      struct ProcessEntry *new_entries = calloc(sizeof(struct ProcessEntry),
+                                                new_count);
+
+      assert(new_entries != NULL);
+
+      insertion_sort(&process_list, new_entries);
+
+      // Once a process does I/O the whole trace is scheduled with that
+      // in mind, including what came before it.
+      const bool first_phases = (state->phase_count == 0 &&
+                                 process_list.phase_count > 0);
+
+      add_trace_phases(state, &process_list, new_entries, new_count);
 
-    struct ProcessEntry *entries = calloc(sizeof(struct ProcessEntry),
-                                            list_count);
+      struct SchedulerParameters file_parameters = *parameters;
+      file_parameters.quantum = state->quantum;
 
-    assert(entries != NULL);
+      if (state->phase_count > 0) {
+        file_parameters.phases = state->phases;
+      } else {
+        file_parameters.phases = NULL;
+      }
 
-    selection_sort(&process_list, entries);
+      if (file_parameters.timeline != NULL) {
+        start_timeline_run(file_parameters.timeline);
+      }
+
+      add_to_trace_state(state, new_entries, new_count, first_phases,
+                         scheduler_to_use, &file_parameters);
+
+      if (file_parameters.timeline != NULL) {
+        flush_timeline(file_parameters.timeline);
+      }
+
+      free(new_entries);
+    }
 
     destroy_list(&process_list);
 
-    // Run the scheduler.
-    (*scheduler_to_use)(entries, list_count, quantum);
+    averages = averages_from_statistics(&state->statistics, parameters);
+  }
+
+  return averages;
+}
+
+/*
+ * reset_trace_state
+ *
+ * Throw away anything we know about the last trace, and get ready to
+ * read the given file from the start.
+ */
+static void reset_trace_state(struct TraceState *const restrict state,
+                              const char *const restrict filename) {
+  destroy_trace_state(state);
+
+  state->filename = strdup(filename);
+  assert(state->filename != NULL);
+}
+
+/*
+ * add_to_trace_state
+ *
+ * Takes newly read entries, sorted by arrival time, and adds them to
+ * the trace state's process table, updating the results.
+ *
+ * Once the CPU has gone idle after the last of the existing processes,
+ * nothing that arrives later can affect them. So if all the new
+ * entries arrive after that, only they need scheduling. Otherwise they
+ * get merged in, and everything has to be scheduled again.
+ *
+ * Unless reschedule is set, then everything is scheduled again
+ * regardless. Likewise when bursts are predicted, as the predictions
+ * carry on from the processes before.
+ *
+ * Either way, whatever gets scheduled goes in the timeline, so it has
+ * the whole trace when it's all rescheduled, and just the new
+ * processes otherwise.
+ */
+static void add_to_trace_state(
+    struct TraceState *const restrict state,
+    const struct ProcessEntry *const new_entries,
+    const int new_count,
+    const bool reschedule,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  int total = state->count + new_count;
 
-    int total_waiting_time = 0;
-    int total_turnaround_time = 0;
+  if (total > state->capacity) {
+    int new_capacity = (state->capacity > 0) ? state->capacity : 64;
 
-    for (int i = 0; i < list_count; i++) {
-      total_waiting_time += entries[i].waiting_time;
-      total_turnaround_time += entries[i].turnaround_time;
+    while (new_capacity < total) {
+      new_capacity *= 2;
     }
 
-    if (list_count > 0) {
-      averages.waiting_time = (double) total_waiting_time / list_count;
-      averages.turnaround_time = (double) total_turnaround_time / list_count;
+    state->entries = realloc(state->entries,
+                             sizeof(struct ProcessEntry) * new_capacity);
+    assert(state->entries != NULL);
+    state->capacity = new_capacity;
+  }
+
+  if (state->count == 0 ||
+      (!reschedule && parameters->prediction_weight == 0 &&
+       new_entries[0].arrival_time > state->finish_time)) {
+    // Everything new comes after the CPU has gone idle.
+    struct ProcessEntry *const tail = &state->entries[state->count];
+
+    memcpy(tail, new_entries, sizeof(struct ProcessEntry) * new_count);
+
+    if (parameters->timeline != NULL) {
+      parameters->timeline->first_process = state->count;
     }
 
-    free(entries);
+    split_scheduler(tail, new_count, scheduler_to_use, parameters);
+
+    total_trace_state(state, tail, new_count);
+  } else {
+    // Merge from the back, so the existing entries can stay where
+    // they are until they're moved. Existing entries go first when
+    // arrival times are equal, same as if the whole file was sorted.
+    int old_index = state->count - 1;
+    int new_index = new_count - 1;
+    int merged_index = total - 1;
+
+    while (new_index >= 0) {
+      if (old_index >= 0 &&
+          state->entries[old_index].arrival_time >
+          new_entries[new_index].arrival_time) {
+        state->entries[merged_index] = state->entries[old_index--];
+      } else {
+        state->entries[merged_index] = new_entries[new_index--];
+      }
+      --merged_index;
+    }
+
+    for (int i = 0; i < total; i++) {
+      reset_process_entry(&state->entries[i]);
+    }
+
+    split_scheduler(state->entries, total, scheduler_to_use, parameters);
+
+    init_process_statistics(&state->statistics);
+    state->finish_time = 0;
+
+    total_trace_state(state, state->entries, total);
   }
 
-  return averages;
+  state->count = total;
+}
+
+/*
+ * total_trace_state
+ *
+ * Adds the results of the given scheduled entries to the trace state
+ * statistics, and moves the finish time along if needed.
+ */
+static void total_trace_state(struct TraceState *const restrict state,
+                              const struct ProcessEntry *const entries,
+                              const int count) {
+  add_process_statistics(&state->statistics, entries, count);
+
+  for (int i = 0; i < count; i++) {
+    const long long completed = entries[i].arrival_time +
+        entries[i].turnaround_time;
+    if (completed > state->finish_time) {
+      state->finish_time = completed;
+    }
+  }
+}
+
+/*
+ * add_trace_phases
+ *
+ * Moves the phases of newly read processes over from their list to
+ * the end of the trace state's, so they don't go when the list does,
+ * and points the new entries at where they are now.
+ */
+static void add_trace_phases(struct TraceState *const restrict state,
+                             const struct LinkedList *const restrict
+                             process_list,
+                             struct ProcessEntry *const new_entries,
+                             const int new_count) {
+  if (process_list->phase_count > 0) {
+    const int needed = state->phase_count + process_list->phase_count;
+
+    if (needed > state->phase_capacity) {
+      int new_capacity = (state->phase_capacity > 0) ?
+          state->phase_capacity : 64;
+
+      while (new_capacity < needed) {
+        new_capacity *= 2;
+      }
+
+      state->phases = realloc(state->phases, sizeof(int) * new_capacity);
+      assert(state->phases != NULL);
+      state->phase_capacity = new_capacity;
+    }
+
+    memcpy(&state->phases[state->phase_count], process_list->phases,
+           sizeof(int) * process_list->phase_count);
+
+    for (int i = 0; i < new_count; i++) {
+      new_entries[i].first_phase += state->phase_count;
+    }
+
+    state->phase_count = needed;
+  }
+}
+
+/*
+ * load_counted_trace
+ *
+ * Does the work of load_trace, taking the file from the loader if
+ * it's been read ahead, counting reading it as the parse stage, and
+ * sorting and grouping it as the sort stage. The loader and counters
+ * can be NULL, for neither.
+ */
+static bool load_counted_trace(const char *const restrict filename,
+                               struct Trace *const restrict trace,
+                               struct TraceLoader *const loader,
+                               struct PerfCounters *const counters) {
+  struct LinkedList process_list;
+  const struct LoadedTrace *loaded;
+  enum FileError error;
+
+  start_perf_stage(counters);
+
+  // A file the loader couldn't read is read again here, for the error.
+  if (loader != NULL && find_loaded_trace(loader, filename, &loaded) &&
+      loaded->error == 0) {
+    error = read_buffer(loaded->data, loaded->size, &process_list,
+                        &trace->quantum);
+  } else {
+    error = read_file(filename, &process_list, &trace->quantum);
+  }
+
+  stop_perf_stage(counters, PERF_STAGE_PARSE);
+
+  if (error == FILE_ERR_NONE) {
+    start_perf_stage(counters);
+    trace->count = process_list.count;
+    trace->entries = NULL;
+
+    if (trace->count > 0) {
+      trace->entries = calloc(sizeof(struct ProcessEntry), trace->count);
+      assert(trace->entries != NULL);
+
+      insertion_sort(&process_list, trace->entries);
+    }
+
+    // The phases are the trace's now.
+    trace->phases = process_list.phases;
+    trace->phase_count = process_list.phase_count;
+    process_list.phases = NULL;
+
+    // Only worth keeping the groups if some processes share one.
+    trace->groups = NULL;
+    trace->group_count = 0;
+    trace->sjf_groups = NULL;
+    trace->sjf_group_count = 0;
+
+    if (trace->count > 0 && trace->phase_count == 0) {
+      trace->group_count = group_processes(trace->entries, trace->count,
+                                           &trace->groups);
+
+      if (trace->group_count == trace->count) {
+        free(trace->groups);
+        trace->groups = NULL;
+        trace->group_count = 0;
+      }
+
+      trace->sjf_group_count = group_arrivals(trace->entries, trace->count,
+                                              &trace->sjf_groups);
+
+      if (trace->sjf_group_count == trace->count) {
+        free(trace->sjf_groups);
+        trace->sjf_groups = NULL;
+        trace->sjf_group_count = 0;
+      }
+    }
+
+    destroy_list(&process_list);
+    stop_perf_stage(counters, PERF_STAGE_SORT);
+  }
+
+  return error == FILE_ERR_NONE;
 }
@@ -7,23 +7,241 @@
 #ifndef SCHEDULER_H_
 #define SCHEDULER_H_
 
+#include <stdbool.h>
+#include <stddef.h>
+
 #include "process_entry.h"
+#include "scheduler_parameters.h"
+#include "statistics.h"
 
 /*
  * This is our type so we can pass in the scheduler function. Any
  * schedulers we support must have this signature, even if they don't
- * support a quantum.
+ * use all of the parameters.
  */
-typedef void (*Scheduler)(struct ProcessEntry *const restrict process_table,
-                          const int num_entries,
-                          const int quantum);
+typedef void (*Scheduler)(
+    struct ProcessEntry *const restrict process_table,
+    const int num_entries,
+    const struct SchedulerParameters *const restrict parameters);
 
+/*
+ * SchedulerAverages
+ *
+ * Along with the averages, the spread of the times is kept. The
+ * variances are population variances.
+ */
 struct SchedulerAverages {
   double turnaround_time;
   double waiting_time;
+
+  long long min_turnaround_time;
+  long long max_turnaround_time;
+  double turnaround_variance;
+
+  long long min_waiting_time;
+  long long max_waiting_time;
+  double waiting_variance;
+
+  // Overheads, the fraction is of all the time the CPU was busy.
+  long long context_switches;
+  double overhead_fraction;
+};
+
+/*
+ * Run scheduler
+ *
+ * Loads the trace in the file, runs it through the scheduler and
+ * returns the averages. The quantum and phases in the parameters are
+ * ignored, the ones from the file are used. If the parameters ask for
+ * it, and the scheduler can, the trace is streamed instead.
+ */
+struct SchedulerAverages run_scheduler(
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * ProcessGroup
+ *
+ * count processes in a sorted trace, all with the same arrival and
+ * burst times. For round robin they're a run next to each other, for
+ * SJF they can be anywhere among the others arriving at that time.
+ */
+struct ProcessGroup {
+  int arrival_time;
+  int burst_time;
+  int count;
+};
+
+/*
+ * Trace
+ *
+ * A trace loaded from a file, with its processes sorted by arrival
+ * time and not yet scheduled. phases are the bursts of any processes
+ * that do I/O, NULL if there are none.
+ *
+ * If there's no I/O, and any process is the same as the one before
+ * it, the processes are also kept as group_count groups, so round
+ * robin can go through each group in one go. Otherwise groups is
+ * NULL. sjf_groups are the same for SJF, which doesn't need the same
+ * processes to be next to each other, only to arrive together.
+ */
+struct Trace {
+  struct ProcessEntry *entries;
+  int count;
+  int quantum;
+
+  int *phases;
+  int phase_count;
+
+  struct ProcessGroup *groups;
+  int group_count;
+
+  struct ProcessGroup *sjf_groups;
+  int sjf_group_count;
+};
+
+/*
+ * Load trace
+ *
+ * Reads the trace in the file, ready to be scheduled any number of
+ * times. Returns false, with errno set, if the file couldn't be read.
+ * Bad lines are skipped, with a warning, so a trace can have no
+ * processes at all.
+ */
+bool load_trace(const char *const restrict filename,
+                struct Trace *const restrict trace);
+
+/*
+ * Destroy trace
+ *
+ * Frees everything held by a loaded trace.
+ */
+void destroy_trace(struct Trace *const restrict trace);
+
+/*
+ * Schedule trace
+ *
+ * Runs a loaded trace through the scheduler and returns the averages,
+ * leaving the trace as it was. The quantum in the parameters is used,
+ * not the trace's, the phases are the trace's. A trace with no
+ * processes gives averages of zero.
+ */
+struct SchedulerAverages schedule_trace(
+    const struct Trace *const restrict trace,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * Averages from statistics
+ *
+ * Works out the averages and spreads from the statistics gathered
+ * over a scheduled process table. The parameters are needed to work
+ * out how much time went on overheads.
+ */
+struct SchedulerAverages averages_from_statistics(
+    const struct ProcessStatistics *const restrict stats,
+    const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * Format spread
+ *
+ * Writes the minimums, maximums and variances from the averages into
+ * the buffer as a line of text, for when the user wants to see more
+ * than just the averages. Won't write more than size characters,
+ * returns the length of the full line like snprintf does.
+ */
+int format_spread(char *const restrict buffer, const size_t size,
+                  const struct SchedulerAverages *const restrict averages);
+
+/*
+ * Format overhead
+ *
+ * Writes how many context switches there were and how much of the
+ * CPU's busy time went on dispatching and switching into the buffer
+ * as a line of text. Won't write more than size characters, returns
+ * the length of the full line like snprintf does.
+ */
+int format_overhead(char *const restrict buffer, const size_t size,
+                    const struct SchedulerAverages *const restrict averages);
+
+/*
+ * Format prediction gap
+ *
+ * Writes how long processes would have waited on average if their
+ * bursts were known, and how much less that is than with them
+ * predicted, into the buffer as a line of text. Won't write more than
+ * size characters, returns the length of the full line like snprintf
+ * does.
+ */
+int format_prediction_gap(char *const restrict buffer, const size_t size,
+                          const struct SchedulerAverages *const restrict
+                          predicted,
+                          const struct SchedulerAverages *const restrict
+                          known);
+
+/*
+ * TraceState
+ *
+ * Everything we remember about a trace between runs when following a
+ * file that is still growing. The process table is kept sorted with
+ * the results from the last run, along with how far into the file
+ * we've read, so the next run only has to deal with what's new.
+ *
+ * finish_time is when the last process in the table completed, any
+ * new process arriving after that can't change the results we
+ * already have. *
+ * phases are the bursts of processes with I/O, from everything read
+ * so far.
+ */
+struct TraceState {
+  char *filename;
+  long offset;
+  int quantum;
+
+  struct ProcessEntry *entries;
+  int count;
+  int capacity;
+
+  int *phases;
+  int phase_count;
+  int phase_capacity;
+
+  struct ProcessStatistics statistics;
+  long long finish_time;
 };
 
-struct SchedulerAverages run_scheduler(const char *const restrict filename,
-                                       const Scheduler scheduler_to_use);
+/*
+ * Init trace state
+ *
+ * Sets up an empty trace state, nothing has been read yet.
+ */
+void init_trace_state(struct TraceState *const restrict state);
+
+/*
+ * Destroy trace state
+ *
+ * Frees anything held by the trace state, leaving it empty.
+ */
+void destroy_trace_state(struct TraceState *const restrict state);
+
+/*
+ * Follow scheduler
+ *
+ * Like run_scheduler, but for traces that are being appended to. If
+ * the filename is the same as the last one given with this state,
+ * only records added to the file since then are read. When all of
+ * those arrive after the CPU finished with the existing processes,
+ * they're scheduled on their own and added to the totals, otherwise
+ * they're merged into the sorted table and the whole thing is run
+ * again.
+ *
+ * The state must only be used with the one scheduler and parameters.
+ */
+struct SchedulerAverages follow_scheduler(
+    struct TraceState *const restrict state,
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters);
 
 #endif
@@ -0,0 +1,101 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Everything a scheduler needs to know, other than the processes it
+ *   is scheduling.
+ */
+
+#ifndef SCHEDULER_PARAMETERS_H_
+#define SCHEDULER_PARAMETERS_H_
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "perf_counters.h"
+#include "timeline.h"
+#include "trace_loader.h"
+
+/*
+ * SchedulerParameters
+ *
+ * quantum - Longest a process can run for before the next gets a
+ *           turn, for schedulers that preempt. Comes from the trace.
+ *
+ * dispatch_cost - Time taken every time the scheduler gives a process
+ *                 the CPU, even if it's the one that just had it.
+ *
+ * switch_cost - Time taken to switch the CPU to a process that isn't
+ *               the one that was just running on it. Starting a
+ *               process on an idle CPU counts as a switch.
+ *
+ * Both costs are spent before the process starts running, and count
+ * towards its waiting time.
+ *
+ * aging_interval - For schedulers with priorities, how long a process
+ *                  waits before it gets one more important. 0 for no
+ *                  aging.
+ *
+ * seed - For randomised schedulers, the same seed always gives the
+ *        same schedule.
+ *
+ * timeline - Where to record each time a process has the CPU, NULL if
+ *            nobody wants to know. Schedulers can skip work they'd
+ *            otherwise do one turn at a time when it's NULL.
+ *
+ * phases - The CPU and I/O bursts of every process in the trace that
+ *          has more than one, each process knows where its own are.
+ *          Comes from the trace, NULL if no process does any I/O.
+ *          Schedulers that don't model I/O run a process's CPU bursts
+ *          back to back.
+ *
+ * split_threads - How many threads a big trace can be scheduled on at
+ *                 once, by cutting it where the CPU goes idle. The
+ *                 results are the same however many there are. 1 to
+ *                 always schedule on the calling thread.
+ *
+ * stream - Schedule traces as they're read, rather than loading them
+ *          first, for the schedulers that can. The results are the
+ *          same either way.
+ *
+ * sort_memory - Megabytes a streamed trace can be sorted in, if it
+ *               isn't sorted by arrival time already.
+ *
+ * prediction_weight - For SJF, the percent a burst counts for in the
+ *                     exponential average its next burst is predicted
+ *                     from, see burst_predictor.h. 0 to go on the
+ *                     bursts in the trace, as if they were known.
+ *
+ * prediction_guess - What bursts are predicted to be before any have
+ *                    finished.
+ *
+ * counters - Where to count each stage of loading and scheduling a
+ *            trace, NULL if nobody wants to know. Only run_scheduler
+ *            counts, and it always loads the trace too, so the stages
+ *            are separate.
+ *
+ * loader - Where a batch of traces is being read ahead, NULL to read
+ *          each from its file as it's loaded. Traces that aren't in
+ *          the batch, or couldn't be read ahead, are read from their
+ *          files as usual.
+ */
+struct SchedulerParameters {
+  int quantum;
+  int dispatch_cost;
+  int switch_cost;
+  int aging_interval;
+  uint64_t seed;
+  struct Timeline *timeline;
+  const int *phases;
+  int split_threads;
+  bool stream;
+  int sort_memory;
+  int prediction_weight;
+  int prediction_guess;
+  struct PerfCounters *counters;
+  struct TraceLoader *loader;
+};
+
+#endif
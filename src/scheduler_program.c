@@ -0,0 +1,192 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "monte_carlo.h"
+#include "options.h"
+#include "perf_counters.h"
+#include "result_cache.h"
+#include "scheduler_program.h"
+#include "sjf_scheduler.h"
+#include "timeline.h"
+#include "trace_loader.h"
+#include "user_input.h"
+
+int scheduler_program(int argc, char *argv[],
+                      const Scheduler scheduler_to_use,
+                      const char *const restrict scheduler_name,
+                      const char *const restrict prompt) {
+  struct Options options;
+
+  if (!parse_options(argc, argv, &options)) {
+    return EXIT_FAILURE;
+  }
+
+  FILE *timeline_file = NULL;
+  struct Timeline timeline;
+
+  if (options.timeline_filename != NULL) {
+    timeline_file = open_timeline_file(options.timeline_filename);
+
+    if (timeline_file == NULL) {
+      perror("main() - Timeline File Error");
+      return EXIT_FAILURE;
+    }
+
+    init_timeline(&timeline, timeline_file, scheduler_name);
+    options.parameters.timeline = &timeline;
+  }
+
+  // Follow mode doesn't go through the counted stages.
+  struct PerfCounters counters;
+
+  if (options.count_stages && !options.follow) {
+    open_perf_counters(&counters);
+    options.parameters.counters = &counters;
+  }
+
+  // Followed and streamed traces are only ever wanted a part at a
+  // time, so they aren't read ahead.
+  struct TraceLoader loader;
+
+  if (!options.follow && !options.parameters.stream) {
+    init_trace_loader(&loader);
+    options.parameters.loader = &loader;
+  }
+
+  struct TraceState trace_state;
+  init_trace_state(&trace_state);
+
+  struct ResultCache result_cache;
+  init_result_cache(&result_cache, options.cache_filename);
+
+  struct UserInput input;
+  init_user_input(&input, STDIN_FILENO);
+
+  printf("%s", prompt);
+  fflush(stdout);
+
+  const char *entered = next_filename(&input);
+
+  while (entered != NULL) {
+    const char *batch[TRACE_LOADER_BATCH_SIZE];
+    int total_filenames = 0;
+
+    // Take everything that's already there, so it can all be read
+    // ahead while the first is scheduled.
+    do {
+      batch[total_filenames++] = entered;
+      entered = NULL;
+
+      if (total_filenames < TRACE_LOADER_BATCH_SIZE &&
+          filename_waiting(&input)) {
+        entered = next_filename(&input);
+      }
+    } while (entered != NULL);
+
+    if (options.parameters.loader != NULL) {
+      load_traces(&loader, batch, total_filenames);
+    }
+
+    for (int file = 0; file < total_filenames; ++file) {
+      const char *const filename = batch[file];
+      struct SchedulerAverages averages;
+
+      if (options.follow) {
+        averages = follow_scheduler(&trace_state, filename,
+                                    scheduler_to_use, &options.parameters);
+      } else {
+        averages = cached_run_scheduler(&result_cache, filename,
+                                        scheduler_to_use, scheduler_name,
+                                        &options.parameters);
+      }
+
+      printf("Average turnaround time=%.2f."
+             "Average waiting time=%.2f\n",
+             averages.turnaround_time, averages.waiting_time);
+
+      if (options.spread) {
+        // Sized from the line itself, so big times are never cut off.
+        char spread[format_spread(NULL, 0, &averages) + 1];
+        format_spread(spread, sizeof(spread), &averages);
+        printf("%s", spread);
+      }
+
+      if (options.parameters.dispatch_cost != 0 ||
+          options.parameters.switch_cost != 0) {
+        char overhead[format_overhead(NULL, 0, &averages) + 1];
+        format_overhead(overhead, sizeof(overhead), &averages);
+        printf("%s", overhead);
+      }
+
+      if (options.parameters.counters != NULL) {
+        char report[PERF_REPORT_SIZE];
+        format_perf_counters(report, PERF_REPORT_SIZE, &counters);
+        printf("%s", report);
+      }
+
+      // Only SJF predicts bursts.
+      if (options.parameters.prediction_weight > 0 &&
+          scheduler_to_use == &sjf_scheduler) {
+        struct SchedulerParameters known_parameters = options.parameters;
+        known_parameters.prediction_weight = 0;
+        known_parameters.timeline = NULL;
+        known_parameters.counters = NULL;
+
+        const struct SchedulerAverages known =
+            cached_run_scheduler(&result_cache, filename,
+                                 scheduler_to_use, scheduler_name,
+                                 &known_parameters);
+
+        char gap[format_prediction_gap(NULL, 0, &averages, &known) + 1];
+        format_prediction_gap(gap, sizeof(gap), &averages, &known);
+        printf("%s", gap);
+      }
+
+      if (options.what_if.replicas > 0) {
+        const struct WhatIfResult result =
+            run_what_if(filename, scheduler_to_use,
+                        &options.parameters, &options.what_if,
+                        what_if_threads(1));
+
+        char what_if[format_what_if(NULL, 0, &result) + 1];
+        format_what_if(what_if, sizeof(what_if), &result);
+        printf("%s", what_if);
+      }
+
+      printf("%s", prompt);
+
+      // Nothing else to do, show the results before waiting for more.
+      if (file == total_filenames - 1 && !filename_waiting(&input)) {
+        fflush(stdout);
+      }
+    }
+
+    entered = next_filename(&input);
+  }
+
+  destroy_user_input(&input);
+  destroy_result_cache(&result_cache);
+  destroy_trace_state(&trace_state);
+
+  if (options.parameters.loader != NULL) {
+    destroy_trace_loader(&loader);
+  }
+
+  if (options.parameters.counters != NULL) {
+    close_perf_counters(&counters);
+  }
+
+  if (timeline_file != NULL) {
+    destroy_timeline(&timeline);
+    fclose(timeline_file);
+  }
+
+  return EXIT_SUCCESS;
+}
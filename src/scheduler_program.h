@@ -0,0 +1,34 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Everything the single scheduler programs have in common, they
+ *   only differ in which scheduler they run.
+ */
+
+#ifndef SCHEDULER_PROGRAM_H_
+#define SCHEDULER_PROGRAM_H_
+
+#include "scheduler.h"
+
+/*
+ * Scheduler program
+ *
+ * The whole of a single scheduler program. Takes the arguments given
+ * to main, then keeps asking the user for traces, running each
+ * through the scheduler and printing the results, until they quit.
+ *
+ * scheduler_name - Identifies the scheduler in the result cache and
+ *                  the timeline.
+ * prompt - Printed before asking for each trace.
+ *
+ * Returns what main should return.
+ */
+int scheduler_program(int argc, char *argv[],
+                      const Scheduler scheduler_to_use,
+                      const char *const restrict scheduler_name,
+                      const char *const restrict prompt);
+
+#endif
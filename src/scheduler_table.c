@@ -0,0 +1,38 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+// For strcasecmp.
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdbool.h>
+#include <strings.h>
+
+#include "lottery_scheduler.h"
+#include "priority_scheduler.h"
+#include "rr_scheduler.h"
+#include "scheduler_table.h"
+#include "sjf_scheduler.h"
+#include "stride_scheduler.h"
+
+const struct NamedScheduler SCHEDULERS[NUM_SCHEDULERS] = {
+  { sjf_scheduler, "SJF" },
+  { rr_scheduler, "RR" },
+  { priority_scheduler, "PRIO" },
+  { stride_scheduler, "STRIDE" },
+  { lottery_scheduler, "LOTTERY" }
+};
+
+int find_scheduler(const char *const restrict name) {
+  int result = -1;
+
+  for (int i = 0; i < NUM_SCHEDULERS && result < 0; i++) {
+    if (strcasecmp(SCHEDULERS[i].name, name) == 0) {
+      result = i;
+    }
+  }
+
+  return result;
+}
@@ -0,0 +1,44 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Every scheduler we have, along with the name it's shown with.
+ */
+
+#ifndef SCHEDULER_TABLE_H_
+#define SCHEDULER_TABLE_H_
+
+#include "scheduler.h"
+
+/*
+ * How many schedulers there are.
+ */
+#define NUM_SCHEDULERS 5
+
+/*
+ * NamedScheduler
+ *
+ * A scheduler and the string for displaying its type, which is also
+ * what identifies it in the result cache.
+ */
+struct NamedScheduler {
+  Scheduler scheduler;
+  const char *name;
+};
+
+/*
+ * All of the schedulers, in the order the simulator shows them.
+ */
+extern const struct NamedScheduler SCHEDULERS[NUM_SCHEDULERS];
+
+/*
+ * Find scheduler
+ *
+ * Returns the index in SCHEDULERS of the scheduler with the given
+ * name, ignoring case, or -1 if there isn't one.
+ */
+int find_scheduler(const char *const restrict name);
+
+#endif
@@ -6,165 +6,160 @@
  * Section three of the assignment.
  */
 
-#include <pthread.h>
+#include <assert.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <unistd.h>
 
+#include "monte_carlo.h"
+#include "options.h"
 #include "scheduler.h"
 #include "thread.h"
+#include "timeline.h"
+#include "trace_loader.h"
 #include "user_input.h"
+#include "worker_pool.h"
 
-// Forward declarations.
-static void init_data(struct SharedData *const restrict data,
-                      const size_t buf_size);
-
-static void wait_for_schedulers(struct SharedData *const restrict shared_data);
+// Forward decs
+static void print_fused(const struct SharedData *const restrict shared_data,
+                        const int file);
 
 /*
  * Main
  *
  * Will start up NUM_THREADS of threads running in background for
- * schedulers. When given input from the user, informs the threads and
- * outputs the result from the thread when its finished.
+ * schedulers. When given input from the user, runs a batch on the
+ * threads with every filename that's come in so far, and outputs
+ * their results, by file then in thread order, once they've all
+ * finished. The fused results are shown in place of the leader's.
+ * Stops when the input ends or the user enters QUIT.
  */
-int main(void) {
-  pthread_t sched_threads[NUM_THREADS];
-  const int BUFFER_SIZE = 100;
+int main(int argc, char *argv[]) {
   struct SharedData shared_data;
 
-  init_data(&shared_data, BUFFER_SIZE);
+  if (!parse_options(argc, argv, &shared_data.options)) {
+    return EXIT_FAILURE;
+  }
 
-  // Stop the child threads from going past the input stage.
-  pthread_mutex_lock(&shared_data.input_mutex);
+  shared_data.timeline_file = NULL;
 
-  for (int i = 0; i < NUM_THREADS; ++i) {
-    pthread_create(&sched_threads[i], NULL, &run_sched_thread, &shared_data);
-  }
+  if (shared_data.options.timeline_filename != NULL) {
+    shared_data.timeline_file =
+        open_timeline_file(shared_data.options.timeline_filename);
 
-  // Wait for all the children to be created.
-  wait_for_schedulers(&shared_data);
+    if (shared_data.timeline_file == NULL) {
+      perror("main() - Timeline File Error");
+      return EXIT_FAILURE;
+    }
+  }
 
-  printf("Simulation: ");
+  init_result_cache(&shared_data.result_cache,
+                    shared_data.options.cache_filename);
+  init_fused(&shared_data);
 
-  while (file_from_user(shared_data.input_buffer, BUFFER_SIZE)) {
-    shared_data.input_ready = true;
+  // Set before the threads copy the parameters.
+  if (!shared_data.options.follow && !shared_data.options.parameters.stream) {
+    init_trace_loader(&shared_data.loader);
+    shared_data.options.parameters.loader = &shared_data.loader;
+  }
 
-    pthread_cond_broadcast(&shared_data.input_cond);
+  struct UserInput input;
+  init_user_input(&input, STDIN_FILENO);
 
-    // Stop the children racing ahead and putting something in the
-    // output buffer before we're ready.
-    pthread_mutex_lock(&shared_data.output_mutex);
-    pthread_mutex_unlock(&shared_data.input_mutex);
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    shared_data.threads[i] = NULL;
+  }
 
-    // Wait for all the children to have read the input buffer.
-    wait_for_schedulers(&shared_data);
+  struct WorkerPool pool;
+  init_worker_pool(&pool, NUM_THREADS, &run_sched_thread, &shared_data);
 
-    pthread_mutex_lock(&shared_data.input_mutex);
-    shared_data.input_ready = false;
-    pthread_mutex_unlock(&shared_data.input_mutex);
-    pthread_mutex_unlock(&shared_data.output_mutex);
+  if (shared_data.options.pin && !pin_worker_pool(&pool)) {
+    fprintf(stderr, "Couldn't pin the scheduler threads to CPUs.\n");
+  }
 
-    // Children can now start processing, so check if we have any
-    // output from them.
-    pthread_mutex_lock(&shared_data.scheduler_ready_mutex);
+  printf("Simulation: ");
+  fflush(stdout);
 
-    while (shared_data.schedulers_ready != NUM_THREADS) {
-      pthread_mutex_lock(&shared_data.output_mutex);
+  const char *filename = next_filename(&input);
 
-      while (!shared_data.output_ready) {
-        pthread_cond_wait(&shared_data.output_cond,
-                          &shared_data.output_mutex);
-      }
+  while (filename != NULL) {
+    shared_data.total_filenames = 0;
 
-      // Something is in the output buffer.
-      printf("%s", shared_data.output_buffer);
+    // Take everything that's already there, then run it all at once.
+    do {
+      shared_data.filenames[shared_data.total_filenames++] = filename;
+      filename = NULL;
 
-      shared_data.schedulers_ready++;
-      shared_data.output_ready = false;
+      if (shared_data.total_filenames < INPUT_BATCH_SIZE &&
+          filename_waiting(&input)) {
+        filename = next_filename(&input);
+      }
+    } while (filename != NULL);
 
-      // Signal that the output buffer is ready to any other threads
-      // waiting.
-      pthread_cond_signal(&shared_data.output_cond);
-      pthread_mutex_unlock(&shared_data.output_mutex);
+    if (shared_data.options.parameters.loader != NULL) {
+      load_traces(&shared_data.loader, shared_data.filenames,
+                  shared_data.total_filenames);
     }
 
-    /*
-     * Before we get back to the input loop, we need to clear off.
-     */
-    shared_data.schedulers_ready = 0;
-    pthread_mutex_unlock(&shared_data.scheduler_ready_mutex);
-
-    /*
-     * At this stage, all the scheduler threads have given us their
-     * output. They could be locked, waiting on some input, or they
-     * might not have got there yet, we just have to grab the input
-     * mutex.
-     */
-    pthread_mutex_lock(&shared_data.input_mutex);
-
-    printf("Simulation: ");
-  }
-
-  shared_data.quit = true;
-  pthread_cond_broadcast(&shared_data.input_cond);
-  pthread_mutex_unlock(&shared_data.input_mutex);
+    run_batch(&pool);
 
-  pthread_exit(0);
+    for (int file = 0; file < shared_data.total_filenames; ++file) {
+      for (int i = 0; i < NUM_THREADS; ++i) {
+        if (i == shared_data.fused_leader) {
+          print_fused(&shared_data, file);
+        } else if (!is_fused(&shared_data, i)) {
+          printf("%s", shared_data.threads[i]->output_buffers[file]);
+        }
+      }
 
-  free(shared_data.input_buffer);
-  free(shared_data.output_buffer);
+      printf("Simulation: ");
+    }
 
-  return EXIT_SUCCESS;
-}
+    fflush(stdout);
+    filename = next_filename(&input);
+  }
 
-/*
- * init_data
- *
- * Takes the shared data structure that has our mutexes, etc and sets
- * them to default values. Also allocates input and output buffers.
- *
- * data - shared data struct to init.
- * buf_size - Size for each of input and output buffers.
- */
-static void init_data(struct SharedData *const restrict data,
-                      const size_t buf_size) {
+  destroy_worker_pool(&pool);
 
-  pthread_mutex_init(&data->input_mutex, NULL);
-  pthread_cond_init(&data->input_cond, NULL);
-  data->input_ready = false;
-  data->quit = false;
+  for (int i = 0; i < NUM_THREADS; ++i) {
+    destroy_sched_thread(&shared_data, i);
+  }
 
-  pthread_mutex_init(&data->scheduler_ready_mutex, NULL);
-  pthread_cond_init(&data->scheduler_ready_cond, NULL);
-  data->schedulers_ready = 0;
+  if (shared_data.options.parameters.loader != NULL) {
+    destroy_trace_loader(&shared_data.loader);
+  }
 
-  pthread_mutex_init(&data->output_mutex, NULL);
-  pthread_cond_init(&data->output_cond, NULL);
+  destroy_result_cache(&shared_data.result_cache);
+  destroy_user_input(&input);
 
-  data->output_ready = false;
+  if (shared_data.timeline_file != NULL) {
+    fclose(shared_data.timeline_file);
+  }
 
-  data->input_buffer = calloc(1,buf_size);
-  data->output_buffer = calloc(1,buf_size);
+  return EXIT_SUCCESS;
 }
 
 /*
- * wait_for_schedulers
+ * print_fused
  *
- * When this is called, the thread will wait until the children
- * threads signal they're ready. We're just watching an int value to
- * hit NUM_THREADS.
+ * Shows the results of every fused policy for the file, in order.
  */
-static void wait_for_schedulers(struct SharedData *const restrict shared_data) {
-  // Need to wait here until we know that the threads are up and running.
-  // So we will block here until they're ready.
-  pthread_mutex_lock(&shared_data->scheduler_ready_mutex);
-
-  while (shared_data->schedulers_ready != NUM_THREADS ) {
-    pthread_cond_wait(&shared_data->scheduler_ready_cond,
-                      &shared_data->scheduler_ready_mutex);
+static void print_fused(const struct SharedData *const restrict shared_data,
+                        const int file) {
+  char buffer[OUTPUT_BUFFER_SIZE];
+
+  for (int i = 0; i < shared_data->fused_count; ++i) {
+    format_results(buffer, OUTPUT_BUFFER_SIZE, shared_data->fused_names[i],
+                   &shared_data->fused_averages[file][i],
+                   shared_data->options.spread,
+                   &shared_data->options.parameters);
+    printf("%s", buffer);
+
+    if (shared_data->options.what_if.replicas > 0) {
+      format_what_if(buffer, OUTPUT_BUFFER_SIZE,
+                     &shared_data->fused_what_if[file][i]);
+      printf("%s", buffer);
+    }
   }
-
-  shared_data->schedulers_ready = 0;
-  pthread_mutex_unlock(&shared_data->scheduler_ready_mutex);
 }
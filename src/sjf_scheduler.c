@@ -8,48 +8,74 @@
 #include <stdbool.h>
 #include <stddef.h>
 
+#include "io_scheduler.h"
 #include "sjf_scheduler.h"
 
 // Forward defines.
 static int sjf_next_process(
     const struct ProcessEntry *const restrict process_table,
     const int number_of_processes,
-    const int cpu_time);
+    const long long cpu_time);
 
 /*
  * SJF Scheduler
  *
- * The quantum parameter is not intended to be used, it's only so the
- * function signature matches.
+ * Doesn't preempt, so the quantum in the parameters isn't used. Every
+ * process is only given the CPU once, and never straight after
+ * itself, so each one costs a dispatch and a switch.
+ *
+ * If processes do I/O they come back for more of the CPU, so the
+ * table alone can't say what's waiting, that's left to io_scheduler.
+ * So are predicted bursts, which need a ready queue keyed on the
+ * prediction made when each process joined it.
  */
 void sjf_scheduler(struct ProcessEntry *const restrict process_table,
                    const int total_processes,
-                   const int quantum) {
+                   const struct SchedulerParameters *const restrict parameters) {
 
   assert(process_table != NULL);
-  int cpu_time = process_table[0].arrival_time;
-  int processes_remaining = total_processes;
-
-  while (processes_remaining > 0) {
-    int next_process = sjf_next_process(process_table,
+  if (parameters->phases != NULL || parameters->prediction_weight > 0) {
+    io_scheduler(process_table, total_processes, parameters,
+                 IO_POLICY_SJF);
+  } else {
+    long long cpu_time = process_table[0].arrival_time;
+    int processes_remaining = total_processes;
+
+    while (processes_remaining > 0) {
+      int next_process = sjf_next_process(process_table,
+                                          total_processes,
+                                          cpu_time);
+
+      // Skip any time not spent processing. Anything else arriving at
+      // the same time is now a candidate too, so look again.
+      if (process_table[next_process].arrival_time > cpu_time) {
+        cpu_time = process_table[next_process].arrival_time;
+        next_process = sjf_next_process(process_table,
                                         total_processes,
                                         cpu_time);
+      }
 
-    // Skip any time not spent processing.
-    if (process_table[next_process].arrival_time > cpu_time) {
-      cpu_time = process_table[next_process].arrival_time;
-    }
+      cpu_time += parameters->dispatch_cost + parameters->switch_cost;
+      process_table[next_process].dispatch_count = 1;
+      process_table[next_process].switch_count = 1;
 
-    cpu_time += process_table[next_process].burst_time_remaining;
+      cpu_time += process_table[next_process].burst_time_remaining;
 
-    process_table[next_process].burst_time_remaining = 0;
+      if (parameters->timeline != NULL) {
+        add_timeline_slice(parameters->timeline, next_process,
+                           cpu_time - process_table[next_process].burst_time,
+                           cpu_time);
+      }
 
-    process_table[next_process].turnaround_time = cpu_time -
-        process_table[next_process].arrival_time;
-    process_table[next_process].waiting_time =
-        process_table[next_process].turnaround_time -
-        process_table[next_process].burst_time;
-    --processes_remaining;
+      process_table[next_process].burst_time_remaining = 0;
+
+      process_table[next_process].turnaround_time = cpu_time -
+          process_table[next_process].arrival_time;
+      process_table[next_process].waiting_time =
+          process_table[next_process].turnaround_time -
+          process_table[next_process].burst_time;
+      --processes_remaining;
+    }
   }
 }
 
@@ -62,7 +88,7 @@ void sjf_scheduler(struct ProcessEntry *const restrict process_table,
 static int sjf_next_process(
     const struct ProcessEntry *const restrict process_table,
     const int number_of_processes,
-    const int cpu_time) {
+    const long long cpu_time) {
 
   int next_process = 0;
 
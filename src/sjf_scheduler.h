@@ -11,6 +11,7 @@
 #define SJF_SCHEDULER_H_
 
 #include "process_entry.h"
+#include "scheduler_parameters.h"
 
 /*
  * SJF Scheduler
@@ -19,6 +20,9 @@
  * non-preemptive SJF scheduler on it, (hence the function name, funny
  * that).
  *
+ * With a prediction weight in the parameters, it goes on a prediction
+ * of each burst from the ones before it instead of the burst itself.
+ *
  * The array being passed in is expected to be sorted.
  *
  * When the scheduler is run, it will update the process entries with
@@ -26,6 +30,6 @@
  */
 void sjf_scheduler(struct ProcessEntry *const restrict process_table,
                    const int total_processes,
-                   const int quantum);
+                   const struct SchedulerParameters *const restrict parameters);
 
 #endif
@@ -11,51 +11,39 @@
 #include "sorting.h"
 
 /*
- * selection_sort
+ * insertion_sort
  *
- * Takes a list and will return a sorted process_table. Items are
- * removed from the list as they are added to the process table.
+ * Walks the list once with its own iterator, inserting each entry
+ * into place in the process table. Entries with equal arrival times
+ * keep their list order. Since the list is only read, several threads
+ * can call this on the same list at once.
  */
-void selection_sort(struct LinkedList *const list,
-              struct ProcessEntry *const process_table) {
+void insertion_sort(const struct LinkedList *const list,
+                    struct ProcessEntry *const process_table) {
 
   assert(list != NULL);
   assert(process_table != NULL);
 
-  int current_index = 0;
+  int sorted_entries = 0;
 
-  // We always expect at least one entry in the list.
-  assert(list->head);
+  struct LinkedListIterator iterator;
+  init_list_iterator(list, &iterator);
 
-  // Save the original list count, removing elements updates it.
-  int num_of_entries = list->count;
+  while (has_value(&iterator)) {
+    const struct ProcessEntry *const entry = node_value(&iterator);
 
-  while (current_index < num_of_entries) {
-
-    assert(list->head);
-
-    // Start with our min.
-    reset_list_iterator(list);
-    const struct LinkedListNode *smallest_entry_node = list->current_node;
-    next_list_item(list);
-
-    // Loop through looking for anything smaller.
-    while(has_value(list)) {
-      if (list->current_node->process.arrival_time <
-          smallest_entry_node->process.arrival_time) {
-        smallest_entry_node = list->current_node;
-      }
-      next_list_item(list);
+    // Shuffle up anything that arrives later, traces are usually
+    // close to sorted so this doesn't go far.
+    int index = sorted_entries;
+    while (index > 0 &&
+           process_table[index - 1].arrival_time > entry->arrival_time) {
+      process_table[index] = process_table[index - 1];
+      --index;
     }
 
-    init_process_entry(&process_table[current_index],
-                       smallest_entry_node->process.arrival_time,
-                       smallest_entry_node->process.burst_time);
-
-    // This will free the memory held by the node, that definitely
-    // breaks const.
-    remove_from_list(list, (struct LinkedListNode *)smallest_entry_node);
+    process_table[index] = *entry;
 
-    ++current_index;
+    ++sorted_entries;
+    next_list_item(&iterator);
   }
 }
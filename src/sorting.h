@@ -15,17 +15,20 @@
 #include "process_entry.h"
 
 /*
- * Selection sort
+ * Insertion sort
  *
  * Takes a pointer to a list which contains the arrival and burst
  * times as read from a file. Will update the given process table so
- * it contains the process entries sorted in order of arrival time.
- * This is destructive to the list passed in.
+ * it contains the process entries sorted in order of arrival time,
+ * those that arrive together in the order they were read. The list is
+ * left untouched, so a loaded list can be shared between threads and
+ * each can build its own process table from it.
  *
  * list - Pointer to list with items loaded.
- * process_table - Pointer to allocated array of process entries.
+ * process_table - Pointer to allocated array of process entries, must
+ *                 be able to hold list->count entries.
  */
-void selection_sort(struct LinkedList *const list,
+void insertion_sort(const struct LinkedList *const list,
                     struct ProcessEntry *const process_table);
 
 #endif
@@ -0,0 +1,198 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Once the CPU has gone idle, nothing that arrives after can change
+ * the results of what came before, and every scheduler starts the
+ * next busy period the same however it got there. That's what
+ * follow_scheduler relies on to only schedule new processes, here
+ * it's used to schedule the busy periods of one trace in parallel.
+ *
+ * Where the CPU goes idle depends on the schedule, with costs it's
+ * later than the bursts alone say, and with I/O a process can finish
+ * long after its CPU bursts. So the cuts are guesses, each piece is
+ * checked once it has been scheduled, and any that ran into the next
+ * is scheduled again along with it.
+ *
+ * Predicted bursts are the exception, the predictions for the next
+ * busy period come from the ones before it, so those traces are never
+ * cut.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdlib.h>
+
+#include "split_scheduler.h"
+#include "worker_pool.h"
+
+/*
+ * SplitRun
+ *
+ * The table being scheduled, cut into total_pieces pieces. Piece i is
+ * the processes from starts[i] up to starts[i + 1], and gets worker i.
+ */
+struct SplitRun {
+  struct ProcessEntry *process_table;
+  Scheduler scheduler;
+  const struct SchedulerParameters *parameters;
+
+  int starts[SPLIT_MAX_THREADS + 1];
+  int total_pieces;
+};
+
+// Forward decs
+static int cut_table(struct SplitRun *const restrict run,
+                     const int total_processes,
+                     const int wanted_pieces);
+static void schedule_piece(void *run_in, const int worker);
+static long long finish_time(const struct ProcessEntry *const restrict
+                             entries,
+                             const int count);
+
+void split_scheduler(struct ProcessEntry *const restrict process_table,
+                     const int total_processes,
+                     const Scheduler scheduler_to_use,
+                     const struct SchedulerParameters *const restrict
+                     parameters) {
+  int wanted_pieces = total_processes / SPLIT_MIN_PROCESSES;
+
+  if (wanted_pieces > parameters->split_threads) {
+    wanted_pieces = parameters->split_threads;
+  }
+
+  if (wanted_pieces > SPLIT_MAX_THREADS) {
+    wanted_pieces = SPLIT_MAX_THREADS;
+  }
+
+  struct SplitRun run;
+  run.process_table = process_table;
+  run.scheduler = scheduler_to_use;
+  run.parameters = parameters;
+  run.total_pieces = 1;
+
+  if (wanted_pieces > 1 && parameters->timeline == NULL &&
+      parameters->prediction_weight == 0) {
+    run.total_pieces = cut_table(&run, total_processes, wanted_pieces);
+  }
+
+  if (run.total_pieces == 1) {
+    (*scheduler_to_use)(process_table, total_processes, parameters);
+  } else {
+    struct WorkerPool pool;
+    init_worker_pool(&pool, run.total_pieces, &schedule_piece, &run);
+    run_batch(&pool);
+    destroy_worker_pool(&pool);
+
+    // Check each piece finished before the next started, if not they
+    // have to be scheduled together.
+    int first = 0;
+
+    for (int piece = 1; piece < run.total_pieces; piece++) {
+      const int next = run.starts[piece];
+      const int end = run.starts[piece + 1];
+
+      if (finish_time(&process_table[first], next - first) <
+          process_table[next].arrival_time) {
+        first = next;
+      } else {
+        for (int i = first; i < end; i++) {
+          reset_process_entry(&process_table[i]);
+        }
+
+        (*scheduler_to_use)(&process_table[first], end - first, parameters);
+      }
+    }
+  }
+}
+
+/*
+ * cut_table
+ *
+ * Finds where to cut the table into about wanted_pieces pieces of the
+ * same size, only cutting before a process that arrives after the
+ * ones before it could possibly have finished. Fills in the starts,
+ * returns how many pieces there are, 1 if there's nowhere to cut.
+ */
+static int cut_table(struct SplitRun *const restrict run,
+                     const int total_processes,
+                     const int wanted_pieces) {
+  const struct ProcessEntry *const process_table = run->process_table;
+
+  // Soonest the CPU could have done all the bursts so far, and soonest
+  // all of them could be finished, counting their I/O.
+  long long cpu_done = process_table[0].arrival_time;
+  long long all_done = cpu_done;
+
+  int total_pieces = 1;
+  run->starts[0] = 0;
+
+  for (int i = 0; i < total_processes; i++) {
+    const struct ProcessEntry *const process = &process_table[i];
+
+    if (i >= (long long) total_pieces * total_processes / wanted_pieces &&
+        total_pieces < wanted_pieces &&
+        process->arrival_time > all_done) {
+      run->starts[total_pieces++] = i;
+    }
+
+    if (process->arrival_time > cpu_done) {
+      cpu_done = process->arrival_time;
+    }
+
+    cpu_done += process->burst_time;
+
+    const long long done = (long long) process->arrival_time +
+        process->burst_time + process->io_time;
+
+    if (cpu_done > all_done) {
+      all_done = cpu_done;
+    }
+
+    if (done > all_done) {
+      all_done = done;
+    }
+  }
+
+  run->starts[total_pieces] = total_processes;
+
+  return total_pieces;
+}
+
+/*
+ * schedule_piece
+ *
+ * The worker function, schedules the worker's own piece.
+ */
+static void schedule_piece(void *run_in, const int worker) {
+  const struct SplitRun *const run = run_in;
+  const int start = run->starts[worker];
+
+  assert(worker < run->total_pieces);
+
+  (*run->scheduler)(&run->process_table[start],
+                    run->starts[worker + 1] - start, run->parameters);
+}
+
+/*
+ * finish_time
+ *
+ * When the last of the scheduled entries completed.
+ */
+static long long finish_time(const struct ProcessEntry *const restrict
+                             entries,
+                             const int count) {
+  long long result = 0;
+
+  for (int i = 0; i < count; i++) {
+    const long long completed = (long long) entries[i].arrival_time +
+        entries[i].turnaround_time;
+
+    if (completed > result) {
+      result = completed;
+    }
+  }
+
+  return result;
+}
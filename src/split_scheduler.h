@@ -0,0 +1,47 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Schedules a big trace on several threads at once, by cutting it
+ *   where the CPU goes idle.
+ */
+
+#ifndef SPLIT_SCHEDULER_H_
+#define SPLIT_SCHEDULER_H_
+
+#include "process_entry.h"
+#include "scheduler.h"
+#include "scheduler_parameters.h"
+
+/*
+ * Fewest processes worth giving a thread of their own, smaller traces
+ * are quicker to schedule than to hand out.
+ */
+#define SPLIT_MIN_PROCESSES 4096
+
+/*
+ * Most threads a trace can be split over.
+ */
+#define SPLIT_MAX_THREADS 64
+
+/*
+ * Split scheduler
+ *
+ * Runs the scheduler over the process table, sorted by arrival time,
+ * with the same results as calling it directly. If the parameters ask
+ * for more than one split thread, and the table is big enough, it's
+ * cut into pieces where the CPU goes idle, and the pieces are
+ * scheduled at the same time on their own threads.
+ *
+ * Tables with a timeline are always scheduled in one go, so the
+ * timeline gets the slices in order.
+ */
+void split_scheduler(struct ProcessEntry *const restrict process_table,
+                     const int total_processes,
+                     const Scheduler scheduler_to_use,
+                     const struct SchedulerParameters *const restrict
+                     parameters);
+
+#endif
@@ -0,0 +1,397 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The process table is an array of structures, which doesn't suit
+ * SIMD, so the two times are first copied out into columns a block at
+ * a time. The blocks are small enough to stay in L1 while the kernels
+ * run over them.
+ *
+ * Which kernel is used is picked at run time, so the same binary will
+ * still run on a CPU without AVX2.
+ *
+ * The times themselves are long long, but nearly always fit an int,
+ * and the kernels work on ints to fit twice as many in a vector. Any
+ * block with a time that doesn't fit is added up without them.
+ */
+
+#include <assert.h>
+#include <limits.h>
+#include <stdbool.h>
+
+#include "statistics.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STATISTICS_X86 1
+#include <immintrin.h>
+#endif
+
+// Entries copied out per block.
+#define BLOCK_SIZE 512
+
+/*
+ * The kernels add a column of times to the statistics.
+ */
+typedef void (*StatisticsKernel)(struct TimeStatistics *const restrict time,
+                                 const int *const restrict column,
+                                 const int count);
+
+// Forward decs
+static bool fits_int(const long long value);
+static void add_block_wide(struct ProcessStatistics *const restrict stats,
+                           const struct ProcessEntry *const restrict block,
+                           const int count);
+static void scalar_kernel(struct TimeStatistics *const restrict time,
+                          const int *const restrict column,
+                          const int count);
+static StatisticsKernel select_kernel(void);
+static void add_time_series(struct TimeStatistics *const restrict time,
+                            const long long first,
+                            const long long step,
+                            const int count);
+
+#ifdef STATISTICS_X86
+static void sse41_kernel(struct TimeStatistics *const restrict time,
+                         const int *const restrict column,
+                         const int count);
+static void avx2_kernel(struct TimeStatistics *const restrict time,
+                        const int *const restrict column,
+                        const int count);
+#endif
+
+void init_process_statistics(struct ProcessStatistics *const restrict stats) {
+  stats->count = 0;
+
+  stats->waiting.total = 0;
+  stats->waiting.total_squares = 0.0;
+  stats->waiting.min = LLONG_MAX;
+  stats->waiting.max = LLONG_MIN;
+
+  stats->turnaround = stats->waiting;
+
+  stats->total_burst = 0;
+  stats->dispatches = 0;
+  stats->context_switches = 0;
+}
+
+void add_process_statistics(struct ProcessStatistics *const restrict stats,
+                            const struct ProcessEntry *const process_table,
+                            const int num_entries) {
+  assert(process_table != NULL || num_entries == 0);
+
+  const StatisticsKernel kernel = select_kernel();
+
+  int waiting[BLOCK_SIZE];
+  int turnaround[BLOCK_SIZE];
+
+  for (int start = 0; start < num_entries; start += BLOCK_SIZE) {
+    int block_count = num_entries - start;
+
+    if (block_count > BLOCK_SIZE) {
+      block_count = BLOCK_SIZE;
+    }
+
+    bool fits = true;
+
+    for (int i = 0; i < block_count; i++) {
+      const struct ProcessEntry *const entry = &process_table[start + i];
+
+      waiting[i] = (int) entry->waiting_time;
+      turnaround[i] = (int) entry->turnaround_time;
+      fits = fits && fits_int(entry->waiting_time) &&
+          fits_int(entry->turnaround_time);
+
+      stats->total_burst += entry->burst_time;
+      stats->dispatches += entry->dispatch_count;
+      stats->context_switches += entry->switch_count;
+    }
+
+    if (fits) {
+      kernel(&stats->waiting, waiting, block_count);
+      kernel(&stats->turnaround, turnaround, block_count);
+    } else {
+      add_block_wide(stats, &process_table[start], block_count);
+    }
+  }
+
+  stats->count += num_entries;
+}
+
+void add_series_statistics(struct ProcessStatistics *const restrict stats,
+                           const long long first_turnaround,
+                           const long long step,
+                           const int count,
+                           const int burst_time,
+                           const long long dispatches,
+                           const long long context_switches) {
+  if (count > 0) {
+    add_time_series(&stats->turnaround, first_turnaround, step, count);
+    add_time_series(&stats->waiting, first_turnaround - burst_time, step,
+                    count);
+
+    stats->total_burst += (long long) burst_time * count;
+    stats->dispatches += dispatches;
+    stats->context_switches += context_switches;
+    stats->count += count;
+  }
+}
+
+double time_variance(const struct TimeStatistics *const restrict time,
+                     const int count) {
+  double result = 0.0;
+
+  if (count > 0) {
+    const double mean = (double) time->total / count;
+    result = time->total_squares / count - mean * mean;
+
+    // Rounding can leave us just under zero when all the times match.
+    if (result < 0.0) {
+      result = 0.0;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * fits_int
+ *
+ * Whether the time can go through the kernels.
+ */
+static bool fits_int(const long long value) {
+  return value >= INT_MIN && value <= INT_MAX;
+}
+
+/*
+ * add_block_wide
+ *
+ * Adds the times from a block where some don't fit an int, one at a
+ * time as they are.
+ */
+static void add_block_wide(struct ProcessStatistics *const restrict stats,
+                           const struct ProcessEntry *const restrict block,
+                           const int count) {
+  for (int i = 0; i < count; i++) {
+    struct TimeStatistics *const times[2] = {
+      &stats->waiting, &stats->turnaround
+    };
+    const long long values[2] = {
+      block[i].waiting_time, block[i].turnaround_time
+    };
+
+    for (int which = 0; which < 2; which++) {
+      struct TimeStatistics *const time = times[which];
+      const long long value = values[which];
+
+      time->total += value;
+      time->total_squares += (double) value * value;
+
+      if (value < time->min) {
+        time->min = value;
+      }
+
+      if (value > time->max) {
+        time->max = value;
+      }
+    }
+  }
+}
+
+/*
+ * scalar_kernel
+ *
+ * Plain C, for when there's nothing better, and for the leftovers at
+ * the end of a column that don't fill a vector.
+ */
+static void scalar_kernel(struct TimeStatistics *const restrict time,
+                          const int *const restrict column,
+                          const int count) {
+  for (int i = 0; i < count; i++) {
+    const int value = column[i];
+
+    time->total += value;
+    time->total_squares += (double) value * value;
+
+    if (value < time->min) {
+      time->min = value;
+    }
+
+    if (value > time->max) {
+      time->max = value;
+    }
+  }
+}
+
+/*
+ * add_time_series
+ *
+ * Adds the times first, first + step, and so on, count of them, using
+ * the sums of arithmetic series and of their squares rather than
+ * going through them. step can't be negative, so the first is the
+ * smallest and the last the biggest.
+ */
+static void add_time_series(struct TimeStatistics *const restrict time,
+                            const long long first,
+                            const long long step,
+                            const int count) {
+  const long long last = first + step * (count - 1);
+  const double pairs = (double) count * (count - 1) / 2.0;
+
+  time->total += first * count + step * ((long long) count * (count - 1) / 2);
+  time->total_squares += (double) first * first * count +
+      2.0 * first * step * pairs +
+      (double) step * step * pairs * (2.0 * count - 1.0) / 3.0;
+
+  if (first < time->min) {
+    time->min = first;
+  }
+
+  if (last > time->max) {
+    time->max = last;
+  }
+}
+
+/*
+ * select_kernel
+ *
+ * Best kernel the CPU supports.
+ */
+static StatisticsKernel select_kernel(void) {
+  StatisticsKernel kernel = scalar_kernel;
+
+#ifdef STATISTICS_X86
+  if (__builtin_cpu_supports("avx2")) {
+    kernel = avx2_kernel;
+  } else if (__builtin_cpu_supports("sse4.1")) {
+    kernel = sse41_kernel;
+  }
+#endif
+
+  return kernel;
+}
+
+#ifdef STATISTICS_X86
+
+/*
+ * sse41_kernel
+ *
+ * Four times at a time. Totals are widened to 64 bits, two lanes at a
+ * time, before they're added.
+ */
+__attribute__((target("sse4.1")))
+static void sse41_kernel(struct TimeStatistics *const restrict time,
+                         const int *const restrict column,
+                         const int count) {
+  __m128i totals = _mm_setzero_si128();
+  __m128d squares = _mm_setzero_pd();
+  // The lanes start from the first in the block, the minimum and
+  // maximum so far might not fit.
+  __m128i mins = _mm_set1_epi32(column[0]);
+  __m128i maxs = mins;
+
+  int i = 0;
+
+  for (; i + 4 <= count; i += 4) {
+    const __m128i values = _mm_loadu_si128((const __m128i *) &column[i]);
+    const __m128i high = _mm_srli_si128(values, 8);
+
+    mins = _mm_min_epi32(mins, values);
+    maxs = _mm_max_epi32(maxs, values);
+
+    totals = _mm_add_epi64(totals, _mm_cvtepi32_epi64(values));
+    totals = _mm_add_epi64(totals, _mm_cvtepi32_epi64(high));
+
+    const __m128d low_doubles = _mm_cvtepi32_pd(values);
+    const __m128d high_doubles = _mm_cvtepi32_pd(high);
+    squares = _mm_add_pd(squares, _mm_mul_pd(low_doubles, low_doubles));
+    squares = _mm_add_pd(squares, _mm_mul_pd(high_doubles, high_doubles));
+  }
+
+  long long total_lanes[2];
+  double square_lanes[2];
+  int min_lanes[4];
+  int max_lanes[4];
+
+  _mm_storeu_si128((__m128i *) total_lanes, totals);
+  _mm_storeu_pd(square_lanes, squares);
+  _mm_storeu_si128((__m128i *) min_lanes, mins);
+  _mm_storeu_si128((__m128i *) max_lanes, maxs);
+
+  time->total += total_lanes[0] + total_lanes[1];
+  time->total_squares += square_lanes[0] + square_lanes[1];
+
+  for (int lane = 0; lane < 4; lane++) {
+    if (min_lanes[lane] < time->min) {
+      time->min = min_lanes[lane];
+    }
+    if (max_lanes[lane] > time->max) {
+      time->max = max_lanes[lane];
+    }
+  }
+
+  scalar_kernel(time, &column[i], count - i);
+}
+
+/*
+ * avx2_kernel
+ *
+ * Same as the SSE4.1 kernel, but eight times at a time.
+ */
+__attribute__((target("avx2")))
+static void avx2_kernel(struct TimeStatistics *const restrict time,
+                        const int *const restrict column,
+                        const int count) {
+  __m256i totals = _mm256_setzero_si256();
+  __m256d squares = _mm256_setzero_pd();
+  __m256i mins = _mm256_set1_epi32(column[0]);
+  __m256i maxs = mins;
+
+  int i = 0;
+
+  for (; i + 8 <= count; i += 8) {
+    const __m256i values = _mm256_loadu_si256((const __m256i *) &column[i]);
+    const __m128i low = _mm256_castsi256_si128(values);
+    const __m128i high = _mm256_extracti128_si256(values, 1);
+
+    mins = _mm256_min_epi32(mins, values);
+    maxs = _mm256_max_epi32(maxs, values);
+
+    totals = _mm256_add_epi64(totals, _mm256_cvtepi32_epi64(low));
+    totals = _mm256_add_epi64(totals, _mm256_cvtepi32_epi64(high));
+
+    const __m256d low_doubles = _mm256_cvtepi32_pd(low);
+    const __m256d high_doubles = _mm256_cvtepi32_pd(high);
+    squares = _mm256_add_pd(squares, _mm256_mul_pd(low_doubles, low_doubles));
+    squares = _mm256_add_pd(squares,
+                            _mm256_mul_pd(high_doubles, high_doubles));
+  }
+
+  long long total_lanes[4];
+  double square_lanes[4];
+  int min_lanes[8];
+  int max_lanes[8];
+
+  _mm256_storeu_si256((__m256i *) total_lanes, totals);
+  _mm256_storeu_pd(square_lanes, squares);
+  _mm256_storeu_si256((__m256i *) min_lanes, mins);
+  _mm256_storeu_si256((__m256i *) max_lanes, maxs);
+
+  for (int lane = 0; lane < 4; lane++) {
+    time->total += total_lanes[lane];
+    time->total_squares += square_lanes[lane];
+  }
+
+  for (int lane = 0; lane < 8; lane++) {
+    if (min_lanes[lane] < time->min) {
+      time->min = min_lanes[lane];
+    }
+    if (max_lanes[lane] > time->max) {
+      time->max = max_lanes[lane];
+    }
+  }
+
+  scalar_kernel(time, &column[i], count - i);
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Totals, minimums, maximums and variances of the waiting and
+ *   turnaround times from a scheduled process table.
+ */
+
+#ifndef STATISTICS_H_
+#define STATISTICS_H_
+
+#include "process_entry.h"
+
+/*
+ * TimeStatistics
+ *
+ * Running totals for one of the times, kept in a form that can be
+ * added to as more processes are scheduled. The sum of squares is a
+ * double, squares of large turnaround times can overflow 64 bits.
+ */
+struct TimeStatistics {
+  long long total;
+  double total_squares;
+  long long min;
+  long long max;
+};
+
+/*
+ * ProcessStatistics
+ *
+ * Statistics for both times, over count processes, along with the
+ * totals needed to work out how much time went on overheads.
+ */
+struct ProcessStatistics {
+  int count;
+  struct TimeStatistics waiting;
+  struct TimeStatistics turnaround;
+
+  long long total_burst;
+  long long dispatches;
+  long long context_switches;
+};
+
+/*
+ * Init process statistics
+ *
+ * Sets the statistics up for no processes.
+ */
+void init_process_statistics(struct ProcessStatistics *const restrict stats);
+
+/*
+ * Add process statistics
+ *
+ * Adds the waiting and turnaround times from the given entries to the
+ * statistics, all in the one pass over the table. Uses AVX2 or SSE4.1
+ * if the CPU we're running on has them.
+ *
+ * stats - Statistics to add to.
+ * process_table - Scheduled process entries.
+ * num_entries - Number of entries in the table.
+ */
+void add_process_statistics(struct ProcessStatistics *const restrict stats,
+                            const struct ProcessEntry *const process_table,
+                            const int num_entries);
+
+/*
+ * Add series statistics
+ *
+ * Adds count processes with no I/O and the same burst time, that
+ * finish step apart, the first with a turnaround time of
+ * first_turnaround. Between them they were dispatched dispatches
+ * times, context_switches of those needing a switch.
+ */
+void add_series_statistics(struct ProcessStatistics *const restrict stats,
+                           const long long first_turnaround,
+                           const long long step,
+                           const int count,
+                           const int burst_time,
+                           const long long dispatches,
+                           const long long context_switches);
+
+/*
+ * Time variance
+ *
+ * The population variance of the time, over count processes.
+ */
+double time_variance(const struct TimeStatistics *const restrict time,
+                     const int count);
+
+#endif
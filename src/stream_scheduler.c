@@ -0,0 +1,891 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The streaming schedulers make the same decisions as sjf_scheduler
+ * and rr_scheduler, but only look at processes as they arrive. Each
+ * process that has arrived and isn't finished has a slot, slots are
+ * reused once their process is done. Processes are numbered in the
+ * order they're read, the same as their index in a sorted table, and
+ * that's what ties are broken on and what goes in the timeline.
+ *
+ * Any number of policies can be run over the same trace in one go.
+ * They share one window of the trace, each only taking processes from
+ * it and never changing them, and each policy keeps its own slots.
+ * Every policy goes as far as it can with each block before the next
+ * is read, so the block is still in cache for the rest, and only what
+ * the slowest policy hasn't taken yet is kept.
+ *
+ * A trace is taken to be sorted until a process turns up that arrives
+ * before the one read before it. Then it's sorted with sort_trace and
+ * scheduled again from the start, reading from the sort instead. That
+ * way a sorted trace is only read once, and an unsorted one only
+ * wastes what was scheduled before that was noticed. With a timeline
+ * the trace is always sorted first, as there's no taking back what
+ * has been written to it.
+ */
+
+#include <assert.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "external_sort.h"
+#include "file_reader.h"
+#include "indexed_heap.h"
+#include "rr_scheduler.h"
+#include "sjf_scheduler.h"
+#include "statistics.h"
+#include "stream_scheduler.h"
+
+/*
+ * How many processes are read into the window at a time.
+ */
+#define STREAM_BLOCK_SIZE 4096
+
+/*
+ * StreamInput
+ *
+ * The processes read so far that not every policy has taken yet,
+ * window_count of them in the window, numbered from first_sequence.
+ * All the policies take them from here, so each process is only read
+ * once however many policies there are.
+ *
+ * pending - The process read after the last one in the window, only
+ *           if has_pending. Nothing that hasn't been read yet arrives
+ *           before it, so a policy only has to wait for more to be
+ *           read once it gets that far. Reading stops if a process
+ *           arrives before the one read before it, and unsorted is
+ *           set.
+ *
+ * Processes come from the reader, or from the sort once the trace has
+ * had to be sorted.
+ */
+struct StreamInput {
+  struct TraceReader reader;
+  struct ExternalSort sort;
+  bool sorted;
+
+  struct ProcessEntry *window;
+  int window_count;
+  int window_capacity;
+  int first_sequence;
+
+  struct ProcessEntry pending;
+  bool has_pending;
+  bool unsorted;
+};
+
+/*
+ * ReadyRing
+ *
+ * The round robin queue, count slots starting at head, wrapping
+ * around. Grows when it's full.
+ */
+struct ReadyRing {
+  int *slots;
+  int head;
+  int count;
+  int capacity;
+};
+
+/*
+ * PolicyState
+ *
+ * One policy being run over the input, with its own parameters, so
+ * round robin can be run at more than one quantum.
+ *
+ * slots - The processes that have arrived and aren't finished, live
+ *         of them, in any order.
+ * sequence - The number of the process in each slot.
+ * free_slots - Slots with nothing in them, free_count of them.
+ * next_sequence - Number of the next process to arrive.
+ * cpu_time, last_run - Where the schedule is up to, see stream_rr.
+ * ready - For SJF, the slots waiting for the CPU.
+ * ring, pass_left, first_turn - For round robin, see stream_rr.
+ * done - Finished processes waiting to go in the statistics.
+ */
+struct PolicyState {
+  Scheduler scheduler;
+  struct SchedulerParameters parameters;
+
+  struct ProcessEntry *slots;
+  int *sequence;
+  int *free_slots;
+  int free_count;
+  int capacity;
+  int live;
+
+  int next_sequence;
+  long long cpu_time;
+  int last_run;
+  bool finished;
+
+  struct IndexedHeap ready;
+  struct ReadyRing ring;
+  int pass_left;
+  bool first_turn;
+
+  struct ProcessEntry done[STREAM_DONE_SIZE];
+  int done_count;
+  struct ProcessStatistics statistics;
+};
+
+// Forward decs
+static void run_stream(struct StreamInput *const restrict input,
+                       struct PolicyState *const restrict states,
+                       const int count);
+static void reset_policy(struct PolicyState *const restrict state);
+static bool read_process(struct StreamInput *const restrict input,
+                         struct ProcessEntry *const restrict process);
+static void fill_window(struct StreamInput *const restrict input);
+static void drop_taken(struct StreamInput *const restrict input,
+                       const struct PolicyState *const restrict states,
+                       const int count);
+static const struct ProcessEntry *next_in_window(
+    const struct PolicyState *const restrict state,
+    const struct StreamInput *const restrict input);
+static int take_arrival(struct PolicyState *const restrict state,
+                        const struct ProcessEntry *const restrict next);
+static void finish_process(struct PolicyState *const restrict state,
+                           const int slot,
+                           const long long cpu_time);
+static void flush_done(struct PolicyState *const restrict state);
+static void stream_sjf(struct PolicyState *const restrict state,
+                       const struct StreamInput *const restrict input);
+static void stream_rr(struct PolicyState *const restrict state,
+                      const struct StreamInput *const restrict input);
+static long long turn_end(const struct PolicyState *const restrict state);
+static void take_turn(struct PolicyState *const restrict state,
+                      const struct StreamInput *const restrict input);
+static void skip_stable_passes(struct PolicyState *const restrict state,
+                               const struct StreamInput *const restrict
+                               input);
+static void ring_push(struct ReadyRing *const restrict ring, const int slot);
+static int ring_pop(struct ReadyRing *const restrict ring);
+static int ring_at(const struct ReadyRing *const restrict ring,
+                   const int position);
+
+bool can_stream(const Scheduler scheduler_to_use,
+                const struct SchedulerParameters *const restrict parameters) {
+  return (scheduler_to_use == &sjf_scheduler &&
+          parameters->prediction_weight == 0) ||
+      scheduler_to_use == &rr_scheduler;
+}
+
+struct SchedulerAverages stream_scheduler(
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters) {
+  const struct StreamPolicy policy = { scheduler_to_use, 0 };
+  struct SchedulerAverages averages;
+
+  stream_schedulers(filename, &policy, 1, parameters, &averages);
+
+  return averages;
+}
+
+void stream_schedulers(
+    const char *const restrict filename,
+    const struct StreamPolicy *const restrict policies,
+    const int count,
+    const struct SchedulerParameters *const restrict parameters,
+    struct SchedulerAverages *const restrict averages) {
+
+  assert(count > 0);
+  assert(count == 1 || parameters->timeline == NULL);
+
+  struct StreamInput input;
+  input.sorted = false;
+  input.window = NULL;
+  input.window_capacity = 0;
+
+  struct PolicyState *const states = malloc(sizeof(struct PolicyState) *
+                                            count);
+  assert(states != NULL);
+
+  for (int i = 0; i < count; i++) {
+    assert(can_stream(policies[i].scheduler, parameters));
+
+    states[i].scheduler = policies[i].scheduler;
+    states[i].parameters = *parameters;
+    states[i].parameters.phases = NULL;
+    states[i].slots = NULL;
+    states[i].sequence = NULL;
+    states[i].free_slots = NULL;
+    states[i].capacity = 0;
+    states[i].ring.slots = NULL;
+    states[i].ring.capacity = 0;
+    init_indexed_heap(&states[i].ready, 0);
+  }
+
+  int quantum = 0;
+  enum FileError error = FILE_ERR_NONE;
+  input.unsorted = (parameters->timeline != NULL);
+
+  // Lines already read, and warned about, before finding the trace
+  // isn't sorted.
+  long lines_read = 0;
+
+  if (!input.unsorted) {
+    error = open_trace_reader(filename, &input.reader, &quantum);
+
+    if (error == FILE_ERR_NONE) {
+      for (int i = 0; i < count; i++) {
+        states[i].parameters.quantum = (policies[i].quantum > 0) ?
+            policies[i].quantum : quantum;
+      }
+
+      run_stream(&input, states, count);
+      lines_read = input.reader.lines_read;
+      close_trace_reader(&input.reader);
+    }
+  }
+
+  if (error == FILE_ERR_NONE && input.unsorted) {
+    error = sort_trace(filename, (size_t) parameters->sort_memory << 20,
+                       &input.sort, &quantum, lines_read);
+
+    if (error == FILE_ERR_NONE) {
+      for (int i = 0; i < count; i++) {
+        states[i].parameters.quantum = (policies[i].quantum > 0) ?
+            policies[i].quantum : quantum;
+      }
+
+      input.sorted = true;
+      run_stream(&input, states, count);
+      destroy_external_sort(&input.sort);
+    }
+  }
+
+  if (error != FILE_ERR_NONE) {
+    perror("main() - File Error");
+  }
+
+  for (int i = 0; i < count; i++) {
+    const struct SchedulerAverages no_averages = {0.0,0.0};
+
+    if (error == FILE_ERR_NONE) {
+      averages[i] = averages_from_statistics(&states[i].statistics,
+                                             &states[i].parameters);
+    } else {
+      averages[i] = no_averages;
+    }
+
+    destroy_indexed_heap(&states[i].ready);
+    free(states[i].ring.slots);
+    free(states[i].free_slots);
+    free(states[i].sequence);
+    free(states[i].slots);
+  }
+
+  free(states);
+  free(input.window);
+}
+
+/*
+ * run_stream
+ *
+ * Schedules the whole trace with every policy, from wherever the
+ * input reads it. A block is read into the window, then each policy
+ * goes as far as it can with what's been read, then the next block,
+ * and so on. Stops early if the trace turns out not to be sorted.
+ */
+static void run_stream(struct StreamInput *const restrict input,
+                       struct PolicyState *const restrict states,
+                       const int count) {
+  input->window_count = 0;
+  input->first_sequence = 0;
+  input->unsorted = false;
+  input->has_pending = read_process(input, &input->pending);
+
+  for (int i = 0; i < count; i++) {
+    reset_policy(&states[i]);
+  }
+
+  if (input->has_pending) {
+    for (int i = 0; i < count; i++) {
+      if (states[i].parameters.timeline != NULL) {
+        start_timeline_run(states[i].parameters.timeline);
+      }
+    }
+
+    fill_window(input);
+
+    bool running = true;
+
+    while (running && !input->unsorted) {
+      running = false;
+
+      for (int i = 0; i < count; i++) {
+        if (!states[i].finished) {
+          if (states[i].scheduler == &sjf_scheduler) {
+            stream_sjf(&states[i], input);
+          } else {
+            stream_rr(&states[i], input);
+          }
+
+          running = running || !states[i].finished;
+        }
+      }
+
+      if (running) {
+        drop_taken(input, states, count);
+        fill_window(input);
+      }
+    }
+
+    for (int i = 0; i < count; i++) {
+      if (states[i].parameters.timeline != NULL) {
+        flush_timeline(states[i].parameters.timeline);
+      }
+
+      flush_done(&states[i]);
+    }
+  }
+}
+
+/*
+ * reset_policy
+ *
+ * Gets ready to schedule from the start of the trace, with nothing
+ * arrived yet. Any slots already allocated are kept.
+ */
+static void reset_policy(struct PolicyState *const restrict state) {
+  state->free_count = 0;
+
+  for (int slot = state->capacity - 1; slot >= 0; slot--) {
+    state->free_slots[state->free_count++] = slot;
+  }
+
+  state->live = 0;
+  state->next_sequence = 0;
+  state->cpu_time = 0;
+  state->last_run = -1;
+  state->finished = false;
+
+  // A run given up on part way can leave processes in the heap.
+  destroy_indexed_heap(&state->ready);
+  init_indexed_heap(&state->ready, state->capacity);
+
+  state->ring.head = 0;
+  state->ring.count = 0;
+  state->pass_left = 0;
+  state->first_turn = false;
+
+  state->done_count = 0;
+  init_process_statistics(&state->statistics);
+}
+
+/*
+ * read_process
+ *
+ * Reads the next process, in file order, or arrival time order once
+ * the trace has been sorted. Returns false once there are no more.
+ */
+static bool read_process(struct StreamInput *const restrict input,
+                         struct ProcessEntry *const restrict process) {
+  bool result;
+
+  if (input->sorted) {
+    result = next_sorted_process(&input->sort, process);
+  } else {
+    result = read_trace_process(&input->reader, process);
+  }
+
+  return result;
+}
+
+/*
+ * fill_window
+ *
+ * Moves up to a block of processes into the window, starting with the
+ * pending one, reading the one after each as it goes.
+ */
+static void fill_window(struct StreamInput *const restrict input) {
+  for (int i = 0; i < STREAM_BLOCK_SIZE && input->has_pending; i++) {
+    if (input->window_count == input->window_capacity) {
+      input->window_capacity += STREAM_BLOCK_SIZE;
+      input->window = realloc(input->window, sizeof(struct ProcessEntry) *
+                              input->window_capacity);
+      assert(input->window != NULL);
+    }
+
+    const int last_arrival = input->pending.arrival_time;
+
+    input->window[input->window_count++] = input->pending;
+    input->has_pending = read_process(input, &input->pending);
+
+    if (input->has_pending && input->pending.arrival_time < last_arrival) {
+      input->unsorted = true;
+      input->has_pending = false;
+    }
+  }
+}
+
+/*
+ * drop_taken
+ *
+ * Drops the processes at the front of the window that every policy
+ * still going has already taken.
+ */
+static void drop_taken(struct StreamInput *const restrict input,
+                       const struct PolicyState *const restrict states,
+                       const int count) {
+  int taken = input->first_sequence + input->window_count;
+
+  for (int i = 0; i < count; i++) {
+    if (!states[i].finished && states[i].next_sequence < taken) {
+      taken = states[i].next_sequence;
+    }
+  }
+
+  const int drop = taken - input->first_sequence;
+
+  memmove(input->window, input->window + drop,
+          sizeof(struct ProcessEntry) * (input->window_count - drop));
+  input->window_count -= drop;
+  input->first_sequence = taken;
+}
+
+/*
+ * next_in_window
+ *
+ * The next process to arrive for the policy, NULL if it has taken
+ * everything in the window.
+ */
+static const struct ProcessEntry *next_in_window(
+    const struct PolicyState *const restrict state,
+    const struct StreamInput *const restrict input) {
+  const int index = state->next_sequence - input->first_sequence;
+
+  return (index < input->window_count) ? &input->window[index] : NULL;
+}
+
+/*
+ * take_arrival
+ *
+ * Puts the next process in a slot, making room if needed. Returns the
+ * slot.
+ */
+static int take_arrival(struct PolicyState *const restrict state,
+                        const struct ProcessEntry *const restrict next) {
+  if (state->free_count == 0) {
+    const int new_capacity = (state->capacity > 0) ?
+        state->capacity * 2 : 64;
+
+    state->slots = realloc(state->slots,
+                           sizeof(struct ProcessEntry) * new_capacity);
+    state->sequence = realloc(state->sequence, sizeof(int) * new_capacity);
+    state->free_slots = realloc(state->free_slots,
+                                sizeof(int) * new_capacity);
+
+    assert(state->slots != NULL);
+    assert(state->sequence != NULL);
+    assert(state->free_slots != NULL);
+
+    // Lowest slots on top, so they're used first.
+    for (int slot = new_capacity - 1; slot >= state->capacity; slot--) {
+      state->free_slots[state->free_count++] = slot;
+    }
+
+    state->capacity = new_capacity;
+  }
+
+  const int slot = state->free_slots[--state->free_count];
+
+  state->slots[slot] = *next;
+  state->sequence[slot] = state->next_sequence++;
+  ++state->live;
+
+  return slot;
+}
+
+/*
+ * finish_process
+ *
+ * The process in the slot finished at cpu_time. Its results join the
+ * others waiting to go in the statistics, and the slot is free again.
+ */
+static void finish_process(struct PolicyState *const restrict state,
+                           const int slot,
+                           const long long cpu_time) {
+  struct ProcessEntry *const process = &state->slots[slot];
+
+  process->turnaround_time = cpu_time - process->arrival_time;
+  process->waiting_time = process->turnaround_time - process->burst_time;
+
+  state->done[state->done_count++] = *process;
+
+  if (state->done_count == STREAM_DONE_SIZE) {
+    flush_done(state);
+  }
+
+  state->free_slots[state->free_count++] = slot;
+  --state->live;
+}
+
+/*
+ * flush_done
+ *
+ * Adds the finished processes to the statistics.
+ */
+static void flush_done(struct PolicyState *const restrict state) {
+  add_process_statistics(&state->statistics, state->done,
+                         state->done_count);
+  state->done_count = 0;
+}
+
+/*
+ * stream_sjf
+ *
+ * Processes that have arrived wait in a heap keyed on their burst,
+ * then their number, so ties go to whichever arrived first the same
+ * as sjf_scheduler. Each process runs once, costing a dispatch and a
+ * switch.
+ *
+ * Goes until everything is done, or until it would have to know about
+ * processes that haven't been read yet, to be carried on after the
+ * next block.
+ */
+static void stream_sjf(struct PolicyState *const restrict state,
+                       const struct StreamInput *const restrict input) {
+  const struct SchedulerParameters *const parameters = &state->parameters;
+  bool waiting = false;
+
+  while (!state->finished && !waiting) {
+    const struct ProcessEntry *next = next_in_window(state, input);
+
+    while (next != NULL && next->arrival_time <= state->cpu_time) {
+      const int slot = take_arrival(state, next);
+
+      grow_indexed_heap(&state->ready, state->capacity);
+      heap_push(&state->ready, slot,
+                ((long long) state->slots[slot].burst_time << 32) |
+                (unsigned int) state->sequence[slot]);
+
+      next = next_in_window(state, input);
+    }
+
+    if (next == NULL && input->has_pending &&
+        (heap_is_empty(&state->ready) ||
+         input->pending.arrival_time <= state->cpu_time)) {
+      // What arrives next hasn't been read yet.
+      waiting = true;
+    } else if (heap_is_empty(&state->ready)) {
+      if (next == NULL) {
+        state->finished = true;
+      } else {
+        // Nothing to do until the next process turns up.
+        state->cpu_time = next->arrival_time;
+      }
+    } else {
+      const int slot = heap_pop(&state->ready);
+      struct ProcessEntry *const process = &state->slots[slot];
+
+      state->cpu_time += parameters->dispatch_cost + parameters->switch_cost;
+      process->dispatch_count = 1;
+      process->switch_count = 1;
+
+      state->cpu_time += process->burst_time;
+
+      if (parameters->timeline != NULL) {
+        add_timeline_slice(parameters->timeline, state->sequence[slot],
+                           state->cpu_time - process->burst_time,
+                           state->cpu_time);
+      }
+
+      process->burst_time_remaining = 0;
+      finish_process(state, slot, state->cpu_time);
+    }
+  }
+}
+
+/*
+ * stream_rr
+ *
+ * Works in passes through the queue, the same as rr_scheduler. After
+ * the first turn of each pass, everything that has arrived by then
+ * joins the back of the queue and gets a turn in the same pass. Each
+ * turn the process goes to the back, so the queue stays in arrival
+ * order, starting wherever the pass is up to.
+ *
+ * pass_left - Turns left in this pass.
+ * last_run - Number of the process that last had the CPU, -1 when the
+ *            CPU has been idle.
+ *
+ * Goes until everything is done, or until it would have to know about
+ * processes that haven't been read yet, to be carried on after the
+ * next block. A pass can't start without its first process, and the
+ * first turn of a pass can't be taken if anything still to be read
+ * might arrive before it ends.
+ */
+static void stream_rr(struct PolicyState *const restrict state,
+                      const struct StreamInput *const restrict input) {
+  bool waiting = false;
+
+  while (!state->finished && !waiting) {
+    if (state->pass_left == 0) {
+      // Everything in the queue is done, the next process starts a
+      // pass of its own, if it hasn't arrived the CPU is idle until
+      // it does.
+      if (state->ring.count == 0) {
+        const struct ProcessEntry *const next = next_in_window(state, input);
+
+        if (next == NULL) {
+          waiting = input->has_pending;
+          state->finished = !input->has_pending;
+        } else {
+          if (next->arrival_time > state->cpu_time) {
+            state->cpu_time = next->arrival_time;
+            state->last_run = -1;
+          }
+
+          ring_push(&state->ring, take_arrival(state, next));
+        }
+      }
+
+      if (state->ring.count > 0) {
+        if (state->parameters.timeline == NULL) {
+          skip_stable_passes(state, input);
+        }
+
+        state->pass_left = state->ring.count;
+        state->first_turn = true;
+      }
+    } else if (state->first_turn && input->has_pending &&
+               input->pending.arrival_time <= turn_end(state)) {
+      waiting = true;
+    } else {
+      take_turn(state, input);
+    }
+  }
+}
+
+/*
+ * turn_end
+ *
+ * When the turn of the process at the front of the queue would end.
+ */
+static long long turn_end(const struct PolicyState *const restrict state) {
+  const int slot = ring_at(&state->ring, 0);
+  const int remaining = state->slots[slot].burst_time_remaining;
+  const int quantum = state->parameters.quantum;
+
+  long long end = state->cpu_time + state->parameters.dispatch_cost +
+      ((remaining < quantum) ? remaining : quantum);
+
+  if (state->sequence[slot] != state->last_run) {
+    end += state->parameters.switch_cost;
+  }
+
+  return end;
+}
+
+/*
+ * take_turn
+ *
+ * Gives the process at the front of the queue its turn. After the
+ * first turn of a pass, everything in the window that has arrived by
+ * then joins the queue.
+ */
+static void take_turn(struct PolicyState *const restrict state,
+                      const struct StreamInput *const restrict input) {
+  const struct SchedulerParameters *const parameters = &state->parameters;
+  const int quantum = parameters->quantum;
+
+  const int slot = ring_pop(&state->ring);
+  struct ProcessEntry *const process = &state->slots[slot];
+
+  const int turn_length = (process->burst_time_remaining < quantum) ?
+      process->burst_time_remaining : quantum;
+
+  state->cpu_time += parameters->dispatch_cost;
+  process->dispatch_count++;
+
+  if (state->sequence[slot] != state->last_run) {
+    state->cpu_time += parameters->switch_cost;
+    process->switch_count++;
+    state->last_run = state->sequence[slot];
+  }
+
+  state->cpu_time += turn_length;
+  process->burst_time_remaining -= turn_length;
+  --state->pass_left;
+
+  if (parameters->timeline != NULL) {
+    add_timeline_slice(parameters->timeline, state->sequence[slot],
+                       state->cpu_time - turn_length, state->cpu_time);
+  }
+
+  const bool finished = (process->burst_time_remaining == 0);
+
+  // Taking arrivals can move the slots, process can't be used after.
+  if (state->first_turn) {
+    const struct ProcessEntry *next = next_in_window(state, input);
+
+    while (next != NULL && next->arrival_time <= state->cpu_time) {
+      ring_push(&state->ring, take_arrival(state, next));
+      ++state->pass_left;
+      next = next_in_window(state, input);
+    }
+
+    state->first_turn = false;
+  }
+
+  if (!finished) {
+    ring_push(&state->ring, slot);
+  } else {
+    finish_process(state, slot, state->cpu_time);
+  }
+}
+
+/*
+ * skip_stable_passes
+ *
+ * Called at the start of a pass. Runs as many whole passes as can be
+ * done in one go, where every process in the queue uses a full
+ * quantum, nobody finishes, and nothing new arrives by the end of the
+ * first turn of any of them. See stable_passes in rr_scheduler. Past
+ * the window, nothing arrives before the pending process, so that's
+ * as far as it can go.
+ */
+static void skip_stable_passes(struct PolicyState *const restrict state,
+                               const struct StreamInput *const restrict
+                               input) {
+  const struct SchedulerParameters *const parameters = &state->parameters;
+  const struct ReadyRing *const ring = &state->ring;
+  const int quantum = parameters->quantum;
+  const int in_queue = ring->count;
+
+  int least_remaining = state->slots[ring_at(ring, 0)].burst_time_remaining;
+
+  for (int i = 1; i < in_queue; i++) {
+    const int remaining = state->slots[ring_at(ring, i)].burst_time_remaining;
+
+    if (remaining < least_remaining) {
+      least_remaining = remaining;
+    }
+  }
+
+  const int first_run = state->sequence[ring_at(ring, 0)];
+  const int last_in_queue = state->sequence[ring_at(ring, in_queue - 1)];
+
+  long long turn_length = (long long) quantum + parameters->dispatch_cost;
+
+  if (in_queue > 1) {
+    turn_length += parameters->switch_cost;
+  }
+
+  const struct ProcessEntry *next = next_in_window(state, input);
+
+  if (next == NULL && input->has_pending) {
+    next = &input->pending;
+  }
+
+  long long passes = 0;
+
+  if ((in_queue > 1) == (first_run != state->last_run)) {
+    passes = (least_remaining - 1) / quantum;
+
+    if (next != NULL && passes > 0) {
+      const long long pass_length = turn_length * in_queue;
+      const long long until_arrival =
+          next->arrival_time - state->cpu_time - turn_length;
+      long long before_arrival = 0;
+
+      if (until_arrival > 0) {
+        before_arrival = (until_arrival + pass_length - 1) / pass_length;
+      }
+
+      if (before_arrival < passes) {
+        passes = before_arrival;
+      }
+    }
+  }
+
+  if (passes > 0) {
+    for (int i = 0; i < in_queue; i++) {
+      struct ProcessEntry *const process = &state->slots[ring_at(ring, i)];
+
+      process->burst_time_remaining -= passes * quantum;
+      process->dispatch_count += passes;
+
+      // On its own, a process just carries on without a switch.
+      if (in_queue > 1) {
+        process->switch_count += passes;
+      }
+    }
+
+    state->cpu_time += passes * turn_length * in_queue;
+    state->last_run = last_in_queue;
+  }
+}
+
+/*
+ * ring_push
+ *
+ * Adds a slot to the back of the queue.
+ */
+static void ring_push(struct ReadyRing *const restrict ring, const int slot) {
+  if (ring->count == ring->capacity) {
+    const int new_capacity = (ring->capacity > 0) ? ring->capacity * 2 : 64;
+    int *const slots = malloc(sizeof(int) * new_capacity);
+    assert(slots != NULL);
+
+    for (int i = 0; i < ring->count; i++) {
+      slots[i] = ring_at(ring, i);
+    }
+
+    free(ring->slots);
+    ring->slots = slots;
+    ring->head = 0;
+    ring->capacity = new_capacity;
+  }
+
+  int tail = ring->head + ring->count;
+
+  if (tail >= ring->capacity) {
+    tail -= ring->capacity;
+  }
+
+  ring->slots[tail] = slot;
+  ++ring->count;
+}
+
+/*
+ * ring_pop
+ *
+ * Takes the slot at the front of the queue.
+ */
+static int ring_pop(struct ReadyRing *const restrict ring) {
+  assert(ring->count > 0);
+
+  const int slot = ring->slots[ring->head];
+
+  ++ring->head;
+  if (ring->head == ring->capacity) {
+    ring->head = 0;
+  }
+  --ring->count;
+
+  return slot;
+}
+
+/*
+ * ring_at
+ *
+ * The slot at the given position from the front of the queue.
+ */
+static int ring_at(const struct ReadyRing *const restrict ring,
+                   const int position) {
+  int index = ring->head + position;
+
+  if (index >= ring->capacity) {
+    index -= ring->capacity;
+  }
+
+  return ring->slots[index];
+}
@@ -0,0 +1,82 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Schedules a trace while it's being read, for traces too big to
+ *   load into memory.
+ */
+
+#ifndef STREAM_SCHEDULER_H_
+#define STREAM_SCHEDULER_H_
+
+#include <stdbool.h>
+
+#include "scheduler.h"
+#include "scheduler_parameters.h"
+
+/*
+ * How many finished processes are kept before they're added to the
+ * statistics, so they're added a block at a time.
+ */
+#define STREAM_DONE_SIZE 512
+
+/*
+ * StreamPolicy
+ *
+ * One of the schedulers to stream a trace through, and the quantum to
+ * use, 0 for the one in the file.
+ */
+struct StreamPolicy {
+  Scheduler scheduler;
+  int quantum;
+};
+
+/*
+ * Can stream
+ *
+ * True if there's a streaming version of the scheduler with these
+ * parameters. Only SJF and round robin have one, the others need the
+ * whole trace loaded, and so does SJF on predicted bursts.
+ */
+bool can_stream(const Scheduler scheduler_to_use,
+                const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * Stream scheduler
+ *
+ * Reads the trace in the file a process at a time and schedules it
+ * as it goes, with the same results as run_scheduler. Only the
+ * processes that have arrived and aren't finished are kept, so memory
+ * use depends on how many of those there are at once, not on how long
+ * the trace is. Finished processes go straight into the statistics.
+ *
+ * If the trace turns out not to be sorted by arrival time, it's sorted
+ * with sort_trace, in the sort memory given in the parameters, and
+ * scheduled again from the start. Processes that do I/O are skipped.
+ *
+ * The scheduler must be one can_stream is true for. The quantum in
+ * the parameters is ignored, the one from the file is used.
+ */
+struct SchedulerAverages stream_scheduler(
+    const char *const restrict filename,
+    const Scheduler scheduler_to_use,
+    const struct SchedulerParameters *const restrict parameters);
+
+/*
+ * Stream schedulers
+ *
+ * The same as stream_scheduler, for each of the policies at once,
+ * reading the trace only once between them. The averages for each
+ * policy go in the same place in averages. With a timeline there can
+ * only be the one policy, as the timeline is for a single scheduler.
+ */
+void stream_schedulers(
+    const char *const restrict filename,
+    const struct StreamPolicy *const restrict policies,
+    const int count,
+    const struct SchedulerParameters *const restrict parameters,
+    struct SchedulerAverages *const restrict averages);
+
+#endif
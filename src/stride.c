@@ -0,0 +1,15 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Mainline of the stride scheduler.
+ */
+
+#include "scheduler_program.h"
+#include "stride_scheduler.h"
+
+int main(int argc, char *argv[]) {
+  return scheduler_program(argc, argv, &stride_scheduler, "STRIDE",
+                           "Stride Simulation: ");
+}
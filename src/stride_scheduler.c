@@ -0,0 +1,106 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "indexed_heap.h"
+#include "stride_scheduler.h"
+
+/*
+ * Stride of a process with one ticket. Large, so dividing it by the
+ * tickets doesn't lose much.
+ */
+#define STRIDE_ONE (1 << 20)
+
+/*
+ * stride_scheduler
+ *
+ * Processes waiting for a turn are kept in a heap on their pass. A
+ * process that arrives starts one stride past the pass of the last
+ * process to have a turn, so it doesn't get to catch up on turns from
+ * before it arrived. When the CPU goes idle, passes start again from
+ * zero, so each busy period is scheduled the same however it's
+ * reached.
+ *
+ * Each turn costs a dispatch, and a context switch if the process
+ * isn't the one that just had the CPU.
+ */
+void stride_scheduler(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters) {
+
+  assert(process_table != NULL);
+
+  long long *const passes = malloc(sizeof(long long) * total_processes);
+  assert(passes != NULL);
+
+  struct IndexedHeap waiting;
+  init_indexed_heap(&waiting, total_processes);
+
+  long long cpu_time = process_table[0].arrival_time;
+  long long current_pass = 0;
+  int next_arrival = 0;
+  int processes_remaining = total_processes;
+  int last_run = -1;
+
+  while (processes_remaining > 0) {
+    while (next_arrival < total_processes &&
+           process_table[next_arrival].arrival_time <= cpu_time) {
+      passes[next_arrival] = current_pass +
+          STRIDE_ONE / process_table[next_arrival].tickets;
+      heap_push(&waiting, next_arrival, passes[next_arrival]);
+      ++next_arrival;
+    }
+
+    if (heap_is_empty(&waiting)) {
+      // Nothing to do until the next process turns up.
+      cpu_time = process_table[next_arrival].arrival_time;
+      current_pass = 0;
+      last_run = -1;
+    } else {
+      const int process_to_run = heap_pop(&waiting);
+      struct ProcessEntry *const process = &process_table[process_to_run];
+
+      current_pass = passes[process_to_run];
+
+      cpu_time += parameters->dispatch_cost;
+      process->dispatch_count++;
+
+      if (process_to_run != last_run) {
+        cpu_time += parameters->switch_cost;
+        process->switch_count++;
+        last_run = process_to_run;
+      }
+
+      const int run_time = (process->burst_time_remaining <
+                            parameters->quantum) ?
+          process->burst_time_remaining : parameters->quantum;
+
+      cpu_time += run_time;
+      process->burst_time_remaining -= run_time;
+
+      if (parameters->timeline != NULL) {
+        add_timeline_slice(parameters->timeline, process_to_run,
+                           cpu_time - run_time, cpu_time);
+      }
+
+      if (process->burst_time_remaining > 0) {
+        passes[process_to_run] += STRIDE_ONE / process->tickets;
+        heap_push(&waiting, process_to_run, passes[process_to_run]);
+      } else {
+        process->turnaround_time = cpu_time - process->arrival_time;
+        process->waiting_time = process->turnaround_time -
+            process->burst_time;
+        --processes_remaining;
+      }
+    }
+  }
+
+  destroy_indexed_heap(&waiting);
+  free(passes);
+}
@@ -0,0 +1,35 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The stride scheduler, a proportional share scheduler. Each process
+ * gets turns of up to the quantum, in proportion to its tickets, with
+ * no randomness involved.
+ */
+
+#ifndef STRIDE_SCHEDULER_H_
+#define STRIDE_SCHEDULER_H_
+
+#include "process_entry.h"
+#include "scheduler_parameters.h"
+
+/*
+ * Stride Scheduler
+ *
+ * Takes a pointer to an array of ProcessEntries and runs a stride
+ * scheduler on it. Every process has a stride, inversely proportional
+ * to its tickets, and a pass that goes up by its stride each turn it
+ * has. The process with the lowest pass always gets the next turn.
+ *
+ * The array being passed in is expected to be sorted.
+ *
+ * When the scheduler is run, it will update the process entries with
+ * turnaround and waiting times. (Mutable data!)
+ */
+void stride_scheduler(
+    struct ProcessEntry *const restrict process_table,
+    const int total_processes,
+    const struct SchedulerParameters *const restrict parameters);
+
+#endif
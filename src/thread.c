@@ -5,151 +5,312 @@
  *
  * The scheduler threads, these are the threads that do the actual
  * calculation, reading the input from the parent thread, then writing
- * to the output buffer when completed.
+ * to their output buffer when completed.
  *
- * Their flow of control is in a few stages, with the transition from
- * each stage being controlled by the parent thread.
+ * They're run by a worker pool, the parent thread starts a batch for
+ * the files it has and reads the output buffers once it's done.
  *
- * Check the assignment.c for details.
+ * Check simulator.c for details.
  */
 
-#include <pthread.h>
+#include <assert.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
+#include "monte_carlo.h"
+#include "perf_counters.h"
 #include "rr_scheduler.h"
 #include "scheduler.h"
-#include "sjf_scheduler.h"
+#include "scheduler_table.h"
 #include "thread.h"
-
-// Strings for displaying scheduler type.
-#define RR_STR "RR"
-#define SJF_STR "SJF"
+#include "timeline.h"
 
 // Forward declarations.
-static Scheduler setup_sched_thread(struct SharedData *const restrict shared_data,
-                                    int *const restrict thread_number);
-
+static struct SchedThread *new_sched_thread(
+    const struct SharedData *const restrict shared_data,
+    const int thread_number);
+static void run_fused(struct SharedData *const restrict shared_data,
+                      struct SchedThread *const restrict thread);
+static void add_what_if_to_buffer(struct SharedData *const restrict shared_data,
+                                  const int thread_number,
+                                  const int file_number);
 static void write_result_to_buffer(struct SharedData *const restrict shared_data,
                                    struct SchedulerAverages averages,
-                                   const int thread_number);
+                                   const int thread_number,
+                                   const int file_number);
+
+void init_fused(struct SharedData *const restrict shared_data) {
+  const struct Options *const options = &shared_data->options;
+
+  shared_data->fused_leader = -1;
+  shared_data->fused_count = 0;
+
+  if (options->parameters.stream && !options->follow &&
+      !options->count_stages && shared_data->timeline_file == NULL) {
+    for (int i = 0; i < NUM_SCHEDULERS; i++) {
+      if (can_stream(SCHEDULERS[i].scheduler, &options->parameters)) {
+        if (shared_data->fused_leader < 0) {
+          shared_data->fused_leader = i;
+        }
+
+        const int policy = shared_data->fused_count++;
+        shared_data->fused_policies[policy].scheduler =
+            SCHEDULERS[i].scheduler;
+        shared_data->fused_policies[policy].quantum = 0;
+        shared_data->fused_names[policy] = SCHEDULERS[i].name;
+      }
+    }
+
+    for (int i = 0; i < options->quanta_count; i++) {
+      char *const name = shared_data->quanta_names[i];
+      snprintf(name, RESULT_CACHE_NAME_SIZE, "RR(%d)", options->quanta[i]);
+
+      const int policy = shared_data->fused_count++;
+      shared_data->fused_policies[policy].scheduler = &rr_scheduler;
+      shared_data->fused_policies[policy].quantum = options->quanta[i];
+      shared_data->fused_names[policy] = name;
+    }
+  }
+}
+
+bool is_fused(const struct SharedData *const restrict shared_data,
+              const int thread_number) {
+  return shared_data->fused_leader >= 0 &&
+      can_stream(SCHEDULERS[thread_number].scheduler,
+                 &shared_data->options.parameters);
+}
+
+void destroy_sched_thread(struct SharedData *const restrict shared_data,
+                          const int thread_number) {
+  struct SchedThread *const thread = shared_data->threads[thread_number];
+
+  if (thread != NULL) {
+    destroy_trace_state(&thread->trace_state);
+
+    if (shared_data->timeline_file != NULL) {
+      destroy_timeline(&thread->timeline);
+    }
+
+    if (thread->parameters.counters != NULL) {
+      close_perf_counters(&thread->counters);
+    }
+
+    free(thread);
+    shared_data->threads[thread_number] = NULL;
+  }
+}
 
 /*
  * run_sched_thread
  *
- * The thread code for running the scheduler. Just expects a pointer
- * to the shared data for mutex and conditionals, the thread will then
- * wait until there's input from the user. If there is, try to read in
- * the file and get the scheduler results, putting them into the
- * output buffer for the parent thread to read.
+ * The thread code for running the scheduler. Expects a pointer to the
+ * shared data, and the number of the thread, which picks the scheduler
+ * from SCHEDULERS. Reads in each file of the batch and gets the
+ * scheduler results, putting them into the thread's output buffers for
+ * the parent thread to read. The files are done in the order given,
+ * as following traces depends on it. Schedulers that are fused are
+ * all run by the leader, see init_fused.
  */
-void *run_sched_thread(void *shared_data_in) {
+void run_sched_thread(void *shared_data_in, const int thread_number) {
   struct SharedData *const restrict shared_data = shared_data_in;
 
-  int thread_number;
-  Scheduler scheduler_to_run = setup_sched_thread(shared_data,
-                                                  &thread_number);
+  assert(thread_number < NUM_THREADS);
+
+  if (shared_data->threads[thread_number] == NULL) {
+    shared_data->threads[thread_number] =
+        new_sched_thread(shared_data, thread_number);
+  }
 
-  pthread_mutex_lock(&shared_data->input_mutex);
+  struct SchedThread *const thread = shared_data->threads[thread_number];
+  const Scheduler scheduler_to_run =
+      SCHEDULERS[thread_number].scheduler;
+  const char *const scheduler_name = SCHEDULERS[thread_number].name;
 
-  while (!shared_data->quit) {
-    while (!shared_data->input_ready && !shared_data->quit) {
-      pthread_cond_wait(&shared_data->input_cond, &shared_data->input_mutex);
+  if (is_fused(shared_data, thread_number)) {
+    // The rest of the fused threads have nothing to do.
+    if (thread_number == shared_data->fused_leader) {
+      run_fused(shared_data, thread);
     }
+  } else {
+    for (int i = 0; i < shared_data->total_filenames; ++i) {
+      struct SchedulerAverages averages;
 
-    if (!shared_data->quit) {
-      // We have some input. We can release the mutex on the input
-      // straight away, we only read it, and the main thread won't
-      // change it until it gets the result from us.
-      pthread_mutex_unlock(&shared_data->input_mutex);
+      if (shared_data->options.follow) {
+        averages = follow_scheduler(&thread->trace_state,
+                                    shared_data->filenames[i],
+                                    scheduler_to_run, &thread->parameters);
+      } else {
+        averages = cached_run_scheduler(&shared_data->result_cache,
+                                        shared_data->filenames[i],
+                                        scheduler_to_run, scheduler_name,
+                                        &thread->parameters);
+      }
 
-      struct SchedulerAverages averages =
-          run_scheduler(shared_data->input_buffer, scheduler_to_run);
+      write_result_to_buffer(shared_data, averages, thread_number, i);
 
-      // We do however, need to tell the input thread that we've got the input.
-      pthread_mutex_lock(&shared_data->scheduler_ready_mutex);
-      shared_data->schedulers_ready++;
+      if (shared_data->options.what_if.replicas > 0) {
+        add_what_if_to_buffer(shared_data, thread_number, i);
+      }
+    }
+  }
+}
 
-      pthread_cond_signal(&shared_data->scheduler_ready_cond);
-      pthread_mutex_unlock(&shared_data->scheduler_ready_mutex);
+/*
+ * run_fused
+ *
+ * Streams each file in the batch through all of the fused policies at
+ * once, on the leader thread. What if runs need the trace loaded, it's
+ * loaded once for all of the policies.
+ */
+static void run_fused(struct SharedData *const restrict shared_data,
+                      struct SchedThread *const restrict thread) {
+  const struct WhatIf *const what_if = &shared_data->options.what_if;
 
-      write_result_to_buffer(shared_data, averages, thread_number);
+  for (int i = 0; i < shared_data->total_filenames; ++i) {
+    cached_stream_schedulers(&shared_data->result_cache,
+                             shared_data->filenames[i],
+                             shared_data->fused_policies,
+                             shared_data->fused_names,
+                             shared_data->fused_count,
+                             &thread->parameters,
+                             shared_data->fused_averages[i]);
 
-      // Thread is done, wait for more input.
-      pthread_mutex_lock(&shared_data->input_mutex);
-    }
-  }
+    struct Trace trace;
+
+    if (what_if->replicas > 0) {
+      if (load_trace(shared_data->filenames[i], &trace)) {
+        for (int policy = 0; policy < shared_data->fused_count; ++policy) {
+          const struct StreamPolicy *const fused =
+              &shared_data->fused_policies[policy];
+          struct SchedulerParameters parameters = thread->parameters;
+          parameters.quantum = (fused->quantum > 0) ?
+              fused->quantum : trace.quantum;
 
-  pthread_mutex_unlock(&shared_data->input_mutex);
-  pthread_exit(NULL);
+          shared_data->fused_what_if[i][policy] =
+              what_if_trace(&trace, fused->scheduler, &parameters, what_if,
+                            what_if_threads(NUM_THREADS));
+        }
 
-  return NULL;
+        destroy_trace(&trace);
+      } else {
+        // Same as run_what_if, the error and a result of zero, rather
+        // than whatever an earlier file left behind.
+        perror("main() - File Error");
+
+        const struct WhatIfResult no_result = {0, 0.0, 0.0, 0.0, 0.0};
+
+        for (int policy = 0; policy < shared_data->fused_count; ++policy) {
+          shared_data->fused_what_if[i][policy] = no_result;
+        }
+      }
+    }
+  }
 }
 
 /*
- * setup_sched_thread
+ * new_sched_thread
  *
- * Takes a pointer to the shared mutexes and the current thread
- * number. Even numbered threads will run the SJF scheduler, others
- * will be the round robin scheduler.
+ * Allocates and sets up the state for the given scheduler thread, the
+ * thread itself calls this so it's first touched where it runs.
  */
-static Scheduler setup_sched_thread(struct SharedData *const restrict shared_data,
-                                    int *const restrict thread_number) {
-  pthread_mutex_lock(&shared_data->scheduler_ready_mutex);
-  *thread_number = shared_data->schedulers_ready;
-
-  Scheduler scheduler_to_run;
-  if ((shared_data->schedulers_ready++ % 2) != 0) {
-    scheduler_to_run = rr_scheduler;
-  } else {
-    scheduler_to_run = sjf_scheduler;
+static struct SchedThread *new_sched_thread(
+    const struct SharedData *const restrict shared_data,
+    const int thread_number) {
+  struct SchedThread *const thread = malloc(sizeof(struct SchedThread));
+  assert(thread != NULL);
+
+  thread->parameters = shared_data->options.parameters;
+
+  if (shared_data->timeline_file != NULL) {
+    init_timeline(&thread->timeline, shared_data->timeline_file,
+                  SCHEDULERS[thread_number].name);
+    thread->parameters.timeline = &thread->timeline;
   }
 
-  pthread_cond_signal(&shared_data->scheduler_ready_cond);
-  pthread_mutex_unlock(&shared_data->scheduler_ready_mutex);
+  if (shared_data->options.count_stages && !shared_data->options.follow) {
+    open_perf_counters(&thread->counters);
+    thread->parameters.counters = &thread->counters;
+  }
+
+  init_trace_state(&thread->trace_state);
 
-  return scheduler_to_run;
+  return thread;
 }
 
 /*
  * write_result_to_buffer
  *
- * Takes in a pointer to the mutexes, the calculated averages, and the
- * thread number of the scheduler thread that created the result.
- * Waits until it can write to the output buffer and will return when
- * it finally can.
+ * Takes in a pointer to the shared data, the calculated averages, the
+ * thread number of the scheduler thread that created the result, and
+ * which file in the batch it's for.
+ * Nobody else writes the thread's output buffer, and the parent
+ * thread doesn't read it until the batch is done.
  */
 static void write_result_to_buffer(struct SharedData *const restrict shared_data,
                                    struct SchedulerAverages averages,
-                                   const int thread_number) {
+                                   const int thread_number,
+                                   const int file_number) {
+  struct SchedThread *const thread = shared_data->threads[thread_number];
+  char *const buffer = thread->output_buffers[file_number];
 
-  pthread_mutex_lock(&shared_data->output_mutex);
+  const int length = format_results(buffer, OUTPUT_BUFFER_SIZE,
+                                    SCHEDULERS[thread_number].name,
+                                    &averages, shared_data->options.spread,
+                                    &shared_data->options.parameters);
 
-  // Make sure we haven't grabbed the mutex before the parent thread.
-  while (shared_data->output_ready) {
-    pthread_cond_wait(&shared_data->output_cond,
-                      &shared_data->output_mutex);
+  if (thread->parameters.counters != NULL && length < OUTPUT_BUFFER_SIZE) {
+    format_perf_counters(buffer + length, OUTPUT_BUFFER_SIZE - length,
+                         &thread->counters);
   }
+}
 
-  // Set the correct prefix for the scheduler output.
-  char *scheduler_type;
+/*
+ * add_what_if_to_buffer
+ *
+ * Runs the what if replicas of the file through the thread's
+ * scheduler, and adds the result to the end of its output buffer.
+ * The threads run at the same time, so each gets its share of the
+ * CPUs for its replicas.
+ */
+static void add_what_if_to_buffer(struct SharedData *const restrict shared_data,
+                                  const int thread_number,
+                                  const int file_number) {
+  struct SchedThread *const thread = shared_data->threads[thread_number];
+  char *const buffer = thread->output_buffers[file_number];
 
-  if (thread_number % 2 != 0) {
-    scheduler_type = RR_STR;
-  } else {
-    scheduler_type = SJF_STR;
+  const struct WhatIfResult result =
+      run_what_if(shared_data->filenames[file_number],
+                  SCHEDULERS[thread_number].scheduler, &thread->parameters,
+                  &shared_data->options.what_if,
+                  what_if_threads(NUM_THREADS));
+
+  const size_t length = strlen(buffer);
+  format_what_if(buffer + length, OUTPUT_BUFFER_SIZE - length, &result);
+}
+
+int format_results(char *const restrict buffer, const size_t size,
+                   const char *const restrict scheduler_name,
+                   const struct SchedulerAverages *const restrict averages,
+                   const bool spread,
+                   const struct SchedulerParameters *const restrict
+                   parameters) {
+  int length = snprintf(buffer, size,
+                        "%s:\t"
+                        "Average Waiting: %.2f. "
+                        "Average Turnaround: %.2f\n",
+                        scheduler_name,
+                        averages->waiting_time,
+                        averages->turnaround_time);
+
+  if (spread && length < (int) size) {
+    length += format_spread(buffer + length, size - length, averages);
+  }
+
+  if ((parameters->dispatch_cost != 0 || parameters->switch_cost != 0) &&
+      length < (int) size) {
+    length += format_overhead(buffer + length, size - length, averages);
   }
 
-  // We put our result string into the output buffer, and let the
-  // parent thread know.
-  sprintf(shared_data->output_buffer,
-          "%s:\t"
-          "Average Waiting: %.2f. "
-          "Average Turnaround: %.2f\n",
-          scheduler_type,
-          averages.waiting_time,
-          averages.turnaround_time);
-
-  shared_data->output_ready = true;
-  pthread_cond_broadcast(&shared_data->output_cond);
-  pthread_mutex_unlock(&shared_data->output_mutex);
+  return length;
 }
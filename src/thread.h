@@ -10,64 +10,162 @@
 #ifndef THREAD_H_
 #define THREAD_H_
 
-#include <pthread.h>
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "options.h"
+#include "perf_counters.h"
+#include "result_cache.h"
+#include "scheduler.h"
+#include "scheduler_table.h"
+#include "stream_scheduler.h"
+#include "timeline.h"
+#include "trace_loader.h"
 
 /*
- * Number of threads to run.
+ * Number of threads to run, one for each scheduler.
  */
-#define NUM_THREADS 2
+#define NUM_THREADS NUM_SCHEDULERS
 
 /*
- * Our shared data for our threads, this is to contain all the data
- * shared between threads.
+ * Size of the buffer the scheduler threads write their results to,
+ * with room for the counters on top.
+ */
+#define OUTPUT_BUFFER_SIZE (512 + PERF_REPORT_SIZE)
+
+/*
+ * Most filenames run in one batch, when the user gives them faster
+ * than they can be run. They're all read ahead together.
+ */
+#define INPUT_BATCH_SIZE TRACE_LOADER_BATCH_SIZE
+
+/*
+ * Most policies streamed together in one pass, every scheduler plus
+ * round robin at each of the extra quanta.
+ */
+#define MAX_FUSED (NUM_SCHEDULERS + MAX_EXTRA_QUANTA)
+
+/*
+ * SchedThread
+ *
+ * Everything that belongs to one scheduler thread. Each thread keeps
+ * its own copy of the parameters, so it can point them at its own
+ * timeline, and follows traces on its own, as they all run different
+ * schedulers. The result for each file in the batch goes in its
+ * output buffer, which the parent thread reads once the batch is done.
  *
- * The input mutex handles the input buffer, the parent thread is the
- * only one that writes to this buffer, so we only need the mutex to
- * signal when the parent has finished writing. Any number of
- * scheduler threads can read from the buffer at the same time without
- * any problems.
+ * Counters are for the thread they're opened on, so each thread opens
+ * its own if the stages are being counted.
  *
- * Scheduler threads are only to read from the input buffer when
- * input_ready is set to true.
+ * Each thread allocates its own the first time it runs, along with
+ * everything it allocates for each trace, so with the threads pinned
+ * it's all in memory close to the CPU that uses it.
+ */
+struct SchedThread {
+  struct SchedulerParameters parameters;
+  struct Timeline timeline;
+  struct TraceState trace_state;
+  struct PerfCounters counters;
+
+  char output_buffers[INPUT_BATCH_SIZE][OUTPUT_BUFFER_SIZE];
+};
+
+/*
+ * Our shared data for our threads, this is to contain all the data
+ * shared between threads.
  *
- * The input mutex also covers the quit variable, this is set to true
- * if the user wants to quit. Since quitting is based off if the user
- * typed QUIT as input, it's directly related to the input mutex as
- * well. Any scheduler threads should check the quit Boolean first.
+ * The threads run as a worker pool, with a batch for all the
+ * filenames the user has given since the last one. The parent thread
+ * is the only one that writes the filenames, and only between
+ * batches, so the scheduler threads can all read them during one
+ * without any locking. Each of them only
+ * writes its own SchedThread, NULL until its first batch.
  *
- * When a scheduler is done, it has to write its output to the output
- * buffer, however, we don't know if the parent thread is ready, or
- * reading the buffer. So the scheduler_finished_mutex is used.
+ * The options are set before any of the scheduler threads are
+ * started, and are only read after that. The result cache has its own
+ * mutex. Each scheduler thread keeps its own timeline, they only
+ * share the file, NULL if there's no timeline. The parent thread
+ * starts the loader reading the batch's files before the batch runs,
+ * and every thread parses them from there, unless traces are followed
+ * or streamed, when the loader isn't started.
  *
- * When a scheduler thread is ready, it will try to grab the scheduler
- * finished mutex, if it succeeds, then it will check the scheduler
- * ready variable. If true, then it will release the lock, otherwise
- * it will write to the output buffer and set the scheduler ready to
- * true.
+ * When traces are streamed, every scheduler that can be streamed, and
+ * round robin at each of the extra quanta, is run in a single pass by
+ * the fused leader thread, which is -1 when they aren't. The others
+ * that can be streamed have nothing to do. Their results go in
+ * fused_averages, in the order of fused_policies, along with any what
+ * if results in fused_what_if, for the parent thread to show with the
+ * leader's. Everything but the results is set before the threads
+ * start.
  */
 struct SharedData {
-  pthread_mutex_t input_mutex;
-  pthread_cond_t input_cond;
-  bool input_ready;
-  bool quit;
-
-  pthread_mutex_t scheduler_ready_mutex;
-  pthread_cond_t scheduler_ready_cond;
-  int schedulers_ready;
-  int total_sched_threads;
-
-  pthread_mutex_t output_mutex;
-  pthread_cond_t output_cond;
-  bool output_ready;
-
-  char *input_buffer;
-  char *output_buffer;
+  struct Options options;
+  struct ResultCache result_cache;
+  FILE *timeline_file;
+  struct TraceLoader loader;
+
+  int fused_leader;
+  struct StreamPolicy fused_policies[MAX_FUSED];
+  const char *fused_names[MAX_FUSED];
+  char quanta_names[MAX_EXTRA_QUANTA][RESULT_CACHE_NAME_SIZE];
+  int fused_count;
+  struct SchedulerAverages fused_averages[INPUT_BATCH_SIZE][MAX_FUSED];
+  struct WhatIfResult fused_what_if[INPUT_BATCH_SIZE][MAX_FUSED];
+
+  const char *filenames[INPUT_BATCH_SIZE];
+  int total_filenames;
+
+  struct SchedThread *threads[NUM_THREADS];
 };
 
 /*
- * Forward Declarations.
+ * Init fused
+ *
+ * Works out which thread leads the fused pass, and what it runs, from
+ * the options. Nothing is fused without streaming, or in follow mode,
+ * or with a timeline, which is for one scheduler at a time, or when
+ * the stages are counted, as they're only counted for loaded traces.
+ */
+void init_fused(struct SharedData *const restrict shared_data);
+
+/*
+ * Is fused
+ *
+ * True if the thread's scheduler is run in the fused pass.
+ */
+bool is_fused(const struct SharedData *const restrict shared_data,
+              const int thread_number);
+
+/*
+ * Destroy sched thread
+ *
+ * Frees the given scheduler thread's state, if it has any.
+ */
+void destroy_sched_thread(struct SharedData *const restrict shared_data,
+                          const int thread_number);
+
+/*
+ * Run sched thread
+ *
+ * The worker function for the scheduler threads, runs the thread's
+ * scheduler on each of the files in the batch, in order.
+ */
+void run_sched_thread(void *shared_data_in, const int thread_number);
+
+/*
+ * Format results
+ *
+ * Writes a scheduler's results into the buffer the way the simulator
+ * shows them, the averages, then the spread if it's wanted, then the
+ * overheads if there are any costs. Won't write more than size
+ * characters, returns the length of the full text like snprintf does.
  */
-void *run_sched_thread(void *shared_data_in);
+int format_results(char *const restrict buffer, const size_t size,
+                   const char *const restrict scheduler_name,
+                   const struct SchedulerAverages *const restrict averages,
+                   const bool spread,
+                   const struct SchedulerParameters *const restrict
+                   parameters);
 
 #endif
@@ -0,0 +1,86 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ */
+
+#include <assert.h>
+#include <stdlib.h>
+
+#include "timeline.h"
+
+FILE *open_timeline_file(const char *const restrict filename) {
+  FILE *const file = fopen(filename, "w");
+
+  if (file != NULL) {
+    fprintf(file, "run,scheduler,process,start,end\n");
+  }
+
+  return file;
+}
+
+void init_timeline(struct Timeline *const restrict timeline,
+                   FILE *const restrict file,
+                   const char *const restrict scheduler_name) {
+  assert(file != NULL);
+
+  timeline->file = file;
+  timeline->scheduler_name = scheduler_name;
+  timeline->run = 0;
+  timeline->first_process = 0;
+  timeline->used = 0;
+  timeline->buffer = malloc(TIMELINE_BUFFER_SIZE);
+
+  assert(timeline->buffer != NULL);
+}
+
+void destroy_timeline(struct Timeline *const restrict timeline) {
+  flush_timeline(timeline);
+  free(timeline->buffer);
+  timeline->buffer = NULL;
+}
+
+void start_timeline_run(struct Timeline *const restrict timeline) {
+  ++timeline->run;
+  timeline->first_process = 0;
+}
+
+/*
+ * add_timeline_slice
+ *
+ * Rows go straight into the buffer, there's always room for one as
+ * it's flushed once a row might not fit.
+ */
+void add_timeline_slice(struct Timeline *const restrict timeline,
+                        const int process,
+                        const long long start,
+                        const long long end) {
+  int length = snprintf(timeline->buffer + timeline->used, TIMELINE_ROW_SIZE,
+                        "%d,%s,%d,%lld,%lld\n",
+                        timeline->run,
+                        timeline->scheduler_name,
+                        timeline->first_process + process,
+                        start,
+                        end);
+
+  assert(length > 0 && length < TIMELINE_ROW_SIZE);
+  timeline->used += length;
+
+  if (timeline->used > TIMELINE_BUFFER_SIZE - TIMELINE_ROW_SIZE) {
+    flush_timeline(timeline);
+  }
+}
+
+/*
+ * flush_timeline
+ *
+ * A single fwrite, stdio locks the file for the call, so rows from
+ * other threads can't end up in the middle of ours.
+ */
+void flush_timeline(struct Timeline *const restrict timeline) {
+  if (timeline->used > 0) {
+    fwrite(timeline->buffer, 1, timeline->used, timeline->file);
+    fflush(timeline->file);
+    timeline->used = 0;
+  }
+}
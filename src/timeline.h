@@ -0,0 +1,109 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Optional record of which process had the CPU when, written out as
+ *   CSV so a schedule can be looked at in detail or drawn as a Gantt
+ *   chart.
+ */
+
+#ifndef TIMELINE_H_
+#define TIMELINE_H_
+
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Size of the buffer each timeline collects rows in before they're
+ * written to the file. This is all the memory a timeline uses, however
+ * long the trace is.
+ */
+#define TIMELINE_BUFFER_SIZE 65536
+
+/*
+ * Longest a single row can be, including the newline.
+ */
+#define TIMELINE_ROW_SIZE 128
+
+/*
+ * Timeline
+ *
+ * Rows are written to the file as:
+ *
+ *   <run>,<scheduler name>,<process>,<start>,<end>
+ *
+ * run - Counts the traces scheduled, starting at 1.
+ * process - Index of the process in the trace once it's sorted by
+ *           arrival time, starting at 0.
+ * start, end - When the process had the CPU, not counting any time
+ *              spent on dispatching or switching to it.
+ *
+ * Rows are only written a whole buffer at a time, so timelines for
+ * different schedulers can share a file, even from different threads.
+ * first_process is added to every process index, for when only the
+ * end of a trace is being scheduled.
+ */
+struct Timeline {
+  FILE *file;
+  const char *scheduler_name;
+  int run;
+  int first_process;
+  size_t used;
+  char *buffer;
+};
+
+/*
+ * Open timeline file
+ *
+ * Creates the file and writes the CSV header. Returns NULL if the file
+ * can't be created.
+ */
+FILE *open_timeline_file(const char *const restrict filename);
+
+/*
+ * Init timeline
+ *
+ * Sets up a timeline writing to a file from open_timeline_file.
+ * Nothing is kept of the name, it must outlive the timeline.
+ */
+void init_timeline(struct Timeline *const restrict timeline,
+                   FILE *const restrict file,
+                   const char *const restrict scheduler_name);
+
+/*
+ * Destroy timeline
+ *
+ * Writes out anything left in the buffer and frees it. The file is
+ * left open, it may be shared.
+ */
+void destroy_timeline(struct Timeline *const restrict timeline);
+
+/*
+ * Start timeline run
+ *
+ * Call before scheduling each trace, rows after this get the next run
+ * number.
+ */
+void start_timeline_run(struct Timeline *const restrict timeline);
+
+/*
+ * Add timeline slice
+ *
+ * Records that the process had the CPU from start until end.
+ */
+void add_timeline_slice(struct Timeline *const restrict timeline,
+                        const int process,
+                        const long long start,
+                        const long long end);
+
+/*
+ * Flush timeline
+ *
+ * Writes out any rows still in the buffer, call once a trace has
+ * been scheduled.
+ */
+void flush_timeline(struct Timeline *const restrict timeline);
+
+#endif
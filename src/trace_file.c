@@ -0,0 +1,454 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * A compressed trace is decompressed on a thread of its own, into one
+ * end of a socket pair, and the parser reads the other end like any
+ * other file. The socket's buffer is what the chunks are handed over
+ * in, so the decompressor runs ahead of the parser by that much, and
+ * waits when it's full. A socket rather than a pipe, so that if the
+ * parser stops early and closes its end, the decompressor gets an
+ * error from send rather than a SIGPIPE.
+ *
+ * Traces start with the quantum, so the first byte of a plain one is
+ * a digit or a space, never the first byte of either magic number.
+ * Only when it could be is any more read, that way a plain trace
+ * never needs more than the one byte put back, and can still come
+ * from a pipe.
+ *
+ * gzip needs zlib and zstd needs libzstd, the Makefile only defines
+ * HAVE_ZLIB and HAVE_ZSTD if they're there to build with.
+ */
+
+// For fmemopen, MSG_NOSIGNAL.
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#ifdef HAVE_ZLIB
+#include <zlib.h>
+#endif
+
+#ifdef HAVE_ZSTD
+#include <zstd.h>
+#endif
+
+#include "trace_file.h"
+
+#define MAGIC_SIZE 4
+
+enum Compression {
+  COMPRESSION_NONE,
+  COMPRESSION_GZIP,
+  COMPRESSION_ZSTD,
+  COMPRESSION_UNKNOWN
+};
+
+/*
+ * Decompressor
+ *
+ * Everything the decompressing thread needs, it owns raw and fd, and
+ * closes them when it's done. failed is only read once it's been
+ * joined.
+ *
+ * raw - The compressed trace, with the first magic_size bytes already
+ *       read into magic.
+ * fd - The socket the decompressed trace is sent down.
+ */
+struct Decompressor {
+  FILE *raw;
+  enum Compression compression;
+  unsigned char magic[MAGIC_SIZE];
+  size_t magic_size;
+  int fd;
+
+  pthread_t thread;
+  bool failed;
+};
+
+// Forward decs
+static bool open_raw(FILE *const restrict raw,
+                     struct TraceFile *const restrict trace_file);
+static enum Compression find_compression(const unsigned char *const
+                                         restrict magic,
+                                         const size_t size);
+static bool can_decompress(const enum Compression compression);
+static void *run_decompressor(void *decompressor_in);
+static bool send_chunk(const struct Decompressor *const restrict
+                       decompressor,
+                       const unsigned char *const restrict chunk,
+                       const size_t size);
+#ifdef HAVE_ZLIB
+static void inflate_trace(struct Decompressor *const restrict decompressor,
+                          unsigned char *const restrict in,
+                          unsigned char *const restrict out);
+#endif
+#ifdef HAVE_ZSTD
+static void unzstd_trace(struct Decompressor *const restrict decompressor,
+                         unsigned char *const restrict in,
+                         unsigned char *const restrict out);
+#endif
+
+bool open_trace_file(const char *const restrict filename,
+                     struct TraceFile *const restrict trace_file) {
+  FILE *const raw = fopen(filename, "r");
+
+  return raw != NULL && open_raw(raw, trace_file);
+}
+
+bool open_trace_buffer(const char *const restrict data, const size_t size,
+                       struct TraceFile *const restrict trace_file) {
+  bool result = false;
+
+  // Only opened for reading, so the data is never written. There's
+  // nothing to open for an empty trace, it has no quantum anyway.
+  if (size > 0) {
+    FILE *const raw = fmemopen((void *) data, size, "r");
+    result = raw != NULL && open_raw(raw, trace_file);
+  }
+
+  return result;
+}
+
+void close_trace_file(struct TraceFile *const restrict trace_file) {
+  fclose(trace_file->file);
+  trace_file->file = NULL;
+
+  // With our end closed, the decompressor stops at its next send.
+  if (trace_file->decompressor != NULL) {
+    struct Decompressor *const decompressor = trace_file->decompressor;
+
+    pthread_join(decompressor->thread, NULL);
+
+    if (decompressor->failed) {
+      fprintf(stderr, "Error, compressed trace is corrupt or cut short, "
+              "only read up to there.\n");
+    }
+
+    free(decompressor);
+    trace_file->decompressor = NULL;
+  }
+}
+
+/*
+ * open_raw
+ *
+ * Takes the opened trace, and either hands it straight back if it
+ * isn't compressed, or starts a decompressor on it. raw is closed if
+ * this fails.
+ */
+static bool open_raw(FILE *const restrict raw,
+                     struct TraceFile *const restrict trace_file) {
+  bool result = false;
+  unsigned char magic[MAGIC_SIZE];
+  size_t magic_size = 0;
+  enum Compression compression = COMPRESSION_NONE;
+
+  const int first = getc(raw);
+
+  if (first != EOF) {
+    magic[magic_size++] = (unsigned char) first;
+    compression = find_compression(magic, magic_size);
+  }
+
+  if (compression == COMPRESSION_NONE) {
+    if (first != EOF) {
+      ungetc(first, raw);
+    }
+
+    trace_file->file = raw;
+    trace_file->decompressor = NULL;
+    result = true;
+  } else {
+    magic_size += fread(magic + magic_size, 1, MAGIC_SIZE - magic_size, raw);
+    compression = find_compression(magic, magic_size);
+
+    int sockets[2];
+
+    if (compression == COMPRESSION_UNKNOWN) {
+      fprintf(stderr, "Error, trace starts like a compressed one, but "
+              "isn't gzip or zstd.\n");
+      errno = EINVAL;
+    } else if (!can_decompress(compression)) {
+      fprintf(stderr, "Error, trace is %s compressed, and this build "
+              "can't decompress it.\n",
+              (compression == COMPRESSION_GZIP) ? "gzip" : "zstd");
+      errno = ENOTSUP;
+    } else if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) == 0) {
+      trace_file->file = fdopen(sockets[0], "r");
+      assert(trace_file->file != NULL);
+
+      // Read a whole chunk at a time, rather than stdio's default.
+      setvbuf(trace_file->file, NULL, _IOFBF, TRACE_FILE_CHUNK_SIZE);
+
+      struct Decompressor *const decompressor =
+          malloc(sizeof(struct Decompressor));
+      assert(decompressor != NULL);
+
+      decompressor->raw = raw;
+      decompressor->compression = compression;
+      memcpy(decompressor->magic, magic, magic_size);
+      decompressor->magic_size = magic_size;
+      decompressor->fd = sockets[1];
+      decompressor->failed = false;
+
+      int error = pthread_create(&decompressor->thread, NULL,
+                                 &run_decompressor, decompressor);
+      assert(error == 0);
+      (void) error;
+
+      trace_file->decompressor = decompressor;
+      result = true;
+    }
+
+    if (!result) {
+      const int error = errno;
+      fclose(raw);
+      errno = error;
+    }
+  }
+
+  return result;
+}
+
+/*
+ * find_compression
+ *
+ * Which compression the trace's first bytes are the magic number of,
+ * given size of them, at least 1. With too few to be sure, whichever
+ * they're the start of. COMPRESSION_UNKNOWN if they start like one
+ * but aren't either.
+ */
+static enum Compression find_compression(const unsigned char *const
+                                         restrict magic,
+                                         const size_t size) {
+  static const unsigned char GZIP_MAGIC[] = { 0x1f, 0x8b };
+  static const unsigned char ZSTD_MAGIC[] = { 0x28, 0xb5, 0x2f, 0xfd };
+
+  // Only as much of each magic number as has been read is compared.
+  const size_t gzip_size = (size < sizeof(GZIP_MAGIC)) ?
+      size : sizeof(GZIP_MAGIC);
+  const size_t zstd_size = (size < sizeof(ZSTD_MAGIC)) ?
+      size : sizeof(ZSTD_MAGIC);
+
+  enum Compression result = COMPRESSION_UNKNOWN;
+
+  if (memcmp(magic, GZIP_MAGIC, gzip_size) == 0) {
+    result = COMPRESSION_GZIP;
+  } else if (memcmp(magic, ZSTD_MAGIC, zstd_size) == 0) {
+    result = COMPRESSION_ZSTD;
+  } else if (magic[0] != GZIP_MAGIC[0] && magic[0] != ZSTD_MAGIC[0]) {
+    result = COMPRESSION_NONE;
+  }
+
+  return result;
+}
+
+/*
+ * can_decompress
+ *
+ * True if this build has the library for the compression.
+ */
+static bool can_decompress(const enum Compression compression) {
+  bool result = false;
+
+#ifdef HAVE_ZLIB
+  result = result || compression == COMPRESSION_GZIP;
+#endif
+#ifdef HAVE_ZSTD
+  result = result || compression == COMPRESSION_ZSTD;
+#endif
+
+  (void) compression;
+
+  return result;
+}
+
+/*
+ * run_decompressor
+ *
+ * The decompressing thread, sends the whole trace down the socket
+ * decompressed, then closes it so the parser sees the end of the file.
+ * The magic number is the start of the first chunk.
+ */
+static void *run_decompressor(void *decompressor_in) {
+  struct Decompressor *const decompressor = decompressor_in;
+
+  unsigned char *const in = malloc(TRACE_FILE_CHUNK_SIZE);
+  unsigned char *const out = malloc(TRACE_FILE_CHUNK_SIZE);
+  assert(in != NULL);
+  assert(out != NULL);
+
+  switch (decompressor->compression) {
+#ifdef HAVE_ZLIB
+    case COMPRESSION_GZIP:
+      inflate_trace(decompressor, in, out);
+      break;
+#endif
+#ifdef HAVE_ZSTD
+    case COMPRESSION_ZSTD:
+      unzstd_trace(decompressor, in, out);
+      break;
+#endif
+    default:
+      decompressor->failed = true;
+  }
+
+  free(out);
+  free(in);
+
+  close(decompressor->fd);
+  fclose(decompressor->raw);
+
+  return NULL;
+}
+
+/*
+ * send_chunk
+ *
+ * Sends the decompressed chunk to the parser. Returns false if the
+ * parser has stopped reading, which isn't an error, there's just no
+ * point going on.
+ */
+static bool send_chunk(const struct Decompressor *const restrict
+                       decompressor,
+                       const unsigned char *const restrict chunk,
+                       const size_t size) {
+  size_t sent = 0;
+  bool result = true;
+
+  while (result && sent < size) {
+    const ssize_t sent_now = send(decompressor->fd, chunk + sent,
+                                  size - sent, MSG_NOSIGNAL);
+
+    if (sent_now > 0) {
+      sent += (size_t) sent_now;
+    } else if (sent_now < 0 && errno != EINTR) {
+      result = false;
+    }
+  }
+
+  return result;
+}
+
+#ifdef HAVE_ZLIB
+/*
+ * inflate_trace
+ *
+ * gzip files can be several members one after another, as if they'd
+ * been cat'ed together, each is decompressed in turn. It's only cut
+ * short if the file ends partway through one. A full output chunk can
+ * leave more to come out without any more going in, so more is only
+ * read once there's room left over.
+ */
+static void inflate_trace(struct Decompressor *const restrict decompressor,
+                          unsigned char *const restrict in,
+                          unsigned char *const restrict out) {
+  z_stream stream;
+  memset(&stream, 0, sizeof(stream));
+
+  // 16 on top of the window bits is for a gzip header.
+  bool going = (inflateInit2(&stream, 15 + 16) == Z_OK);
+  bool member_ended = false;
+  bool full = false;
+
+  memcpy(in, decompressor->magic, decompressor->magic_size);
+  stream.next_in = in;
+  stream.avail_in = (uInt) decompressor->magic_size;
+  decompressor->failed = !going;
+
+  while (going) {
+    if (stream.avail_in == 0 && !full) {
+      stream.next_in = in;
+      stream.avail_in = (uInt) fread(in, 1, TRACE_FILE_CHUNK_SIZE,
+                                     decompressor->raw);
+    }
+
+    if (stream.avail_in == 0 && !full) {
+      decompressor->failed = !member_ended;
+      going = false;
+    } else {
+      if (member_ended) {
+        inflateReset(&stream);
+        member_ended = false;
+      }
+
+      stream.next_out = out;
+      stream.avail_out = TRACE_FILE_CHUNK_SIZE;
+
+      const int result = inflate(&stream, Z_NO_FLUSH);
+      full = (stream.avail_out == 0);
+
+      if (result == Z_STREAM_END) {
+        member_ended = true;
+      } else if (result != Z_OK && result != Z_BUF_ERROR) {
+        // Z_BUF_ERROR is only that it needs more input.
+        decompressor->failed = true;
+        going = false;
+      }
+
+      going = send_chunk(decompressor, out,
+                         TRACE_FILE_CHUNK_SIZE - stream.avail_out) && going;
+    }
+  }
+
+  inflateEnd(&stream);
+}
+#endif
+
+#ifdef HAVE_ZSTD
+/*
+ * unzstd_trace
+ *
+ * zstd carries on through any number of frames by itself, and says
+ * how much more of the current one it's expecting, 0 once it's
+ * finished one. Anything else at the end of the file means it was cut
+ * short. Same as gzip, a full output chunk may have more to come.
+ */
+static void unzstd_trace(struct Decompressor *const restrict decompressor,
+                         unsigned char *const restrict in,
+                         unsigned char *const restrict out) {
+  ZSTD_DCtx *const context = ZSTD_createDCtx();
+  assert(context != NULL);
+
+  memcpy(in, decompressor->magic, decompressor->magic_size);
+  ZSTD_inBuffer input = { in, decompressor->magic_size, 0 };
+
+  bool going = true;
+  bool full = false;
+  size_t expecting = 1;
+
+  while (going) {
+    if (input.pos == input.size && !full) {
+      input.size = fread(in, 1, TRACE_FILE_CHUNK_SIZE, decompressor->raw);
+      input.pos = 0;
+    }
+
+    if (input.pos == input.size && !full) {
+      decompressor->failed = (expecting != 0);
+      going = false;
+    } else {
+      ZSTD_outBuffer output = { out, TRACE_FILE_CHUNK_SIZE, 0 };
+
+      expecting = ZSTD_decompressStream(context, &output, &input);
+      full = (output.pos == output.size);
+
+      if (ZSTD_isError(expecting)) {
+        decompressor->failed = true;
+        going = false;
+      }
+
+      going = send_chunk(decompressor, out, output.pos) && going;
+    }
+  }
+
+  ZSTD_freeDCtx(context);
+}
+#endif
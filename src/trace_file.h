@@ -0,0 +1,68 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Opens traces for reading, decompressing them on the way in if
+ *   they're gzip or zstd compressed, so archived traces can be
+ *   scheduled as they are.
+ */
+
+#ifndef TRACE_FILE_H_
+#define TRACE_FILE_H_
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+/*
+ * Size of each chunk a compressed trace is read and decompressed in.
+ */
+#define TRACE_FILE_CHUNK_SIZE 65536
+
+/*
+ * TraceFile
+ *
+ * file - Where to read the trace from, decompressed, with the usual
+ *        stdio functions.
+ * decompressor - The thread decompressing the trace into file, NULL
+ *                if it isn't compressed and file is the trace itself.
+ */
+struct TraceFile {
+  FILE *file;
+  struct Decompressor *decompressor;
+};
+
+/*
+ * Open trace file
+ *
+ * Opens the named trace. A compressed trace is found by its first
+ * bytes, not its name, and is decompressed a chunk at a time on a
+ * thread of its own as it's read, the whole of it is never in memory
+ * at once. Returns false with errno set if it can't be opened, or
+ * it's compressed in a way this build can't read.
+ */
+bool open_trace_file(const char *const restrict filename,
+                     struct TraceFile *const restrict trace_file);
+
+/*
+ * Open trace buffer
+ *
+ * Same as open_trace_file, for a trace that's already in memory, size
+ * bytes of it at data, which has to stay there until it's closed.
+ */
+bool open_trace_buffer(const char *const restrict data, const size_t size,
+                       struct TraceFile *const restrict trace_file);
+
+/*
+ * Close trace file
+ *
+ * Closes the trace, whether or not it's all been read, and waits for
+ * its decompressor to stop. If the compressed data turned out to be
+ * corrupt, or cut short, the user is told the trace was only read up
+ * to there.
+ */
+void close_trace_file(struct TraceFile *const restrict trace_file);
+
+#endif
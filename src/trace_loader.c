@@ -0,0 +1,244 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Each reader has one read going at a time, so there are as many in
+ * flight as there are readers. The files are small, it's the opening
+ * and waiting on each that takes the time, not the copying, so they're
+ * read whole with pread into a buffer sized from fstat, and grown if
+ * the file turns out to be longer.
+ *
+ * The files are handed out in batch order, and waited on in the same
+ * order by whoever parses them, so the first file is usually read by
+ * the time it's wanted, and the rest are read while it's parsed.
+ */
+
+// For pread and strdup.
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "trace_loader.h"
+
+// Forward decs
+static void *run_reader(void *loader_in);
+static void free_traces(struct TraceLoader *const restrict loader);
+static void read_whole_file(struct LoadedTrace *const restrict trace);
+
+void init_trace_loader(struct TraceLoader *const restrict loader) {
+  pthread_mutex_init(&loader->mutex, NULL);
+  pthread_cond_init(&loader->work, NULL);
+  pthread_cond_init(&loader->loaded, NULL);
+
+  loader->total_traces = 0;
+  loader->next_trace = 0;
+  loader->quit = false;
+
+  for (int i = 0; i < TRACE_LOADER_THREADS; i++) {
+    int error = pthread_create(&loader->threads[i], NULL, &run_reader,
+                               loader);
+    assert(error == 0);
+    (void) error;
+  }
+}
+
+void destroy_trace_loader(struct TraceLoader *const restrict loader) {
+  pthread_mutex_lock(&loader->mutex);
+  loader->quit = true;
+  pthread_cond_broadcast(&loader->work);
+  pthread_mutex_unlock(&loader->mutex);
+
+  for (int i = 0; i < TRACE_LOADER_THREADS; i++) {
+    pthread_join(loader->threads[i], NULL);
+  }
+
+  free_traces(loader);
+
+  pthread_cond_destroy(&loader->loaded);
+  pthread_cond_destroy(&loader->work);
+  pthread_mutex_destroy(&loader->mutex);
+}
+
+void load_traces(struct TraceLoader *const restrict loader,
+                 const char *const *const restrict filenames,
+                 const int count) {
+  assert(count <= TRACE_LOADER_BATCH_SIZE);
+
+  pthread_mutex_lock(&loader->mutex);
+
+  // Nobody can be using the last batch, but if it wasn't all wanted
+  // there can be files left to read, which are dropped, or that a
+  // reader is still reading, which it has to finish first.
+  while (loader->next_trace < loader->total_traces) {
+    loader->traces[loader->next_trace++].done = true;
+  }
+
+  bool reading = true;
+
+  while (reading) {
+    reading = false;
+
+    for (int i = 0; i < loader->total_traces; i++) {
+      reading = reading || !loader->traces[i].done;
+    }
+
+    if (reading) {
+      pthread_cond_wait(&loader->loaded, &loader->mutex);
+    }
+  }
+
+  free_traces(loader);
+
+  for (int i = 0; i < count; i++) {
+    struct LoadedTrace *const trace = &loader->traces[i];
+
+    trace->filename = strdup(filenames[i]);
+    assert(trace->filename != NULL);
+    trace->data = NULL;
+    trace->size = 0;
+    trace->error = 0;
+    trace->done = false;
+  }
+
+  loader->total_traces = count;
+  loader->next_trace = 0;
+
+  pthread_cond_broadcast(&loader->work);
+  pthread_mutex_unlock(&loader->mutex);
+}
+
+bool find_loaded_trace(struct TraceLoader *const restrict loader,
+                       const char *const restrict filename,
+                       const struct LoadedTrace **const restrict trace) {
+  struct LoadedTrace *found = NULL;
+
+  pthread_mutex_lock(&loader->mutex);
+
+  for (int i = 0; i < loader->total_traces && found == NULL; i++) {
+    if (strcmp(loader->traces[i].filename, filename) == 0) {
+      found = &loader->traces[i];
+    }
+  }
+
+  if (found != NULL) {
+    while (!found->done) {
+      pthread_cond_wait(&loader->loaded, &loader->mutex);
+    }
+
+    *trace = found;
+  }
+
+  pthread_mutex_unlock(&loader->mutex);
+
+  return found != NULL;
+}
+
+/*
+ * run_reader
+ *
+ * The reader threads, take the next file nobody has started, read it
+ * without holding the mutex, and let everyone waiting know, until
+ * it's time to quit.
+ */
+static void *run_reader(void *loader_in) {
+  struct TraceLoader *const loader = loader_in;
+
+  pthread_mutex_lock(&loader->mutex);
+
+  while (!loader->quit) {
+    if (loader->next_trace < loader->total_traces) {
+      struct LoadedTrace *const trace =
+          &loader->traces[loader->next_trace++];
+
+      pthread_mutex_unlock(&loader->mutex);
+      read_whole_file(trace);
+      pthread_mutex_lock(&loader->mutex);
+
+      trace->done = true;
+      pthread_cond_broadcast(&loader->loaded);
+    } else {
+      pthread_cond_wait(&loader->work, &loader->mutex);
+    }
+  }
+
+  pthread_mutex_unlock(&loader->mutex);
+
+  return NULL;
+}
+
+/*
+ * free_traces
+ *
+ * Frees the name and data of every file in the batch. Expects that none of
+ * them are still being read.
+ */
+static void free_traces(struct TraceLoader *const restrict loader) {
+  for (int i = 0; i < loader->total_traces; i++) {
+    free(loader->traces[i].filename);
+    free(loader->traces[i].data);
+    loader->traces[i].filename = NULL;
+    loader->traces[i].data = NULL;
+  }
+
+  loader->total_traces = 0;
+  loader->next_trace = 0;
+}
+
+/*
+ * read_whole_file
+ *
+ * Reads the file into a new buffer in the trace, or sets its error if
+ * it can't be. Called without the mutex, only the reader that took
+ * the trace touches it until it's done.
+ */
+static void read_whole_file(struct LoadedTrace *const restrict trace) {
+  const int fd = open(trace->filename, O_RDONLY);
+
+  if (fd < 0) {
+    trace->error = errno;
+  } else {
+    struct stat file_stat;
+    size_t capacity = 4096;
+
+    if (fstat(fd, &file_stat) == 0 && file_stat.st_size > 0) {
+      // One more than the size, so the end of the file is found in
+      // the first go without growing.
+      capacity = (size_t) file_stat.st_size + 1;
+    }
+
+    trace->data = malloc(capacity);
+    assert(trace->data != NULL);
+
+    bool reading = true;
+
+    while (reading) {
+      if (trace->size == capacity) {
+        capacity *= 2;
+        trace->data = realloc(trace->data, capacity);
+        assert(trace->data != NULL);
+      }
+
+      const ssize_t read_size = pread(fd, trace->data + trace->size,
+                                      capacity - trace->size,
+                                      (off_t) trace->size);
+
+      if (read_size > 0) {
+        trace->size += (size_t) read_size;
+      } else if (read_size == 0) {
+        reading = false;
+      } else if (errno != EINTR) {
+        trace->error = errno;
+        reading = false;
+      }
+    }
+
+    close(fd);
+  }
+}
@@ -0,0 +1,105 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   Reads a batch of trace files into memory on threads of its own,
+ *   with several reads going at once, so a batch of small traces can
+ *   be parsed as each one comes in rather than opening and reading
+ *   them one after another.
+ */
+
+#ifndef TRACE_LOADER_H_
+#define TRACE_LOADER_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+
+/*
+ * Most files read in one batch.
+ */
+#define TRACE_LOADER_BATCH_SIZE 32
+
+/*
+ * How many files are read at once.
+ */
+#define TRACE_LOADER_THREADS 8
+
+/*
+ * LoadedTrace
+ *
+ * A file in the batch, its whole contents in data, once done is set.
+ * error is the errno it couldn't be read with, 0 if it could.
+ */
+struct LoadedTrace {
+  char *filename;
+  char *data;
+  size_t size;
+  int error;
+  bool done;
+};
+
+/*
+ * TraceLoader
+ *
+ * The reader threads take the next file in the batch that nobody has
+ * started on, and wake anyone waiting for it once it's read. The
+ * mutex covers everything but the threads, the reads themselves are
+ * done without it.
+ */
+struct TraceLoader {
+  pthread_t threads[TRACE_LOADER_THREADS];
+
+  pthread_mutex_t mutex;
+  pthread_cond_t work;
+  pthread_cond_t loaded;
+
+  struct LoadedTrace traces[TRACE_LOADER_BATCH_SIZE];
+  int total_traces;
+  int next_trace;
+  bool quit;
+};
+
+/*
+ * Init trace loader
+ *
+ * Starts the reader threads, they wait for the first batch.
+ */
+void init_trace_loader(struct TraceLoader *const restrict loader);
+
+/*
+ * Destroy trace loader
+ *
+ * Stops the reader threads, once they've finished any file they're
+ * reading, and frees the last batch.
+ */
+void destroy_trace_loader(struct TraceLoader *const restrict loader);
+
+/*
+ * Load traces
+ *
+ * Starts reading the files in the background, and returns straight
+ * away. The last batch is freed, so nobody can still be using it. The
+ * filenames are copied, as a file whose results come from the cache
+ * is never waited on, and can still be being read after the caller
+ * has moved on.
+ */
+void load_traces(struct TraceLoader *const restrict loader,
+                 const char *const *const restrict filenames,
+                 const int count);
+
+/*
+ * Find loaded trace
+ *
+ * If the file is in the batch, waits until it's been read, sets trace
+ * to it and returns true. Returns false straight away if it isn't.
+ * The trace is only read from, so any number of threads can use it
+ * at once, until the next batch.
+ */
+bool find_loaded_trace(struct TraceLoader *const restrict loader,
+                       const char *const restrict filename,
+                       const struct LoadedTrace **const restrict trace);
+
+#endif
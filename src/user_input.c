@@ -4,31 +4,169 @@
  * Author: Mike Aldred
  */
 
-#include <stdio.h>
+// For strcasecmp and strncasecmp.
+#define _POSIX_C_SOURCE 200809L
+
+#include <assert.h>
+#include <errno.h>
+#include <stdlib.h>
 #include <string.h>
 #include <strings.h>
+#include <unistd.h>
 
 #include "user_input.h"
 
 /*
- * file_from_user
+ * How much to read at once, and the smallest the buffer ever is.
+ */
+#define READ_SIZE 65536
+
+// Forward decs
+static bool read_more(struct UserInput *const restrict input);
+
+void init_user_input(struct UserInput *const restrict input, const int fd) {
+  input->fd = fd;
+  input->capacity = READ_SIZE + 1;
+  input->buffer = malloc(input->capacity);
+  assert(input->buffer != NULL);
+
+  input->start = 0;
+  input->used = 0;
+  input->finished = false;
+}
+
+void destroy_user_input(struct UserInput *const restrict input) {
+  free(input->buffer);
+  input->buffer = NULL;
+  input->capacity = 0;
+  input->start = 0;
+  input->used = 0;
+  input->finished = true;
+}
+
+/*
+ * next_filename
  *
- * Will get a string from the user for the filename. Will not be
- * longer than size.
+ * Lines are ended in the buffer where they are, so nothing is copied.
+ * A last line without a newline still counts.
  */
-bool file_from_user(char *const restrict filename, const size_t size) {
-  bool result = true;
-
-  if (fgets(filename, size - 1, stdin)) {
-    // Remove the trailing newline, it's annoying.
-    size_t length = strlen(filename) - 1;
-    if (filename[length] == '\n') {
-      filename[length] = '\0';
+const char *next_filename(struct UserInput *const restrict input) {
+  const char *filename = NULL;
+
+  while (filename == NULL && !input->finished) {
+    char *const line = input->buffer + input->start;
+    char *end = memchr(line, '\n', input->used - input->start);
+
+    if (end == NULL && !read_more(input)) {
+      // Input's ended, whatever is left is the last line.
+      if (input->start < input->used) {
+        end = input->buffer + input->used;
+        input->used = input->start;
+      }
+      input->finished = true;
     }
 
-    // Not standard C, but POSIX.
-    result = (strncasecmp(filename, USER_QUIT_STRING, size) != 0);
+    if (end != NULL) {
+      const char *const next_line = end + 1;
+      char *const text = input->buffer + input->start;
+
+      // The buffer always has room for this, see read_more.
+      *end = '\0';
+      if (end > text && end[-1] == '\r') {
+        end[-1] = '\0';
+      }
+
+      if (input->finished) {
+        input->start = input->used;
+      } else {
+        input->start = next_line - input->buffer;
+      }
+
+      if (strcasecmp(text, USER_QUIT_STRING) == 0) {
+        input->finished = true;
+      } else if (text[0] != '\0') {
+        filename = text;
+      }
+    }
+  }
+
+  return filename;
+}
+
+/*
+ * filename_waiting
+ *
+ * Blank lines are looked past, next_filename would skip them too, but
+ * QUIT or a line that isn't whole yet means it would have to stop or
+ * wait, and read_more moves the buffer, so filenames already returned
+ * would be lost.
+ */
+bool filename_waiting(const struct UserInput *const restrict input) {
+  bool result = false;
+  bool looking = !input->finished;
+  const char *line = input->buffer + input->start;
+  const char *const used_end = input->buffer + input->used;
+
+  while (looking) {
+    const char *const end = memchr(line, '\n', used_end - line);
+
+    if (end == NULL) {
+      looking = false;
+    } else {
+      size_t length = end - line;
+
+      if (length > 0 && line[length - 1] == '\r') {
+        --length;
+      }
+
+      if (length == strlen(USER_QUIT_STRING) &&
+          strncasecmp(line, USER_QUIT_STRING, length) == 0) {
+        looking = false;
+      } else if (length > 0) {
+        result = true;
+        looking = false;
+      }
+
+      line = end + 1;
+    }
   }
 
   return result;
 }
+
+/*
+ * read_more
+ *
+ * Reads whatever is there, waiting for something if there's nothing.
+ * Moves the line being read to the front of the buffer first, and
+ * grows it if that line already fills it. There's always a byte spare
+ * past what's used, so a last line without a newline can be ended.
+ * Returns false once the input has ended.
+ */
+static bool read_more(struct UserInput *const restrict input) {
+  const size_t pending = input->used - input->start;
+
+  if (pending > 0 && input->start > 0) {
+    memmove(input->buffer, input->buffer + input->start, pending);
+  }
+  input->start = 0;
+  input->used = pending;
+
+  if (input->capacity - input->used < READ_SIZE + 1) {
+    input->capacity = input->used + READ_SIZE + 1;
+    input->buffer = realloc(input->buffer, input->capacity);
+    assert(input->buffer != NULL);
+  }
+
+  ssize_t length;
+
+  do {
+    length = read(input->fd, input->buffer + input->used, READ_SIZE);
+  } while (length < 0 && errno == EINTR);
+
+  if (length > 0) {
+    input->used += length;
+  }
+
+  return length > 0;
+}
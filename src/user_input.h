@@ -3,7 +3,7 @@
  *
  * Author: Mike Aldred
  *
- * For reading a single string in from the user.
+ * For reading filenames in from the user, one to a line.
  */
 
 #ifndef USER_INPUT_H_
@@ -15,13 +15,62 @@
 #define USER_QUIT_STRING "QUIT"
 
 /*
- * File from user
+ * UserInput
  *
- * Takes a pointer to a buffer and the max size of that buffer. Will
- * prompt the user and place the input into the buffer and return
- * true. If the user enters in QUIT, then it will return false, don't
- * rely on the contents of the buffer.
+ * Input is read straight from the file descriptor, as much as is
+ * there each time, so when filenames are piped in a whole lot of them
+ * turn up at once. buffer holds what has been read, from start up to
+ * used. It only grows to fit the longest line, so a filename can be
+ * any length.
+ *
+ * finished is set once the input has ended, or the user entered QUIT.
+ */
+struct UserInput {
+  int fd;
+
+  char *buffer;
+  size_t capacity;
+  size_t start;
+  size_t used;
+
+  bool finished;
+};
+
+/*
+ * Init user input
+ *
+ * Sets up to read filenames from the given file descriptor.
+ */
+void init_user_input(struct UserInput *const restrict input, const int fd);
+
+/*
+ * Destroy user input
+ *
+ * Frees the buffer, anything returned by next_filename is gone.
+ */
+void destroy_user_input(struct UserInput *const restrict input);
+
+/*
+ * Next filename
+ *
+ * Returns the next filename, waiting for the user to enter one if
+ * needed. Blank lines are skipped. Returns NULL once the input ends,
+ * or the user enters QUIT.
+ *
+ * The filename stays valid until the next call that has to wait, as
+ * waiting moves the buffer, so while filename_waiting is true any
+ * number can be taken and used together.
+ */
+const char *next_filename(struct UserInput *const restrict input);
+
+/*
+ * Filename waiting
+ *
+ * True if next_filename can return a filename without waiting,
+ * because there's a whole line with one on already read in, and no
+ * QUIT before it. Only while this is true are filenames already
+ * returned kept as they are.
  */
-bool file_from_user(char *const restrict filename, const size_t size);
+bool filename_waiting(const struct UserInput *const restrict input);
 
 #endif
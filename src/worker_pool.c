@@ -0,0 +1,234 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * The counters shared between threads use the GCC atomic builtins,
+ * all sequentially consistent. Each side of a wake up sets its own
+ * flag then checks the other's, which needs that ordering so at least
+ * one of them sees the other.
+ */
+
+// For sysconf, and the CPU affinity calls.
+#define _GNU_SOURCE
+
+#include <assert.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "worker_pool.h"
+
+/*
+ * WorkerStart
+ *
+ * What a worker thread needs to get going, its number has to be
+ * handed over separately from the pool they all share.
+ */
+struct WorkerStart {
+  struct WorkerPool *pool;
+  int worker;
+};
+
+// Forward decs
+static void *run_worker(void *start_in);
+static bool batch_waiting(struct WorkerPool *const restrict pool,
+                          const unsigned long last_batch);
+static unsigned long wait_for_batch(struct WorkerPool *const restrict pool,
+                                    const unsigned long last_batch);
+static void finish_work(struct WorkerPool *const restrict pool);
+
+void init_worker_pool(struct WorkerPool *const restrict pool,
+                      const int total_workers,
+                      const WorkerFunction work,
+                      void *const context) {
+  pool->total_workers = total_workers;
+  pool->spins = (sysconf(_SC_NPROCESSORS_ONLN) > 1) ? WORKER_POOL_SPINS : 0;
+  pool->work = work;
+  pool->context = context;
+
+  pool->batch = 0;
+  pool->pending = 0;
+  pool->quit = false;
+
+  pthread_mutex_init(&pool->mutex, NULL);
+  pthread_cond_init(&pool->start, NULL);
+  pthread_cond_init(&pool->finished, NULL);
+  pool->sleeping_workers = 0;
+  pool->runner_sleeping = false;
+
+  pool->threads = malloc(sizeof(pthread_t) * total_workers);
+  assert(pool->threads != NULL);
+
+  for (int i = 0; i < total_workers; i++) {
+    struct WorkerStart *const start = malloc(sizeof(struct WorkerStart));
+    assert(start != NULL);
+
+    start->pool = pool;
+    start->worker = i;
+
+    int error = pthread_create(&pool->threads[i], NULL, &run_worker, start);
+    assert(error == 0);
+    (void) error;
+  }
+}
+
+bool pin_worker_pool(struct WorkerPool *const restrict pool) {
+  bool result = false;
+
+#ifdef __linux__
+  cpu_set_t allowed;
+
+  if (sched_getaffinity(0, sizeof(allowed), &allowed) == 0) {
+    int cpus[CPU_SETSIZE];
+    int total_cpus = 0;
+
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+      if (CPU_ISSET(cpu, &allowed)) {
+        cpus[total_cpus++] = cpu;
+      }
+    }
+
+    result = (total_cpus > 0);
+
+    for (int i = 0; i < pool->total_workers && result; i++) {
+      cpu_set_t worker_cpu;
+      CPU_ZERO(&worker_cpu);
+      CPU_SET(cpus[(long long) i * total_cpus / pool->total_workers],
+              &worker_cpu);
+
+      result = (pthread_setaffinity_np(pool->threads[i], sizeof(worker_cpu),
+                                       &worker_cpu) == 0);
+    }
+  }
+#endif
+
+  return result;
+}
+
+void destroy_worker_pool(struct WorkerPool *const restrict pool) {
+  __atomic_store_n(&pool->quit, true, __ATOMIC_SEQ_CST);
+
+  pthread_mutex_lock(&pool->mutex);
+  pthread_cond_broadcast(&pool->start);
+  pthread_mutex_unlock(&pool->mutex);
+
+  for (int i = 0; i < pool->total_workers; i++) {
+    pthread_join(pool->threads[i], NULL);
+  }
+
+  free(pool->threads);
+  pool->threads = NULL;
+
+  pthread_cond_destroy(&pool->finished);
+  pthread_cond_destroy(&pool->start);
+  pthread_mutex_destroy(&pool->mutex);
+}
+
+void run_batch(struct WorkerPool *const restrict pool) {
+  __atomic_store_n(&pool->pending, pool->total_workers, __ATOMIC_SEQ_CST);
+  __atomic_add_fetch(&pool->batch, 1, __ATOMIC_SEQ_CST);
+
+  if (__atomic_load_n(&pool->sleeping_workers, __ATOMIC_SEQ_CST) > 0) {
+    pthread_mutex_lock(&pool->mutex);
+    pthread_cond_broadcast(&pool->start);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+
+  for (int i = 0;
+       i < pool->spins &&
+       __atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0;
+       i++) {
+    // Keep checking.
+  }
+
+  if (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0) {
+    pthread_mutex_lock(&pool->mutex);
+    __atomic_store_n(&pool->runner_sleeping, true, __ATOMIC_SEQ_CST);
+
+    while (__atomic_load_n(&pool->pending, __ATOMIC_SEQ_CST) > 0) {
+      pthread_cond_wait(&pool->finished, &pool->mutex);
+    }
+
+    __atomic_store_n(&pool->runner_sleeping, false, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+}
+
+/*
+ * run_worker
+ *
+ * The worker thread, waits for a batch it hasn't done yet, does its
+ * part, and goes back to waiting until the pool is destroyed.
+ */
+static void *run_worker(void *start_in) {
+  struct WorkerStart *const start = start_in;
+  struct WorkerPool *const pool = start->pool;
+  const int worker = start->worker;
+
+  free(start);
+
+  unsigned long last_batch = wait_for_batch(pool, 0);
+
+  while (!__atomic_load_n(&pool->quit, __ATOMIC_SEQ_CST)) {
+    (*pool->work)(pool->context, worker);
+    finish_work(pool);
+
+    last_batch = wait_for_batch(pool, last_batch);
+  }
+
+  return NULL;
+}
+
+/*
+ * batch_waiting
+ *
+ * True if there's a batch after last_batch, or it's time to quit.
+ */
+static bool batch_waiting(struct WorkerPool *const restrict pool,
+                          const unsigned long last_batch) {
+  return __atomic_load_n(&pool->batch, __ATOMIC_SEQ_CST) != last_batch ||
+      __atomic_load_n(&pool->quit, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * wait_for_batch
+ *
+ * Returns once there's a batch after last_batch, with its number, or
+ * once it's time to quit.
+ */
+static unsigned long wait_for_batch(struct WorkerPool *const restrict pool,
+                                    const unsigned long last_batch) {
+  for (int i = 0; i < pool->spins && !batch_waiting(pool, last_batch); i++) {
+    // Keep checking.
+  }
+
+  if (!batch_waiting(pool, last_batch)) {
+    pthread_mutex_lock(&pool->mutex);
+    __atomic_add_fetch(&pool->sleeping_workers, 1, __ATOMIC_SEQ_CST);
+
+    while (!batch_waiting(pool, last_batch)) {
+      pthread_cond_wait(&pool->start, &pool->mutex);
+    }
+
+    __atomic_sub_fetch(&pool->sleeping_workers, 1, __ATOMIC_SEQ_CST);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+
+  return __atomic_load_n(&pool->batch, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * finish_work
+ *
+ * The worker has done its part of the batch. If it's the last, and
+ * the thread running the batch has gone to sleep, wake it.
+ */
+static void finish_work(struct WorkerPool *const restrict pool) {
+  if (__atomic_sub_fetch(&pool->pending, 1, __ATOMIC_SEQ_CST) == 0 &&
+      __atomic_load_n(&pool->runner_sleeping, __ATOMIC_SEQ_CST)) {
+    pthread_mutex_lock(&pool->mutex);
+    pthread_cond_signal(&pool->finished);
+    pthread_mutex_unlock(&pool->mutex);
+  }
+}
@@ -0,0 +1,113 @@
+/*
+ * OS200 - Assignment
+ *
+ * Author: Mike Aldred
+ *
+ * Description:
+ *   A fixed set of threads that all do their part of a batch of work
+ *   together, then wait for the next batch.
+ */
+
+#ifndef WORKER_POOL_H_
+#define WORKER_POOL_H_
+
+#include <pthread.h>
+#include <stdbool.h>
+
+/*
+ * What each worker does for a batch. Workers are numbered from 0, and
+ * keep the same number for as long as the pool is running.
+ */
+typedef void (*WorkerFunction)(void *context, const int worker);
+
+/*
+ * How many times a thread waiting on the pool checks whether it can
+ * go before it gives up and sleeps. Long enough to cover a batch of
+ * small traces, short enough not to matter when the user is typing.
+ */
+#define WORKER_POOL_SPINS 20000
+
+/*
+ * WorkerPool
+ *
+ * Handing over a batch is done with counters rather than locks. The
+ * thread running the batch sets pending to the number of workers and
+ * moves batch on, each worker notices batch has changed, does its
+ * part, and takes one off pending. Whoever waits checks the counter
+ * it's waiting on for a while first, and only sleeps on the mutex and
+ * condition if that doesn't get it anywhere. Nobody is woken unless
+ * they're asleep, so when the threads are kept busy a batch costs no
+ * system calls at all.
+ *
+ * On a single CPU nothing can change while a thread is checking, so
+ * there spins is 0 and they sleep straight away.
+ *
+ * batch, pending, quit, sleeping_workers and runner_sleeping are only
+ * used through atomics. The mutex is only held to sleep, or to wake
+ * those that are, so nobody can miss a wake up. Anything the batch
+ * needs can be set up before run_batch without locking, and anything
+ * the workers leave is there to be read once it returns.
+ */
+struct WorkerPool {
+  pthread_t *threads;
+  int total_workers;
+  int spins;
+
+  WorkerFunction work;
+  void *context;
+
+  unsigned long batch;
+  int pending;
+  bool quit;
+
+  pthread_mutex_t mutex;
+  pthread_cond_t start;
+  pthread_cond_t finished;
+  int sleeping_workers;
+  bool runner_sleeping;
+};
+
+/*
+ * Init worker pool
+ *
+ * Starts the workers, they wait for the first batch.
+ *
+ * pool - Pool to set up.
+ * total_workers - How many threads to start.
+ * work - What each of them does for a batch.
+ * context - Passed to work, shared by all the workers.
+ */
+void init_worker_pool(struct WorkerPool *const restrict pool,
+                      const int total_workers,
+                      const WorkerFunction work,
+                      void *const context);
+
+/*
+ * Pin worker pool
+ *
+ * Keeps each worker on one CPU from those the process is allowed to
+ * use, spread evenly over them, so workers that share a CPU are only
+ * those there weren't enough CPUs for. Should be done before the first
+ * batch, so anything the workers allocate is in memory close to where
+ * they'll stay. Returns false if the workers couldn't be pinned, they
+ * can still be used, wherever they are.
+ */
+bool pin_worker_pool(struct WorkerPool *const restrict pool);
+
+/*
+ * Destroy worker pool
+ *
+ * Tells the workers to finish, and waits for them to. Must not be
+ * called while a batch is running.
+ */
+void destroy_worker_pool(struct WorkerPool *const restrict pool);
+
+/*
+ * Run batch
+ *
+ * Has every worker call the work function once, and returns when they
+ * all have. Only one thread can run batches on a pool.
+ */
+void run_batch(struct WorkerPool *const restrict pool);
+
+#endif
@@ -0,0 +1,442 @@
+#!/bin/sh
+#
+# OS200 - Assignment
+#
+# Author: Mike Aldred
+#
+# Differential tests, run by make test from the top of the tree. Each
+# of the shortcuts the schedulers take is checked against scheduling
+# the same trace the plain way, on traces made up to hit it. Writing
+# a timeline makes every scheduler go through each turn of the whole
+# trace, so with -t is the plain way unless said otherwise.
+#
+# Traces are made with awk from a fixed seed, so a failure can be
+# repeated. Prints each check that fails, with both outputs, and
+# exits with 1 if any did.
+#
+# ZLIB and ZSTD say which compressed traces the programs were built to
+# read, as in the Makefile, those that weren't are left out.
+
+dir=$(mktemp -d) || exit 1
+trap 'rm -rf "$dir"' EXIT
+trap 'exit 1' HUP INT TERM
+
+# A program that dies shows up as a failed check, not a dead script.
+trap '' PIPE
+
+checks=0
+failures=0
+
+# run program [options] trace
+#
+# Schedules the trace with the program, the results go to stdout.
+run() {
+  program=$1
+  shift
+  eval "trace=\${$#}"
+
+  # Everything but the trace is options.
+  options=
+  while [ $# -gt 1 ]; do
+    options="$options $1"
+    shift
+  done
+
+  printf '%s\nQUIT\n' "$trace" | ./$program $options
+}
+
+# same name first_output second_output
+#
+# Counts a check, which fails unless the outputs match.
+same() {
+  checks=$((checks + 1))
+
+  if [ "$2" != "$3" ]; then
+    failures=$((failures + 1))
+    printf 'FAIL %s\n--- expected\n%s\n--- got\n%s\n' "$1" "$2" "$3"
+  fi
+}
+
+# check name program [options] trace
+#
+# Schedules the trace with the options, and the plain way with a
+# timeline, and checks the results match.
+check() {
+  name=$1
+  program=$2
+  shift 2
+  same "$name" "$(run "$program" -t "$dir/timeline.csv" "$@")" \
+       "$(run "$program" "$@")"
+}
+
+# follow name program options trace
+#
+# Writes the trace out a few lines at a time, entering it again in
+# follow mode after each, and checks every result against loading the
+# whole of what's been written so far.
+follow() {
+  name=$1
+  program=$2
+  options=$3
+  trace=$4
+  followed="$dir/followed.txt"
+
+  rm -f "$dir/in" "$dir/out"
+  mkfifo "$dir/in" "$dir/out"
+
+  ./$program -f $options < "$dir/in" > "$dir/out" &
+  exec 3> "$dir/in" 4< "$dir/out"
+
+  head -n 1 "$trace" > "$followed"
+  total_lines=$(wc -l < "$trace")
+  line=2
+
+  while [ $line -le $total_lines ]; do
+    sed -n "$line,$((line + 36))p" "$trace" >> "$followed"
+    line=$((line + 37))
+
+    # Everything up to the last prompt is the result.
+    expected=$(run "$program" $options "$followed" | sed '$d')
+    result_lines=$(printf '%s\n' "$expected" | wc -l)
+
+    echo "$followed" >&3
+    result=
+    while [ $result_lines -gt 0 ]; do
+      IFS= read -r result_line <&4
+      result="$result${result:+
+}$result_line"
+      result_lines=$((result_lines - 1))
+    done
+
+    same "$name to line $((line - 1))" "$expected" "$result"
+  done
+
+  echo QUIT >&3
+  exec 3>&- 4<&-
+  wait
+}
+
+# make_trace file seed quantum shape count
+#
+# Writes a made up trace. The shapes are:
+#
+# together - Everything arrives at once, for the RR closed form.
+# periods - Bunches arriving together, some with idle gaps between
+#           and some running on into the next.
+# mixed - Arrivals anywhere, in any order, so the trace has to be
+#         sorted.
+# dense - Mostly one arriving each tick, with the odd two at once and
+#         the odd tick to spare, so thousands fit in the 9999 ticks a
+#         trace can have and the CPU still goes idle now and then.
+# shuffled - Four or five arriving each tick, but each up to 30 ticks
+#            away from its place, so it's out of order everywhere but
+#            never far enough to make sorting it slow.
+# repeated - Runs of copies of the same process, some a little out of
+#            order, with idle gaps between some of them.
+# scattered - Bunches arriving at a few times, with only a handful of
+#             bursts between them, so the same process turns up again
+#             and again among those arriving with it, but never next
+#             to itself in the file.
+# crowd - One long process, then the rest all arriving together just
+#         after it, each nearly as long, so the whole run is billions
+#         of ticks.
+#
+# Except in repeated, no process is the same as the one before it, so
+# none are grouped.
+make_trace() {
+  awk -v seed="$2" -v quantum="$3" -v shape="$4" -v count="$5" '
+    function burst(most) { return 1 + int(rand() * most) }
+    BEGIN {
+      srand(seed)
+      print quantum
+      time = 0
+
+      for (i = 0; i < count; i++) {
+        if (shape == "together") {
+          arrival = 5
+          size = burst(40)
+        } else if (shape == "periods") {
+          if (rand() < 0.2) {
+            time += int(rand() * 150)
+          }
+          arrival = time
+          size = burst(12)
+        } else if (shape == "dense") {
+          gap = rand()
+          time += (gap < 0.15) ? 0 : (gap < 0.45) ? 2 : 1
+          arrival = time
+          size = 1
+        } else if (shape == "shuffled") {
+          arrival = int(i / 4.2) + int(rand() * 30)
+          size = burst(3)
+        } else if (shape == "repeated") {
+          if (i == 0 || rand() > 0.7) {
+            if (rand() < 0.3) {
+              time += int(rand() * 60)
+            }
+            arrival = time + int(rand() * 10)
+            size = burst(15)
+          }
+        } else if (shape == "scattered") {
+          if (rand() < 0.05) {
+            time += int(rand() * 40)
+          }
+          arrival = time + int(rand() * 3)
+          size = burst(6)
+        } else if (shape == "crowd") {
+          arrival = (i == 0) ? 0 : 1
+          size = (i == 0) ? 9999 : 9000 + (i - 1) % 999
+        } else {
+          arrival = int(rand() * 400)
+          size = burst(20)
+        }
+
+        if (shape != "repeated" &&
+            arrival == last_arrival && size == last_size) {
+          ++size
+        }
+
+        print arrival, size
+        last_arrival = arrival
+        last_size = size
+      }
+    }' > "$1"
+}
+
+# Round robin's closed form for busy periods that arrive together, and
+# splitting the rest into busy periods, with and without costs.
+for seed in 1 2 3 4 5 6; do
+  quantum=$((seed % 4 + 1))
+
+  for shape in together periods mixed; do
+    make_trace "$dir/$shape.txt" "$seed" "$quantum" "$shape" 200
+
+    for costs in "" "-d 1" "-x 2" "-d 1 -x 1"; do
+      check "RR $shape seed $seed $costs" \
+            roundrobin -s $costs "$dir/$shape.txt"
+    done
+  done
+done
+
+# Follow mode, only scheduling what's been appended when it arrives
+# after everything else is done, and merging it in when it doesn't.
+for seed in 1 2 3; do
+  make_trace "$dir/periods.txt" "$seed" 2 periods 300
+  make_trace "$dir/mixed.txt" "$seed" 2 mixed 300
+
+  for program in sjf roundrobin; do
+    for costs in "" "-x 1"; do
+      follow "$program follow periods seed $seed $costs" \
+             "$program" "$costs" "$dir/periods.txt"
+      follow "$program follow mixed seed $seed $costs" \
+             "$program" "$costs" "$dir/mixed.txt"
+    done
+  done
+done
+
+# The result cache. Whatever comes from it has to match scheduling
+# afresh, so everything that changes the results has to be in the key,
+# and a copy of a trace under another name has to be found by its
+# contents.
+make_trace "$dir/cached.txt" 7 3 mixed 200
+sed '1s/.*/5/' "$dir/cached.txt" > "$dir/quantum.txt"
+cache="$dir/results.cache"
+rm -f "$cache"
+
+for program in sjf roundrobin priority stride lottery simulator; do
+  for options in "" "-d 1" "-x 2" "-a 3" "-r 5"; do
+    for trace in cached quantum; do
+      name="$program cache $trace $options"
+      fresh=$(run "$program" $options "$dir/$trace.txt")
+      cp "$dir/$trace.txt" "$dir/copy.txt"
+
+      same "$name" "$fresh" \
+           "$(run "$program" -c "$cache" $options "$dir/$trace.txt")"
+      entries=$(wc -l < "$cache")
+
+      same "$name again" "$fresh" \
+           "$(run "$program" -c "$cache" $options "$dir/$trace.txt")"
+      same "$name copy" "$fresh" \
+           "$(run "$program" -c "$cache" $options "$dir/copy.txt")"
+      same "$name from the cache" "$entries" "$(wc -l < "$cache")"
+    done
+  done
+done
+
+same "sjf cache predicted" "$(run sjf -e 50,5 "$dir/cached.txt")" \
+     "$(run sjf -c "$cache" -e 50,5 "$dir/cached.txt")"
+
+# A cache from another version isn't trusted, even with every result
+# in it wrong.
+awk 'NR == 1 { $4 = 0 } NR > 1 { $7 = "0x1p+20" } { print }' "$cache" \
+    > "$dir/old.cache"
+
+for program in sjf roundrobin simulator; do
+  same "$program cache from another version" \
+       "$(run "$program" "$dir/cached.txt")" \
+       "$(run "$program" -c "$dir/old.cache" "$dir/cached.txt")"
+done
+
+# Cutting a trace into busy periods with -j and scheduling them in
+# parallel, against scheduling it in one piece. Each piece has to be
+# at least 4096 processes, so the traces are big enough for two.
+for seed in 1 2; do
+  make_trace "$dir/dense.txt" "$seed" 3 dense 8400
+
+  for costs in "" "-d 1" "-x 1"; do
+    same "split seed $seed $costs" \
+         "$(run simulator $costs "$dir/dense.txt")" \
+         "$(run simulator -j 4 $costs "$dir/dense.txt")"
+  done
+done
+
+# Sorting a streamed trace that isn't in order, in runs written out to
+# files with -m 1, which holds 32768 processes a run, and all in memory
+# without it. Both against loading the trace and sorting it there,
+# without -t, as plain SJF on this many at once takes seconds.
+make_trace "$dir/shuffled.txt" 8 4 shuffled 40000
+
+for program in sjf roundrobin simulator; do
+  for costs in "" "-x 1"; do
+    loaded=$(run "$program" $costs "$dir/shuffled.txt")
+    same "$program sorted in memory $costs" "$loaded" \
+         "$(run "$program" -o $costs "$dir/shuffled.txt")"
+    same "$program sorted in runs $costs" "$loaded" \
+         "$(run "$program" -o -m 1 $costs "$dir/shuffled.txt")"
+  done
+done
+
+# scheduler_result tag
+#
+# Picks one scheduler's result out of the simulator's, the line tagged
+# with its name and the costs line after it, if there is one.
+scheduler_result() {
+  awk -v tag="$1" '
+    $1 == tag { print; found = 1; next }
+    found && /^Context switches/ { print }
+    { found = 0 }'
+}
+
+# Round robin at other quanta with -q, in the same pass as the rest of
+# the streamed run, against the trace with its own quantum changed.
+for seed in 1 2; do
+  make_trace "$dir/mixed.txt" "$seed" 4 mixed 2000
+  make_trace "$dir/periods.txt" "$seed" 4 periods 500
+
+  for shape in mixed periods; do
+    for costs in "" "-d 1" "-x 1"; do
+      fused=$(run simulator -o -q 2,5,7 $costs "$dir/$shape.txt")
+
+      for quantum in 2 5 7; do
+        sed "1s/.*/$quantum/" "$dir/$shape.txt" > "$dir/quantum.txt"
+        same "RR($quantum) $shape seed $seed $costs" \
+             "$(run simulator -t "$dir/timeline.csv" $costs \
+                    "$dir/quantum.txt" | scheduler_result 'RR:')" \
+             "$(printf '%s\n' "$fused" |
+                scheduler_result "RR($quantum):" | sed 's/^RR([0-9]*)/RR/')"
+      done
+    done
+  done
+done
+
+# Runs of the same process scheduled as one group, against scheduling
+# each process on its own.
+for seed in 1 2 3 4; do
+  make_trace "$dir/repeated.txt" "$seed" $((seed + 1)) repeated 1000
+
+  for program in sjf roundrobin simulator; do
+    for costs in "" "-d 1" "-x 2"; do
+      check "$program grouped seed $seed $costs" \
+            "$program" $costs "$dir/repeated.txt"
+    done
+  done
+done
+
+# Bad lines are warned about once, even when a streamed trace turns
+# out not to be sorted and is read again to sort it. The sorted dense
+# trace with bad lines in it, then the shuffled one, so some are found
+# before it turns out not to be sorted and some after.
+awk 'FNR == 1 && NR > 1 { next }
+     FNR > 1 && FNR % 50 == 0 { print $1, 0 }
+     { print }' "$dir/dense.txt" "$dir/shuffled.txt" > "$dir/bad.txt"
+
+for program in sjf roundrobin; do
+  for memory in "" "-m 1"; do
+    same "$program warnings sorted $memory" \
+         "$(run "$program" "$dir/bad.txt" 2>&1 > /dev/null)" \
+         "$(run "$program" -o $memory "$dir/bad.txt" 2>&1 > /dev/null)"
+  done
+done
+
+# Compressed traces, decompressed on a thread of their own as they're
+# read, against the same trace as it is. Loaded, where the whole file
+# is read ahead, and streamed, where it's read as it's scheduled. The
+# shuffled trace is several chunks compressed, and also made up of two
+# compressed halves one after the other, which is still one trace.
+# Entering a batch of them at once has them read ahead together.
+make_trace "$dir/small.txt" 9 3 mixed 200
+head -n 20001 "$dir/shuffled.txt" > "$dir/first.txt"
+tail -n +20002 "$dir/shuffled.txt" > "$dir/second.txt"
+
+for format in gzip zstd; do
+  if [ "$format" = gzip ]; then
+    built=${ZLIB:-0}
+  else
+    built=${ZSTD:-0}
+  fi
+
+  if [ "$built" != 1 ]; then
+    echo "$format traces not checked, not built to read them"
+    continue
+  fi
+
+  for trace in small shuffled first second; do
+    $format -q -c "$dir/$trace.txt" > "$dir/$trace.$format"
+  done
+
+  cat "$dir/first.$format" "$dir/second.$format" > "$dir/halves.$format"
+
+  for program in sjf roundrobin simulator; do
+    for streamed in "" "-o"; do
+      for trace in small shuffled; do
+        same "$program $format $trace $streamed" \
+             "$(run "$program" $streamed "$dir/$trace.txt")" \
+             "$(run "$program" $streamed "$dir/$trace.$format")"
+      done
+
+      same "$program $format halves $streamed" \
+           "$(run "$program" $streamed "$dir/shuffled.txt")" \
+           "$(run "$program" $streamed "$dir/halves.$format")"
+    done
+
+    same "$program $format batch" \
+         "$(printf '%s\n' "$dir/small.txt" "$dir/shuffled.txt" \
+                   "$dir/small.txt" QUIT | ./$program)" \
+         "$(printf '%s\n' "$dir/small.$format" "$dir/halves.$format" \
+                   "$dir/small.$format" QUIT | ./$program)"
+  done
+done
+
+# SJF groups the same process wherever it is among the others arriving
+# with it, round robin only where they're next to each other.
+for seed in 1 2 3; do
+  make_trace "$dir/scattered.txt" "$seed" 2 scattered 1000
+
+  for program in sjf roundrobin simulator; do
+    for costs in "" "-d 1" "-x 2"; do
+      check "$program scattered seed $seed $costs" \
+            "$program" $costs "$dir/scattered.txt"
+    done
+  done
+done
+
+# Passes round a queue too long for a pass to be timed in an int. Both
+# round robins skip the passes where nothing changes, loaded and
+# streamed, and plain round robin on this would take hours.
+make_trace "$dir/crowd.txt" 1 1 crowd 250001
+same "RR crowd" "$(run roundrobin "$dir/crowd.txt")" \
+     "$(run roundrobin -o "$dir/crowd.txt")"
+
+echo "$checks checks, $failures failed"
+
+[ "$failures" -eq 0 ]